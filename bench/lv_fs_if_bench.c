@@ -0,0 +1,513 @@
+/**
+ * @file lv_fs_if_bench.c
+ * Benchmark of the drivers registered by `lv_fs_if_init()` through the `lv_fs_*` API.
+ *
+ * Usage: lv_fs_if_bench [--json] <drive:dir> [<drive:dir> ...]
+ * E.g.   lv_fs_if_bench --json X:/tmp/bench P:/tmp/bench S:
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "lv_fs_if_bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*********************
+ *      DEFINES
+ *********************/
+#define SEQ_FILE_SIZE       (1024 * 1024)
+#define SEQ_CHUNK           (32 * 1024)
+#define SEQ_ROUNDS          4
+#define ROW_SIZE            480         /*A row of a 240 px wide RGB565 image*/
+#define RANDOM_CNT          2000
+#define RANDOM_READ         64
+#define CHURN_CNT           1000
+#define DIR_FILE_CNT        300
+#define DIR_ROUNDS          3
+#define WRITE_CNT           2000
+#define WRITE_SIZE          16
+#define TINY_READ           16          /*E.g. a glyph descriptor or a compressed run*/
+#define TINY_BATCH          64          /*Reads per measured operation as a single read is below the timer resolution*/
+#define MAX_SAMPLES         (SEQ_FILE_SIZE / ROW_SIZE + 16)
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+typedef struct {
+    const char * name;
+    uint32_t ops;           /*Number of measured operations*/
+    uint32_t op_calls;      /*API calls per operation*/
+    uint64_t bytes;         /*Bytes moved by the operations*/
+    uint64_t time_us;       /*Total time of the workload*/
+    uint32_t * lat;         /*Latency of each operation*/
+    int64_t syscalls;       /*read/write family system calls (Linux only, else -1)*/
+    int64_t disk_ios;       /*disk_read/disk_write calls of the FatFS RAM disk, else -1*/
+    int64_t disk_busy_us;   /*Time the simulated SD card was busy (LV_FS_IF_BENCH_SD only, else -1)*/
+    int64_t drv_calls;      /*Driver callback calls (LV_FS_IF_STATS only, else -1)*/
+} result_t;
+
+typedef void (*workload_cb_t)(const char * dir, result_t * r);
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+static void wl_seq_read(const char * dir, result_t * r);
+static void wl_small_read(const char * dir, result_t * r);
+static void wl_random_seek(const char * dir, result_t * r);
+static void wl_open_close(const char * dir, result_t * r);
+static void wl_dir_enum(const char * dir, result_t * r);
+static void wl_small_write(const char * dir, result_t * r);
+static void wl_tiny_read(const char * dir, result_t * r);
+#if LV_FS_IF_DIRECT
+static void wl_direct_read(const char * dir, result_t * r);
+#endif
+static void run(const char * dir, const char * name, workload_cb_t cb, bool json);
+static void create_file(const char * path, uint32_t size);
+static void sample(result_t * r, uint32_t t_start, uint32_t bytes);
+static uint32_t percentile(result_t * r, uint32_t percent);
+static int64_t syscall_cnt(void);
+static int64_t drv_call_cnt(char letter);
+static uint32_t rnd(void);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+static uint32_t rnd_state = 0x12345678;    /*Fixed seed for reproducible runs*/
+static int64_t syscall_overhead;            /*System calls made by `syscall_cnt()` itself*/
+static uint8_t buf[SEQ_CHUNK];
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+int main(int argc, char ** argv)
+{
+    bool json = false;
+    int first = 1;
+    if(argc > 1 && strcmp(argv[1], "--json") == 0) {
+        json = true;
+        first = 2;
+    }
+
+    if(first >= argc) {
+        fprintf(stderr, "Usage: %s [--json] <drive:dir> [<drive:dir> ...]\n", argv[0]);
+        return 1;
+    }
+
+    lv_init();
+
+#if LV_FS_IF_FATFS != '\0'
+    if(lv_fs_if_bench_ramdisk_mount(LV_FS_IF_BENCH_RAMDISK_SIZE) != 0) {
+        fprintf(stderr, "Couldn't create the FatFS RAM disk\n");
+        return 1;
+    }
+#endif
+
+    lv_fs_if_init();
+
+    int64_t sys = syscall_cnt();
+    if(sys >= 0) syscall_overhead = syscall_cnt() - sys;
+
+    if(!json) {
+        printf("%-6s %-13s %8s %10s %9s %8s %8s %8s %9s %9s\n",
+               "drive", "workload", "ops", "MB/s", "ops/s", "ns/call", "p50 us", "p99 us", "syscalls", "disk I/O");
+    }
+
+    int i;
+    for(i = first; i < argc; i++) {
+        const char * dir = argv[i];
+        run(dir, "seq_read", wl_seq_read, json);
+        run(dir, "small_read", wl_small_read, json);
+        run(dir, "random_seek", wl_random_seek, json);
+        run(dir, "open_close", wl_open_close, json);
+        run(dir, "dir_enum", wl_dir_enum, json);
+        run(dir, "small_write", wl_small_write, json);
+        run(dir, "tiny_read", wl_tiny_read, json);
+#if LV_FS_IF_DIRECT
+        if(dir[0] == LV_FS_IF_DIRECT_LETTER) run(dir, "direct_read", wl_direct_read, json);
+#endif
+    }
+
+    return 0;
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+/**
+ * Run a workload and print its result
+ */
+static void run(const char * dir, const char * name, workload_cb_t cb, bool json)
+{
+    result_t r;
+    memset(&r, 0, sizeof(r));
+    r.name = name;
+    r.op_calls = 1;
+    r.lat = malloc(MAX_SAMPLES * sizeof(uint32_t));
+
+    int64_t sys_start = syscall_cnt();
+    int64_t drv_start = drv_call_cnt(dir[0]);
+#if LV_FS_IF_FATFS != '\0'
+    uint32_t disk_start = lv_fs_if_bench_ramdisk_io_cnt();
+#if LV_FS_IF_BENCH_SD
+    uint64_t busy_start = lv_fs_if_bench_ramdisk_busy_us();
+#endif
+#endif
+
+    cb(dir, &r);
+
+    r.syscalls = sys_start >= 0 ? syscall_cnt() - sys_start - syscall_overhead : -1;
+    r.drv_calls = drv_start >= 0 ? drv_call_cnt(dir[0]) - drv_start : -1;
+    r.disk_ios = -1;
+    r.disk_busy_us = -1;
+#if LV_FS_IF_FATFS != '\0'
+    if(dir[0] == LV_FS_IF_FATFS) r.disk_ios = lv_fs_if_bench_ramdisk_io_cnt() - disk_start;
+#if LV_FS_IF_BENCH_SD
+    if(dir[0] == LV_FS_IF_FATFS) r.disk_busy_us = lv_fs_if_bench_ramdisk_busy_us() - busy_start;
+#endif
+#endif
+
+    double sec = r.time_us ? r.time_us / 1000000.0 : 1e-6;
+    double mbps = r.bytes / sec / (1024 * 1024);
+    double opss = r.ops / sec;
+    double ns_call = r.ops ? r.time_us * 1000.0 / ((double)r.ops * r.op_calls) : 0;
+    uint32_t p50 = percentile(&r, 50);
+    uint32_t p99 = percentile(&r, 99);
+
+    if(json) {
+        printf("{\"drive\":\"%c\",\"workload\":\"%s\",\"ops\":%u,\"bytes\":%llu,\"time_us\":%llu,"
+               "\"mb_per_s\":%.2f,\"ops_per_s\":%.1f,\"ns_per_call\":%.1f,\"p50_us\":%u,\"p99_us\":%u,"
+               "\"syscalls\":%lld,\"disk_ios\":%lld,\"disk_busy_us\":%lld,\"driver_calls\":%lld}\n",
+               dir[0], r.name, (unsigned)r.ops, (unsigned long long)r.bytes, (unsigned long long)r.time_us,
+               mbps, opss, ns_call, (unsigned)p50, (unsigned)p99,
+               (long long)r.syscalls, (long long)r.disk_ios, (long long)r.disk_busy_us, (long long)r.drv_calls);
+    }
+    else {
+        printf("%-6c %-13s %8u %10.2f %9.0f %8.1f %8u %8u %9lld %9lld\n",
+               dir[0], r.name, (unsigned)r.ops, mbps, opss, ns_call, (unsigned)p50, (unsigned)p99,
+               (long long)r.syscalls, (long long)r.disk_ios);
+    }
+
+    free(r.lat);
+}
+
+/**
+ * Large sequential reads of a 1 MB file
+ */
+static void wl_seq_read(const char * dir, result_t * r)
+{
+    char path[256];
+    lv_snprintf(path, sizeof(path), "%s/seq.bin", dir);
+    create_file(path, SEQ_FILE_SIZE);
+
+    uint32_t t_all = lv_fs_if_time_us();
+    uint32_t i;
+    for(i = 0; i < SEQ_ROUNDS; i++) {
+        lv_fs_file_t f;
+        if(lv_fs_open(&f, path, LV_FS_MODE_RD) != LV_FS_RES_OK) return;
+
+        while(1) {
+            uint32_t br = 0;
+            uint32_t t = lv_fs_if_time_us();
+            lv_fs_read(&f, buf, SEQ_CHUNK, &br);
+            if(br == 0) break;
+            sample(r, t, br);
+        }
+        lv_fs_close(&f);
+    }
+    r->time_us = lv_fs_if_time_us() - t_all;
+}
+
+/**
+ * Decoder like reads: a small header and then the rows of an image
+ */
+static void wl_small_read(const char * dir, result_t * r)
+{
+    char path[256];
+    lv_snprintf(path, sizeof(path), "%s/seq.bin", dir);
+
+    uint32_t t_all = lv_fs_if_time_us();
+    lv_fs_file_t f;
+    if(lv_fs_open(&f, path, LV_FS_MODE_RD) != LV_FS_RES_OK) return;
+
+    uint32_t br;
+    uint32_t t = lv_fs_if_time_us();
+    lv_fs_read(&f, buf, 4, &br);
+    sample(r, t, br);
+
+    while(1) {
+        t = lv_fs_if_time_us();
+        lv_fs_read(&f, buf, ROW_SIZE, &br);
+        if(br == 0) break;
+        sample(r, t, br);
+    }
+
+    lv_fs_close(&f);
+    r->time_us = lv_fs_if_time_us() - t_all;
+}
+
+/**
+ * Seek to random positions and read a few bytes (e.g. glyphs of a font)
+ */
+static void wl_random_seek(const char * dir, result_t * r)
+{
+    char path[256];
+    lv_snprintf(path, sizeof(path), "%s/seq.bin", dir);
+
+    uint32_t t_all = lv_fs_if_time_us();
+    lv_fs_file_t f;
+    if(lv_fs_open(&f, path, LV_FS_MODE_RD) != LV_FS_RES_OK) return;
+
+    uint32_t i;
+    for(i = 0; i < RANDOM_CNT; i++) {
+        uint32_t pos = (rnd() % (SEQ_FILE_SIZE - RANDOM_READ)) & ~0xFU;
+        uint32_t br = 0;
+        uint32_t t = lv_fs_if_time_us();
+        lv_fs_seek(&f, pos, LV_FS_SEEK_SET);
+        lv_fs_read(&f, buf, RANDOM_READ, &br);
+        sample(r, t, br);
+    }
+
+    lv_fs_close(&f);
+    r->time_us = lv_fs_if_time_us() - t_all;
+}
+
+/**
+ * Open a file, read its header and close it again
+ */
+static void wl_open_close(const char * dir, result_t * r)
+{
+    char path[256];
+    lv_snprintf(path, sizeof(path), "%s/seq.bin", dir);
+
+    uint32_t t_all = lv_fs_if_time_us();
+    uint32_t i;
+    for(i = 0; i < CHURN_CNT; i++) {
+        lv_fs_file_t f;
+        uint32_t br = 0;
+        uint32_t t = lv_fs_if_time_us();
+        if(lv_fs_open(&f, path, LV_FS_MODE_RD) != LV_FS_RES_OK) break;
+        lv_fs_read(&f, buf, 16, &br);
+        lv_fs_close(&f);
+        sample(r, t, br);
+    }
+    r->time_us = lv_fs_if_time_us() - t_all;
+}
+
+/**
+ * List a directory with many files
+ */
+static void wl_dir_enum(const char * dir, result_t * r)
+{
+    char path[256];
+    uint32_t i;
+    for(i = 0; i < DIR_FILE_CNT; i++) {
+        lv_snprintf(path, sizeof(path), "%s/d%03u.bin", dir, (unsigned)i);
+        create_file(path, 16);
+    }
+
+    /*"S:" -> "S:/" to list the root*/
+    lv_snprintf(path, sizeof(path), "%s%s", dir, dir[2] == '\0' ? "/" : "");
+
+    uint32_t t_all = lv_fs_if_time_us();
+    for(i = 0; i < DIR_ROUNDS; i++) {
+        lv_fs_dir_t d;
+        if(lv_fs_dir_open(&d, path) != LV_FS_RES_OK) return;
+
+        while(1) {
+            char fn[LV_FS_IF_DIRENT_NAME_MAX + 1];     /*Directories get a '/' prefix*/
+            uint32_t t = lv_fs_if_time_us();
+            lv_fs_res_t res = lv_fs_dir_read(&d, fn);
+            if(res != LV_FS_RES_OK || fn[0] == '\0') break;
+            sample(r, t, 0);
+        }
+        lv_fs_dir_close(&d);
+    }
+    r->time_us = lv_fs_if_time_us() - t_all;
+}
+
+/**
+ * Many small writes, e.g. settings or logs
+ */
+static void wl_small_write(const char * dir, result_t * r)
+{
+    char path[256];
+    lv_snprintf(path, sizeof(path), "%s/wr.bin", dir);
+    memset(buf, 0xA5, WRITE_SIZE);
+
+    uint32_t t_all = lv_fs_if_time_us();
+    lv_fs_file_t f;
+    if(lv_fs_open(&f, path, LV_FS_MODE_WR) != LV_FS_RES_OK) return;
+
+    uint32_t i;
+    for(i = 0; i < WRITE_CNT; i++) {
+        uint32_t bw = 0;
+        uint32_t t = lv_fs_if_time_us();
+        lv_fs_write(&f, buf, WRITE_SIZE, &bw);
+        sample(r, t, bw);
+    }
+
+    lv_fs_close(&f);
+    r->time_us = lv_fs_if_time_us() - t_all;
+}
+
+/**
+ * Read a file in tiny chunks through `lv_fs_read()`, the baseline of `direct_read`
+ */
+static void wl_tiny_read(const char * dir, result_t * r)
+{
+    char path[256];
+    lv_snprintf(path, sizeof(path), "%s/seq.bin", dir);
+
+    lv_fs_file_t f;
+    if(lv_fs_open(&f, path, LV_FS_MODE_RD) != LV_FS_RES_OK) return;
+
+    r->op_calls = TINY_BATCH;
+    uint32_t t_all = lv_fs_if_time_us();
+    uint32_t bytes;
+    do {
+        uint32_t t = lv_fs_if_time_us();
+        bytes = 0;
+        uint32_t i;
+        for(i = 0; i < TINY_BATCH; i++) {
+            uint32_t br = 0;
+            lv_fs_read(&f, buf, TINY_READ, &br);
+            bytes += br;
+        }
+        sample(r, t, bytes);
+    } while(bytes == TINY_BATCH * TINY_READ);
+
+    r->time_us = lv_fs_if_time_us() - t_all;
+    lv_fs_close(&f);
+}
+
+#if LV_FS_IF_DIRECT
+/**
+ * The same as `tiny_read` with `lv_fs_if_direct_read()`. The difference of their ns/call is the saved dispatch.
+ */
+static void wl_direct_read(const char * dir, result_t * r)
+{
+    char path[256];
+    lv_snprintf(path, sizeof(path), "%s/seq.bin", dir);
+
+    lv_fs_file_t f;
+    if(lv_fs_open(&f, path, LV_FS_MODE_RD) != LV_FS_RES_OK) return;
+
+    r->op_calls = TINY_BATCH;
+    uint32_t t_all = lv_fs_if_time_us();
+    uint32_t bytes;
+    do {
+        uint32_t t = lv_fs_if_time_us();
+        bytes = 0;
+        uint32_t i;
+        for(i = 0; i < TINY_BATCH; i++) {
+            uint32_t br = 0;
+            lv_fs_if_direct_read(&f, buf, TINY_READ, &br);
+            bytes += br;
+        }
+        sample(r, t, bytes);
+    } while(bytes == TINY_BATCH * TINY_READ);
+
+    r->time_us = lv_fs_if_time_us() - t_all;
+    lv_fs_close(&f);
+}
+#endif
+
+/**
+ * Create a file with pseudo random content through the driver
+ */
+static void create_file(const char * path, uint32_t size)
+{
+    lv_fs_file_t f;
+    if(lv_fs_open(&f, path, LV_FS_MODE_WR) != LV_FS_RES_OK) {
+        fprintf(stderr, "Couldn't create %s\n", path);
+        return;
+    }
+
+    uint32_t i;
+    for(i = 0; i < SEQ_CHUNK; i++) buf[i] = rnd();
+
+    while(size) {
+        uint32_t n = size < SEQ_CHUNK ? size : SEQ_CHUNK;
+        uint32_t bw = 0;
+        lv_fs_write(&f, buf, n, &bw);
+        if(bw == 0) break;
+        size -= bw;
+    }
+    lv_fs_close(&f);
+}
+
+static void sample(result_t * r, uint32_t t_start, uint32_t bytes)
+{
+    if(r->ops < MAX_SAMPLES) r->lat[r->ops] = lv_fs_if_time_us() - t_start;
+    r->ops++;
+    r->bytes += bytes;
+}
+
+static int cmp_u32(const void * a, const void * b)
+{
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static uint32_t percentile(result_t * r, uint32_t percent)
+{
+    uint32_t n = r->ops < MAX_SAMPLES ? r->ops : MAX_SAMPLES;
+    if(n == 0) return 0;
+
+    qsort(r->lat, n, sizeof(uint32_t), cmp_u32);
+    uint32_t idx = (n * percent + 99) / 100;
+    return r->lat[idx ? idx - 1 : 0];
+}
+
+/**
+ * Get the number of read and write family system calls of the process from /proc/self/io
+ * @return the number of system calls or -1 if not available
+ */
+static int64_t syscall_cnt(void)
+{
+    FILE * f = fopen("/proc/self/io", "r");
+    if(f == NULL) return -1;
+
+    char line[64];
+    long long syscr = -1;
+    long long syscw = -1;
+    while(fgets(line, sizeof(line), f)) {
+        sscanf(line, "syscr: %lld", &syscr);
+        sscanf(line, "syscw: %lld", &syscw);
+    }
+    fclose(f);
+
+    return (syscr < 0 || syscw < 0) ? -1 : syscr + syscw;
+}
+
+static int64_t drv_call_cnt(char letter)
+{
+#if LV_FS_IF_STATS
+    const lv_fs_if_stats_t * s = lv_fs_if_stats_get(letter);
+    if(s == NULL) return -1;
+
+    int64_t sum = 0;
+    uint32_t op;
+    for(op = 0; op < _LV_FS_IF_OP_LAST; op++) sum += s->cnt[op];
+    return sum;
+#else
+    (void) letter;  /*Unused*/
+    return -1;
+#endif
+}
+
+/**
+ * xorshift32 to get the same "random" sequence on every run
+ */
+static uint32_t rnd(void)
+{
+    rnd_state ^= rnd_state << 13;
+    rnd_state ^= rnd_state >> 17;
+    rnd_state ^= rnd_state << 5;
+    return rnd_state;
+}
@@ -0,0 +1,96 @@
+/**
+ * @file lv_fs_if_bench.h
+ *
+ */
+
+#ifndef LV_FS_IF_BENCH_H
+#define LV_FS_IF_BENCH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "../lv_fs_if.h"
+
+#if LV_FS_IF_FATFS != '\0'
+#include "ff.h"
+#endif
+
+/*********************
+ *      DEFINES
+ *********************/
+/*Size of the FatFS RAM disk*/
+#ifndef LV_FS_IF_BENCH_RAMDISK_SIZE
+# define LV_FS_IF_BENCH_RAMDISK_SIZE    (8 * 1024 * 1024)
+#endif
+
+/*Path of a disk image file to use instead of RAM, e.g. "sd.img". It's formatted if it's empty or has no FAT.
+ *Not defined: use a RAM buffer*/
+/*#define LV_FS_IF_BENCH_DISK_IMAGE     "sd.img"*/
+
+/*Simulate the timing of an SD card on the disk (FatFS only)*/
+#ifndef LV_FS_IF_BENCH_SD
+# define LV_FS_IF_BENCH_SD              0
+#endif
+
+/*Overhead of a read, write or sync command in microseconds*/
+#ifndef LV_FS_IF_BENCH_SD_CMD_US
+# define LV_FS_IF_BENCH_SD_CMD_US       100
+#endif
+
+/*Read and write throughput of the sectors in kB/s*/
+#ifndef LV_FS_IF_BENCH_SD_READ_KBPS
+# define LV_FS_IF_BENCH_SD_READ_KBPS    10000
+#endif
+
+#ifndef LV_FS_IF_BENCH_SD_WRITE_KBPS
+# define LV_FS_IF_BENCH_SD_WRITE_KBPS   5000
+#endif
+
+/*Size of an erase block in sectors. Writing into a block which is not open costs `LV_FS_IF_BENCH_SD_ERASE_US`*/
+#ifndef LV_FS_IF_BENCH_SD_ERASE_BLOCK
+# define LV_FS_IF_BENCH_SD_ERASE_BLOCK  128
+#endif
+
+#ifndef LV_FS_IF_BENCH_SD_ERASE_US
+# define LV_FS_IF_BENCH_SD_ERASE_US     3000
+#endif
+
+/*Number of erase blocks the card keeps open for writing (the least recently written one is closed)*/
+#ifndef LV_FS_IF_BENCH_SD_OPEN_BLOCKS
+# define LV_FS_IF_BENCH_SD_OPEN_BLOCKS  2
+#endif
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+#if LV_FS_IF_FATFS != '\0'
+/**
+ * Create a RAM disk (or open `LV_FS_IF_BENCH_DISK_IMAGE`), format it if needed and mount it as the default FatFS volume
+ * @param size size of the disk in bytes (for a new image too)
+ * @return 0 on success
+ */
+int lv_fs_if_bench_ramdisk_mount(uint32_t size);
+
+/**
+ * Get the number of disk_read and disk_write calls
+ * @return the number of calls
+ */
+uint32_t lv_fs_if_bench_ramdisk_io_cnt(void);
+
+/**
+ * Get the total time the simulated SD card was busy
+ * @return the time in microseconds (0 without `LV_FS_IF_BENCH_SD`)
+ */
+uint64_t lv_fs_if_bench_ramdisk_busy_us(void);
+#endif
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /*LV_FS_IF_BENCH_H*/
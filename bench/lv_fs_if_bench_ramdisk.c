@@ -0,0 +1,288 @@
+/**
+ * @file lv_fs_if_bench_ramdisk.c
+ * FatFS disk I/O layer backed by a RAM buffer or a disk image, so the FATFS driver can be benchmarked without hardware.
+ * With `LV_FS_IF_BENCH_SD` the calls take as long as on an SD card.
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "lv_fs_if_bench.h"
+
+#if LV_FS_IF_FATFS != '\0'
+#include <stdlib.h>
+#include <string.h>
+#include "diskio.h"
+#ifdef LV_FS_IF_BENCH_DISK_IMAGE
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#if LV_FS_IF_BENCH_SD
+#include <time.h>
+#endif
+
+/*********************
+ *      DEFINES
+ *********************/
+#define SECTOR_SIZE     512
+#define SLEEP_MARGIN_US 100     /*Sleep until this much before the end of a delay and spin the rest*/
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+static bool disk_ready(void);
+#if LV_FS_IF_BENCH_SD
+static void sd_cmd(uint32_t cnt, uint32_t kbps);
+static void sd_erase(LBA_t sector, UINT count);
+static void sd_wait(uint32_t us);
+static uint64_t now_us(void);
+#endif
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+#ifdef LV_FS_IF_BENCH_DISK_IMAGE
+static int disk_fd = -1;
+#else
+static uint8_t * disk;
+#endif
+static uint32_t sector_cnt;
+static uint32_t io_cnt;
+static FATFS fatfs;
+
+#if LV_FS_IF_BENCH_SD
+static bool sd_on;              /*Not while formatting and mounting*/
+static uint64_t sd_busy_us;
+static uint32_t open_blocks[LV_FS_IF_BENCH_SD_OPEN_BLOCKS];    /*Erase block + 1, most recently written first*/
+#endif
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+/**
+ * Create a RAM disk, format it and mount it as the default FatFS volume
+ * @param size size of the disk in bytes
+ * @return 0 on success
+ */
+int lv_fs_if_bench_ramdisk_mount(uint32_t size)
+{
+#ifdef LV_FS_IF_BENCH_DISK_IMAGE
+    disk_fd = open(LV_FS_IF_BENCH_DISK_IMAGE, O_RDWR | O_CREAT, 0644);
+    if(disk_fd < 0) return -1;
+
+    off_t len = lseek(disk_fd, 0, SEEK_END);
+    if(len < SECTOR_SIZE) {
+        if(ftruncate(disk_fd, size) != 0) return -1;
+        len = size;
+    }
+    sector_cnt = len / SECTOR_SIZE;
+#else
+    sector_cnt = size / SECTOR_SIZE;
+    disk = calloc(sector_cnt, SECTOR_SIZE);
+    if(disk == NULL) return -1;
+#endif
+
+    /*Keep the files of an image, format a new one*/
+    if(f_mount(&fatfs, "", 1) != FR_OK) {
+        static BYTE work[FF_MAX_SS];
+        MKFS_PARM opt = {FM_ANY, 0, 0, 0, 0};
+        if(f_mkfs("", &opt, work, sizeof(work)) != FR_OK) return -1;
+        if(f_mount(&fatfs, "", 1) != FR_OK) return -1;
+    }
+
+    io_cnt = 0;
+#if LV_FS_IF_BENCH_SD
+    sd_on = true;
+#endif
+    return 0;
+}
+
+/**
+ * Get the number of disk_read and disk_write calls
+ * @return the number of calls
+ */
+uint32_t lv_fs_if_bench_ramdisk_io_cnt(void)
+{
+    return io_cnt;
+}
+
+/**
+ * Get the total time the simulated SD card was busy
+ * @return the time in microseconds (0 without `LV_FS_IF_BENCH_SD`)
+ */
+uint64_t lv_fs_if_bench_ramdisk_busy_us(void)
+{
+#if LV_FS_IF_BENCH_SD
+    return sd_busy_us;
+#else
+    return 0;
+#endif
+}
+
+/*-----------------------
+ * FatFS disk I/O layer
+ *----------------------*/
+
+DSTATUS disk_status(BYTE pdrv)
+{
+    return (pdrv == 0 && disk_ready()) ? 0 : STA_NOINIT;
+}
+
+DSTATUS disk_initialize(BYTE pdrv)
+{
+    return disk_status(pdrv);
+}
+
+DRESULT disk_read(BYTE pdrv, BYTE * buff, LBA_t sector, UINT count)
+{
+    if(pdrv != 0 || !disk_ready()) return RES_NOTRDY;
+    if(sector + count > sector_cnt) return RES_PARERR;
+
+    io_cnt++;
+#ifdef LV_FS_IF_BENCH_DISK_IMAGE
+    size_t len = (size_t)count * SECTOR_SIZE;
+    if(pread(disk_fd, buff, len, (off_t)sector * SECTOR_SIZE) != (ssize_t)len) return RES_ERROR;
+#else
+    memcpy(buff, disk + (size_t)sector * SECTOR_SIZE, (size_t)count * SECTOR_SIZE);
+#endif
+
+#if LV_FS_IF_BENCH_SD
+    sd_cmd(count, LV_FS_IF_BENCH_SD_READ_KBPS);
+#endif
+    return RES_OK;
+}
+
+DRESULT disk_write(BYTE pdrv, const BYTE * buff, LBA_t sector, UINT count)
+{
+    if(pdrv != 0 || !disk_ready()) return RES_NOTRDY;
+    if(sector + count > sector_cnt) return RES_PARERR;
+
+    io_cnt++;
+#ifdef LV_FS_IF_BENCH_DISK_IMAGE
+    size_t len = (size_t)count * SECTOR_SIZE;
+    if(pwrite(disk_fd, buff, len, (off_t)sector * SECTOR_SIZE) != (ssize_t)len) return RES_ERROR;
+#else
+    memcpy(disk + (size_t)sector * SECTOR_SIZE, buff, (size_t)count * SECTOR_SIZE);
+#endif
+
+#if LV_FS_IF_BENCH_SD
+    sd_erase(sector, count);
+    sd_cmd(count, LV_FS_IF_BENCH_SD_WRITE_KBPS);
+#endif
+    return RES_OK;
+}
+
+DRESULT disk_ioctl(BYTE pdrv, BYTE cmd, void * buff)
+{
+    if(pdrv != 0 || !disk_ready()) return RES_NOTRDY;
+
+    switch(cmd) {
+        case CTRL_SYNC:
+#if LV_FS_IF_BENCH_SD
+            sd_cmd(0, 0);
+#endif
+            return RES_OK;
+        case GET_SECTOR_COUNT:
+            *(LBA_t *)buff = sector_cnt;
+            return RES_OK;
+        case GET_SECTOR_SIZE:
+            *(WORD *)buff = SECTOR_SIZE;
+            return RES_OK;
+        case GET_BLOCK_SIZE:
+#if LV_FS_IF_BENCH_SD
+            *(DWORD *)buff = LV_FS_IF_BENCH_SD_ERASE_BLOCK;
+#else
+            *(DWORD *)buff = 1;
+#endif
+            return RES_OK;
+        default:
+            return RES_PARERR;
+    }
+}
+
+DWORD get_fattime(void)
+{
+    /*2024-01-01 00:00:00 to keep the images reproducible*/
+    return ((DWORD)(2024 - 1980) << 25) | ((DWORD)1 << 21) | ((DWORD)1 << 16);
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+static bool disk_ready(void)
+{
+#ifdef LV_FS_IF_BENCH_DISK_IMAGE
+    return disk_fd >= 0;
+#else
+    return disk != NULL;
+#endif
+}
+
+#if LV_FS_IF_BENCH_SD
+/**
+ * Wait as long as a command of the card
+ * @param cnt number of transferred sectors
+ * @param kbps throughput of the transfer in kB/s
+ */
+static void sd_cmd(uint32_t cnt, uint32_t kbps)
+{
+    if(!sd_on) return;
+
+    uint64_t us = LV_FS_IF_BENCH_SD_CMD_US;
+    if(kbps) us += (uint64_t)cnt * SECTOR_SIZE * 1000000 / (kbps * 1024ULL);
+    sd_wait(us);
+}
+
+/**
+ * Add the penalty of the erase blocks a write opens. The card keeps a few blocks open and
+ * writing into an other one makes it copy and erase a whole block.
+ * @param sector first written sector
+ * @param count number of written sectors
+ */
+static void sd_erase(LBA_t sector, UINT count)
+{
+    if(!sd_on || LV_FS_IF_BENCH_SD_ERASE_BLOCK == 0) return;
+
+    uint32_t first = sector / LV_FS_IF_BENCH_SD_ERASE_BLOCK;
+    uint32_t last = (sector + count - 1) / LV_FS_IF_BENCH_SD_ERASE_BLOCK;
+    uint32_t b;
+    for(b = first; b <= last; b++) {
+        uint32_t i;
+        for(i = 0; i < LV_FS_IF_BENCH_SD_OPEN_BLOCKS - 1 && open_blocks[i] != b + 1; i++);
+
+        if(open_blocks[i] != b + 1) sd_wait(LV_FS_IF_BENCH_SD_ERASE_US);
+
+        /*Move it to the front, the last one is closed*/
+        for(; i > 0; i--) open_blocks[i] = open_blocks[i - 1];
+        open_blocks[0] = b + 1;
+    }
+}
+
+/**
+ * Wait for the given time precisely: sleep most of it and spin the rest
+ * @param us time in microseconds
+ */
+static void sd_wait(uint32_t us)
+{
+    sd_busy_us += us;
+
+    uint64_t end = now_us() + us;
+    if(us > 2 * SLEEP_MARGIN_US) {
+        uint32_t sleep_us = us - SLEEP_MARGIN_US;
+        struct timespec ts = {sleep_us / 1000000, (sleep_us % 1000000) * 1000};
+        nanosleep(&ts, NULL);
+    }
+    while(now_us() < end);
+}
+
+static uint64_t now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+#endif
+
+#endif /*LV_FS_IF_FATFS*/
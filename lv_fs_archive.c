@@ -0,0 +1,723 @@
+/**
+ * @file lv_fs_archive.c
+ *
+ */
+
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "lv_fs_if.h"
+#if LV_USE_FS_IF
+#if LV_FS_IF_ARCHIVE != '\0'
+
+#include <string.h>
+
+/*********************
+ *      DEFINES
+ *********************/
+/*If defined (e.g. "S:/assets.bin") the archive is mounted on the first open*/
+/*#define LV_FS_ARCHIVE_FILE   "S:/assets.bin"*/
+
+/*Support the files compressed with `--lz4` by the packing tool*/
+#ifndef LV_FS_ARCHIVE_LZ4
+# define LV_FS_ARCHIVE_LZ4              0
+#endif
+
+/*Max. block size of the compressed files. It's the size of a buffer in the block cache*/
+#ifndef LV_FS_ARCHIVE_LZ4_BLOCK_SIZE
+# define LV_FS_ARCHIVE_LZ4_BLOCK_SIZE   4096
+#endif
+
+/*Number of decompressed blocks kept in the memory*/
+#ifndef LV_FS_ARCHIVE_LZ4_CACHE_CNT
+# define LV_FS_ARCHIVE_LZ4_CACHE_CNT    2
+#endif
+
+#define ARCH_VERSION    1
+#define ARCH_EMPTY      0xFFFFFFFF
+
+/*The content is split into LZ4 compressed blocks. At `data_ofs` there is the block size
+ *and `block_cnt + 1` offsets of the blocks in the archive. A block not smaller than its
+ *decompressed size is stored as it is.*/
+#define ARCH_FLAG_LZ4   0x1
+
+/*The index and the block offsets are used in place (also from a mapped archive), so they are
+ *accessed as native integers*/
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+# error "lv_fs_archive: the fields of the archive are little endian, big endian targets are not supported"
+#endif
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+/*The archive is created by tools/lv_fs_archive.py. All fields are little endian.*/
+typedef struct {
+    uint8_t magic[4];       /*"LVFA"*/
+    uint16_t version;
+    uint16_t reserved;
+    uint32_t entry_cnt;
+    uint32_t bucket_cnt;    /*Power of 2*/
+    uint32_t bucket_ofs;    /*Offset of the hash table: `bucket_cnt` entry indices*/
+    uint32_t entry_ofs;     /*Offset of the `entry_cnt` entries*/
+} arch_header_t;
+
+typedef struct {
+    uint32_t hash;          /*FNV-1a hash of the name*/
+    uint32_t name_ofs;      /*Offset of the '\0' terminated path without the leading '/'*/
+    uint32_t data_ofs;
+    uint32_t size;
+    uint32_t flags;         /*ARCH_FLAG_...*/
+} arch_entry_t;
+
+typedef struct {
+    const arch_entry_t * e;
+    uint32_t pos;
+#if LV_FS_ARCHIVE_LZ4
+    uint32_t block_size;    /*Size of the decompressed blocks. 0 if the file is not compressed*/
+#endif
+} arch_file_t;
+
+#if LV_FS_ARCHIVE_LZ4
+typedef struct {
+    uint32_t data_ofs;      /*Identifies the file. 0 if the entry is unused*/
+    uint32_t block;
+    uint32_t last_use;      /*For LRU eviction*/
+    uint8_t buf[LV_FS_ARCHIVE_LZ4_BLOCK_SIZE];
+} block_cache_t;
+#endif
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+static void * fs_open (lv_fs_drv_t * drv, const char * path, lv_fs_mode_t mode);
+static lv_fs_res_t fs_close (lv_fs_drv_t * drv, void * file_p);
+static lv_fs_res_t fs_read (lv_fs_drv_t * drv, void * file_p, void * buf, uint32_t btr, uint32_t * br);
+static lv_fs_res_t fs_seek (lv_fs_drv_t * drv, void * file_p, uint32_t pos, lv_fs_whence_t whence);
+static lv_fs_res_t fs_tell (lv_fs_drv_t * drv, void * file_p, uint32_t * pos_p);
+static lv_fs_res_t fs_map(lv_fs_drv_t * drv, const char * path, const void ** ptr, uint32_t * size, void ** map_d);
+static const arch_entry_t * entry_find(const char * path);
+static bool entry_name_eq(const arch_entry_t * e, const char * path);
+static lv_fs_res_t arch_read(uint32_t ofs, void * buf, uint32_t len);
+static lv_fs_res_t arch_load_index(void);
+static lv_fs_res_t arch_check_buckets(void);
+static uint32_t path_hash(const char * path);
+#if LV_FS_ARCHIVE_LZ4
+static lv_fs_res_t read_lz4(arch_file_t * fp, uint8_t * buf, uint32_t btr);
+static lv_fs_res_t block_load(arch_file_t * fp, uint32_t block, uint8_t * dst, uint32_t len);
+static int32_t lz4_decompress(const uint8_t * src, uint32_t src_len, uint8_t * dst, uint32_t dst_len);
+#endif
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+LV_FS_IF_POOL_DEF(file_pool, arch_file_t, LV_FS_IF_FILE_POOL_SIZE);
+
+static bool arch_mounted;
+static lv_fs_file_t arch_file;          /*The open container if it's not mapped*/
+static uint32_t arch_pos;               /*Position of `arch_file` to avoid needless seeks*/
+static const uint8_t * arch_map;        /*Content of the container if its driver can map it*/
+static uint32_t arch_map_size;
+static void * arch_map_d;
+static lv_fs_drv_t * arch_map_drv;
+static arch_header_t arch_hdr;
+static const uint32_t * arch_buckets;
+static const arch_entry_t * arch_entries;
+static void * arch_index_buf;           /*The buckets and entries read into the memory if not mapped*/
+#if LV_FS_ARCHIVE_LZ4
+static block_cache_t block_cache[LV_FS_ARCHIVE_LZ4_CACHE_CNT];
+static uint32_t block_cache_tick;
+static uint8_t block_src[LV_FS_ARCHIVE_LZ4_BLOCK_SIZE];    /*Compressed block read from a not mapped archive*/
+#endif
+
+/**********************
+ *      MACROS
+ **********************/
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+/**
+ * Register a driver for the File system interface
+ */
+void lv_fs_if_archive_init(void)
+{
+    /*---------------------------------------------------
+     * Register the file system interface  in LittlevGL
+     *--------------------------------------------------*/
+
+    static lv_fs_drv_t fs_drv;                         /*A driver descriptor*/
+    lv_fs_drv_init(&fs_drv);
+
+    /*Set up fields...*/
+    fs_drv.letter = LV_FS_IF_ARCHIVE;
+    fs_drv.open_cb = fs_open;
+    fs_drv.close_cb = fs_close;
+    fs_drv.read_cb = fs_read;
+    fs_drv.seek_cb = fs_seek;
+    fs_drv.tell_cb = fs_tell;
+
+    lv_fs_drv_register(&fs_drv);
+
+    LV_FS_IF_POOL_INIT(file_pool, LV_FS_IF_FILE_POOL_SIZE);
+
+    static lv_fs_if_ext_t fs_ext;
+    fs_ext.map_cb = fs_map;
+    fs_ext.file_pool = &file_pool;
+    lv_fs_if_set_ext(&fs_drv, &fs_ext);
+}
+
+/**
+ * Mount an archive created by `tools/lv_fs_archive.py`. The previous archive is unmounted.
+ * The container is mapped if its driver supports it, else it's kept open and only the index is read.
+ * No files of the previous archive should be open.
+ * @param path path of the archive with driver letter (e.g. "S:/assets.bin"). NULL to only unmount.
+ * @return LV_FS_RES_OK, LV_FS_RES_FS_ERR if it's not a valid archive or any error from lv_fs_res_t enum
+ */
+lv_fs_res_t lv_fs_if_archive_mount(const char * path)
+{
+    if(arch_mounted) {
+        if(arch_map) {
+            const lv_fs_if_ext_t * ext = lv_fs_if_get_ext(arch_map_drv);
+            if(ext->unmap_cb) ext->unmap_cb(arch_map_drv, arch_map, arch_map_size, arch_map_d);
+        }
+        else {
+            lv_fs_close(&arch_file);
+        }
+        lv_mem_free(arch_index_buf);
+        arch_index_buf = NULL;
+        arch_map = NULL;
+        arch_mounted = false;
+
+#if LV_FS_ARCHIVE_LZ4
+        uint32_t i;
+        for(i = 0; i < LV_FS_ARCHIVE_LZ4_CACHE_CNT; i++) block_cache[i].data_ofs = 0;
+#endif
+    }
+
+    if(path == NULL) return LV_FS_RES_OK;
+
+    lv_fs_drv_t * drv = lv_fs_get_drv(path[0]);
+    if(drv == NULL) return LV_FS_RES_NOT_EX;
+
+    /*Use the mapping of the driver if possible. Unlike `lv_fs_if_map()` never read the whole archive.*/
+    lv_fs_res_t res = LV_FS_RES_NOT_IMP;
+    const lv_fs_if_ext_t * ext = lv_fs_if_get_ext(drv);
+    if(ext && ext->map_cb) {
+        const char * real_path = path + 1;
+        if(*real_path == ':') real_path++;
+
+        const void * ptr;
+        arch_map_d = NULL;
+        res = ext->map_cb(drv, real_path, &ptr, &arch_map_size, &arch_map_d);
+        if(res == LV_FS_RES_OK) {
+            arch_map = ptr;
+            arch_map_drv = drv;
+        }
+    }
+
+    if(res == LV_FS_RES_NOT_IMP) {
+        res = lv_fs_open(&arch_file, path, LV_FS_MODE_RD);
+        arch_pos = 0;
+    }
+    if(res != LV_FS_RES_OK) return res;
+
+    arch_mounted = true;
+    res = arch_load_index();
+    if(res != LV_FS_RES_OK) {
+        LV_LOG_WARN("lv_fs_if_archive_mount: %s is not a valid archive", path);
+        lv_fs_if_archive_mount(NULL);
+    }
+
+    return res;
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+/**
+ * Open a file of the archive
+ * @param drv pointer to a driver where this function belongs
+ * @param path path to the file
+ * @param mode only LV_FS_MODE_RD is supported
+ * @return pointer to an arch_file_t or NULL on error
+ */
+static void * fs_open (lv_fs_drv_t * drv, const char * path, lv_fs_mode_t mode)
+{
+    (void) drv;     /*Unused*/
+    if(mode != LV_FS_MODE_RD) return NULL;
+
+    const arch_entry_t * e = entry_find(path);
+    if(e == NULL) return NULL;
+
+#if LV_FS_ARCHIVE_LZ4
+    uint32_t block_size = 0;
+    if(e->flags & ARCH_FLAG_LZ4) {
+        if(arch_read(e->data_ofs, &block_size, sizeof(block_size)) != LV_FS_RES_OK) return NULL;
+        if(block_size == 0 || block_size > LV_FS_ARCHIVE_LZ4_BLOCK_SIZE) {
+            LV_LOG_WARN("lv_fs_archive: %s has %d byte blocks, increase LV_FS_ARCHIVE_LZ4_BLOCK_SIZE", path, (int)block_size);
+            return NULL;
+        }
+    }
+    if(e->flags & ~ARCH_FLAG_LZ4) return NULL;
+#else
+    if(e->flags) {
+        LV_LOG_WARN("lv_fs_archive: %s is compressed, enable LV_FS_ARCHIVE_LZ4", path);
+        return NULL;
+    }
+#endif
+
+    arch_file_t * fp = lv_fs_if_pool_alloc(&file_pool);
+    if(fp == NULL) return NULL;
+
+    fp->e = e;
+    fp->pos = 0;
+#if LV_FS_ARCHIVE_LZ4
+    fp->block_size = block_size;
+#endif
+    return fp;
+}
+
+/**
+ * Close an opened file
+ * @param drv pointer to a driver where this function belongs
+ * @param file_p pointer to an arch_file_t
+ * @return LV_FS_RES_OK
+ */
+static lv_fs_res_t fs_close (lv_fs_drv_t * drv, void * file_p)
+{
+    (void) drv;     /*Unused*/
+    lv_fs_if_pool_free(&file_pool, file_p);
+    return LV_FS_RES_OK;
+}
+
+/**
+ * Read data from an opened file
+ * @param drv pointer to a driver where this function belongs
+ * @param file_p pointer to an arch_file_t
+ * @param buf pointer to a memory block where to store the read data
+ * @param btr number of Bytes To Read
+ * @param br the real number of read bytes (Byte Read)
+ * @return LV_FS_RES_OK or any error from lv_fs_res_t enum
+ */
+static lv_fs_res_t fs_read (lv_fs_drv_t * drv, void * file_p, void * buf, uint32_t btr, uint32_t * br)
+{
+    (void) drv;     /*Unused*/
+    arch_file_t * fp = file_p;
+    *br = 0;
+
+    uint32_t rest = fp->pos < fp->e->size ? fp->e->size - fp->pos : 0;
+    if(btr > rest) btr = rest;
+    if(btr == 0) return LV_FS_RES_OK;
+
+#if LV_FS_ARCHIVE_LZ4
+    if(fp->block_size) {
+        lv_fs_res_t res = read_lz4(fp, buf, btr);
+        if(res == LV_FS_RES_OK) *br = btr;
+        return res;
+    }
+#endif
+
+    lv_fs_res_t res = arch_read(fp->e->data_ofs + fp->pos, buf, btr);
+    if(res != LV_FS_RES_OK) return res;
+
+    fp->pos += btr;
+    *br = btr;
+    return LV_FS_RES_OK;
+}
+
+/**
+ * Set the read pointer
+ * @param drv pointer to a driver where this function belongs
+ * @param file_p pointer to an arch_file_t
+ * @param pos the new position of read pointer
+ * @param whence tells from where to interpret the `pos`. See @lv_fs_whence_t
+ * @return LV_FS_RES_OK or LV_FS_RES_INV_PARAM
+ */
+static lv_fs_res_t fs_seek (lv_fs_drv_t * drv, void * file_p, uint32_t pos, lv_fs_whence_t whence)
+{
+    (void) drv;     /*Unused*/
+    arch_file_t * fp = file_p;
+    switch(whence) {
+    case LV_FS_SEEK_SET:
+        fp->pos = pos;
+        break;
+    case LV_FS_SEEK_CUR:
+        fp->pos += pos;
+        break;
+    case LV_FS_SEEK_END:
+        fp->pos = fp->e->size + pos;
+        break;
+    default:
+        return LV_FS_RES_INV_PARAM;
+    }
+    return LV_FS_RES_OK;
+}
+
+/**
+ * Give the position of the read pointer
+ * @param drv pointer to a driver where this function belongs
+ * @param file_p pointer to an arch_file_t
+ * @param pos_p pointer to to store the result
+ * @return LV_FS_RES_OK
+ */
+static lv_fs_res_t fs_tell (lv_fs_drv_t * drv, void * file_p, uint32_t * pos_p)
+{
+    (void) drv;     /*Unused*/
+    arch_file_t * fp = file_p;
+    *pos_p = fp->pos;
+    return LV_FS_RES_OK;
+}
+
+/**
+ * Give the content of a file in place if the archive is mapped
+ * @param drv pointer to a driver where this function belongs
+ * @param path path to the file
+ * @param ptr pointer to store the address of the content
+ * @param size pointer to store the size of the content
+ * @param map_d unused
+ * @return LV_FS_RES_OK, LV_FS_RES_NOT_IMP if the archive is not mapped or LV_FS_RES_NOT_EX
+ */
+static lv_fs_res_t fs_map(lv_fs_drv_t * drv, const char * path, const void ** ptr, uint32_t * size, void ** map_d)
+{
+    (void) drv;     /*Unused*/
+    (void) map_d;   /*Unused*/
+
+    const arch_entry_t * e = entry_find(path);
+    if(e == NULL) return LV_FS_RES_NOT_EX;
+    if(arch_map == NULL || e->flags) return LV_FS_RES_NOT_IMP;
+
+    *ptr = arch_map + e->data_ofs;
+    *size = e->size;
+    return LV_FS_RES_OK;
+}
+
+/**
+ * Find a file in the hash table of the archive
+ * @param path path of the file
+ * @return pointer to the entry or NULL if not found
+ */
+static const arch_entry_t * entry_find(const char * path)
+{
+#ifdef LV_FS_ARCHIVE_FILE
+    if(!arch_mounted) lv_fs_if_archive_mount(LV_FS_ARCHIVE_FILE);
+#endif
+    if(!arch_mounted) return NULL;
+
+    while(*path == '/') path++;
+
+    uint32_t hash = path_hash(path);
+    uint32_t mask = arch_hdr.bucket_cnt - 1;
+    uint32_t b = hash & mask;
+    uint32_t i;
+    for(i = 0; i < arch_hdr.bucket_cnt && arch_buckets[b] != ARCH_EMPTY; i++, b = (b + 1) & mask) {
+        const arch_entry_t * e = &arch_entries[arch_buckets[b]];
+        if(e->hash == hash && entry_name_eq(e, path)) return e;
+    }
+
+    return NULL;
+}
+
+/**
+ * Compare the name of an entry with a path. The names are not kept in the memory
+ * so they are read from the archive only when the hashes match.
+ * @param e pointer to an entry
+ * @param path the path without the leading '/'
+ * @return true: the names are equal
+ */
+static bool entry_name_eq(const arch_entry_t * e, const char * path)
+{
+    uint32_t len = strlen(path) + 1;    /*Compare the closing '\0' too*/
+    if(arch_map) {
+        if(e->name_ofs + len > arch_map_size) return false;
+        return memcmp(arch_map + e->name_ofs, path, len) == 0;
+    }
+
+    char buf[64];
+    uint32_t ofs = 0;
+    while(ofs < len) {
+        uint32_t n = LV_MIN(len - ofs, sizeof(buf));
+        if(arch_read(e->name_ofs + ofs, buf, n) != LV_FS_RES_OK) return false;
+        if(memcmp(buf, path + ofs, n) != 0) return false;
+        ofs += n;
+    }
+
+    return true;
+}
+
+/**
+ * Read from the container
+ * @param ofs offset in the container
+ * @param buf buffer to read into
+ * @param len number of bytes to read
+ * @return LV_FS_RES_OK or any error from lv_fs_res_t enum
+ */
+static lv_fs_res_t arch_read(uint32_t ofs, void * buf, uint32_t len)
+{
+    if(arch_map) {
+        if(ofs > arch_map_size || len > arch_map_size - ofs) return LV_FS_RES_FS_ERR;
+        memcpy(buf, arch_map + ofs, len);
+        return LV_FS_RES_OK;
+    }
+
+    lv_fs_res_t res;
+    if(arch_pos != ofs) {
+        res = lv_fs_seek(&arch_file, ofs, LV_FS_SEEK_SET);
+        if(res != LV_FS_RES_OK) return res;
+        arch_pos = ofs;
+    }
+
+    uint32_t br = 0;
+    res = lv_fs_read(&arch_file, buf, len, &br);
+    arch_pos += br;
+    if(res == LV_FS_RES_OK && br != len) res = LV_FS_RES_FS_ERR;
+    return res;
+}
+
+/**
+ * Check the header of the mounted archive and make its hash table and entries accessible.
+ * The hash table is checked too, so `entry_find()` can trust it.
+ * @return LV_FS_RES_OK or LV_FS_RES_FS_ERR if the archive is invalid
+ */
+static lv_fs_res_t arch_load_index(void)
+{
+    lv_fs_res_t res = arch_read(0, &arch_hdr, sizeof(arch_hdr));
+    if(res != LV_FS_RES_OK) return LV_FS_RES_FS_ERR;
+
+    if(memcmp(arch_hdr.magic, "LVFA", 4) != 0 || arch_hdr.version != ARCH_VERSION) return LV_FS_RES_FS_ERR;
+
+    /*There must be at least one empty bucket to terminate the probing*/
+    uint32_t bucket_cnt = arch_hdr.bucket_cnt;
+    if(bucket_cnt == 0 || (bucket_cnt & (bucket_cnt - 1)) || arch_hdr.entry_cnt >= bucket_cnt) return LV_FS_RES_FS_ERR;
+
+    uint32_t bucket_size = bucket_cnt * sizeof(uint32_t);
+    uint32_t entry_size = arch_hdr.entry_cnt * sizeof(arch_entry_t);
+
+    if(arch_map) {
+        if(arch_hdr.bucket_ofs > arch_map_size || bucket_size > arch_map_size - arch_hdr.bucket_ofs) return LV_FS_RES_FS_ERR;
+        if(arch_hdr.entry_ofs > arch_map_size || entry_size > arch_map_size - arch_hdr.entry_ofs) return LV_FS_RES_FS_ERR;
+        if((arch_hdr.bucket_ofs | arch_hdr.entry_ofs) & 0x3) return LV_FS_RES_FS_ERR;
+        arch_buckets = (const uint32_t *)(arch_map + arch_hdr.bucket_ofs);
+        arch_entries = (const arch_entry_t *)(arch_map + arch_hdr.entry_ofs);
+
+        /*`fs_map()` gives out the content of the not compressed files without further checks*/
+        uint32_t i;
+        for(i = 0; i < arch_hdr.entry_cnt; i++) {
+            const arch_entry_t * e = &arch_entries[i];
+            if(e->flags == 0 && (e->data_ofs > arch_map_size || e->size > arch_map_size - e->data_ofs)) {
+                return LV_FS_RES_FS_ERR;
+            }
+        }
+
+        return arch_check_buckets();
+    }
+
+    /*Keep only the hash table and the entries in the memory*/
+    uint8_t * buf = lv_mem_alloc(bucket_size + entry_size);
+    if(buf == NULL) return LV_FS_RES_OUT_OF_MEM;
+    arch_index_buf = buf;
+
+    res = arch_read(arch_hdr.bucket_ofs, buf, bucket_size);
+    if(res == LV_FS_RES_OK) res = arch_read(arch_hdr.entry_ofs, buf + bucket_size, entry_size);
+    if(res != LV_FS_RES_OK) return LV_FS_RES_FS_ERR;
+
+    arch_buckets = (const uint32_t *)buf;
+    arch_entries = (const arch_entry_t *)(buf + bucket_size);
+    return arch_check_buckets();
+}
+
+/**
+ * Check that the buckets of the hash table refer to existing entries and at least one is empty
+ * @return LV_FS_RES_OK or LV_FS_RES_FS_ERR if the hash table is invalid
+ */
+static lv_fs_res_t arch_check_buckets(void)
+{
+    uint32_t empty_cnt = 0;
+    uint32_t i;
+    for(i = 0; i < arch_hdr.bucket_cnt; i++) {
+        if(arch_buckets[i] == ARCH_EMPTY) empty_cnt++;
+        else if(arch_buckets[i] >= arch_hdr.entry_cnt) return LV_FS_RES_FS_ERR;
+    }
+
+    return empty_cnt ? LV_FS_RES_OK : LV_FS_RES_FS_ERR;
+}
+
+#if LV_FS_ARCHIVE_LZ4
+/**
+ * Read from a compressed file. Only the blocks covering the requested range are decompressed.
+ * Whole blocks are decompressed directly into `buf`, partial blocks go through the block cache.
+ * @param fp pointer to an arch_file_t
+ * @param buf buffer to read into
+ * @param btr number of bytes to read. It must be inside the file.
+ * @return LV_FS_RES_OK or any error from lv_fs_res_t enum
+ */
+static lv_fs_res_t read_lz4(arch_file_t * fp, uint8_t * buf, uint32_t btr)
+{
+    uint32_t bs = fp->block_size;
+    while(btr > 0) {
+        uint32_t block = fp->pos / bs;
+        uint32_t ofs = fp->pos - block * bs;
+        uint32_t block_len = LV_MIN(bs, fp->e->size - block * bs);
+        uint32_t n = LV_MIN(btr, block_len - ofs);
+
+        if(n == block_len) {
+            lv_fs_res_t res = block_load(fp, block, buf, block_len);
+            if(res != LV_FS_RES_OK) return res;
+        }
+        else {
+            block_cache_tick++;
+
+            block_cache_t * c = NULL;
+            uint32_t i;
+            for(i = 0; i < LV_FS_ARCHIVE_LZ4_CACHE_CNT; i++) {
+                block_cache_t * ci = &block_cache[i];
+                if(ci->data_ofs == fp->e->data_ofs && ci->block == block) {
+                    c = ci;
+                    break;
+                }
+            }
+
+            /*Replace the least recently used block on miss*/
+            if(c == NULL) {
+                c = &block_cache[0];
+                for(i = 1; i < LV_FS_ARCHIVE_LZ4_CACHE_CNT; i++) {
+                    if(block_cache[i].last_use < c->last_use) c = &block_cache[i];
+                }
+
+                c->data_ofs = 0;
+                lv_fs_res_t res = block_load(fp, block, c->buf, block_len);
+                if(res != LV_FS_RES_OK) return res;
+                c->data_ofs = fp->e->data_ofs;
+                c->block = block;
+            }
+
+            c->last_use = block_cache_tick;
+            memcpy(buf, c->buf + ofs, n);
+        }
+
+        fp->pos += n;
+        buf += n;
+        btr -= n;
+    }
+
+    return LV_FS_RES_OK;
+}
+
+/**
+ * Read and decompress a block of a compressed file
+ * @param fp pointer to an arch_file_t
+ * @param block index of the block
+ * @param dst buffer for the decompressed block
+ * @param len size of the decompressed block
+ * @return LV_FS_RES_OK or any error from lv_fs_res_t enum
+ */
+static lv_fs_res_t block_load(arch_file_t * fp, uint32_t block, uint8_t * dst, uint32_t len)
+{
+    uint32_t block_ofs[2];
+    lv_fs_res_t res = arch_read(fp->e->data_ofs + 4 + block * 4, block_ofs, sizeof(block_ofs));
+    if(res != LV_FS_RES_OK) return res;
+
+    if(block_ofs[1] < block_ofs[0]) return LV_FS_RES_FS_ERR;
+    uint32_t src_len = block_ofs[1] - block_ofs[0];
+
+    /*Stored without compression*/
+    if(src_len >= len) return arch_read(block_ofs[0], dst, len);
+
+    const uint8_t * src;
+    if(arch_map) {
+        if(block_ofs[1] > arch_map_size) return LV_FS_RES_FS_ERR;
+        src = arch_map + block_ofs[0];
+    }
+    else {
+        res = arch_read(block_ofs[0], block_src, src_len);
+        if(res != LV_FS_RES_OK) return res;
+        src = block_src;
+    }
+
+    if(lz4_decompress(src, src_len, dst, len) != (int32_t)len) return LV_FS_RES_FS_ERR;
+    return LV_FS_RES_OK;
+}
+
+/**
+ * Decompress an LZ4 block (the raw block format without frame)
+ * @param src the compressed data
+ * @param src_len size of the compressed data
+ * @param dst buffer for the decompressed data
+ * @param dst_len size of `dst`
+ * @return number of decompressed bytes or -1 if the data is invalid
+ */
+static int32_t lz4_decompress(const uint8_t * src, uint32_t src_len, uint8_t * dst, uint32_t dst_len)
+{
+    const uint8_t * ip = src;
+    const uint8_t * iend = src + src_len;
+    uint8_t * op = dst;
+    uint8_t * oend = dst + dst_len;
+
+    while(ip < iend) {
+        uint32_t token = *ip++;
+
+        /*Literals*/
+        uint32_t len = token >> 4;
+        if(len == 15) {
+            uint8_t b;
+            do {
+                if(ip >= iend) return -1;
+                b = *ip++;
+                len += b;
+            } while(b == 255);
+        }
+        if(len > (uint32_t)(iend - ip) || len > (uint32_t)(oend - op)) return -1;
+        memcpy(op, ip, len);
+        op += len;
+        ip += len;
+
+        /*The last sequence has only literals*/
+        if(ip >= iend) break;
+
+        /*Match*/
+        if(iend - ip < 2) return -1;
+        uint32_t offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        if(offset == 0 || offset > (uint32_t)(op - dst)) return -1;
+
+        len = token & 0xF;
+        if(len == 15) {
+            uint8_t b;
+            do {
+                if(ip >= iend) return -1;
+                b = *ip++;
+                len += b;
+            } while(b == 255);
+        }
+        len += 4;
+        if(len > (uint32_t)(oend - op)) return -1;
+
+        /*Copy byte by byte as the match can overlap the output*/
+        const uint8_t * match = op - offset;
+        while(len--) *op++ = *match++;
+    }
+
+    return op - dst;
+}
+#endif
+
+/**
+ * Calculate the FNV-1a hash of a path
+ * @param path a path
+ * @return the hash
+ */
+static uint32_t path_hash(const char * path)
+{
+    uint32_t h = 2166136261U;
+    while(*path) {
+        h ^= (uint8_t)*path;
+        h *= 16777619U;
+        path++;
+    }
+    return h;
+}
+
+#endif  /*LV_FS_IF_ARCHIVE*/
+#endif  /*LV_USE_FS_IF*/
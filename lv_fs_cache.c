@@ -0,0 +1,1013 @@
+/**
+ * @file lv_fs_cache.c
+ *
+ */
+
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "lv_fs_if.h"
+#if LV_USE_FS_IF
+#if LV_FS_IF_CACHE != '\0'
+
+#include <string.h>
+#if LV_FS_IF_PREFETCH
+#include <pthread.h>
+#endif
+
+/*********************
+ *      DEFINES
+ *********************/
+/*Letter of the driver cached by the `LV_FS_IF_CACHE` drive*/
+#ifndef LV_FS_CACHE_BACKEND
+# define LV_FS_CACHE_BACKEND    'S'
+#endif
+
+/*Memory for the cached blocks in bytes*/
+#ifndef LV_FS_CACHE_SIZE
+# define LV_FS_CACHE_SIZE       (32 * 1024U)
+#endif
+
+/*Size of a block. Blocks are aligned to this size in the files*/
+#ifndef LV_FS_CACHE_BLOCK_SIZE
+# define LV_FS_CACHE_BLOCK_SIZE 1024
+#endif
+
+/*Max. number of files whose blocks can be cached*/
+#ifndef LV_FS_CACHE_FILE_MAX
+# define LV_FS_CACHE_FILE_MAX   32
+#endif
+
+/*Max. number of cached drives (views) added with `lv_fs_if_cache_add()`*/
+#ifndef LV_FS_CACHE_VIEW_MAX
+# define LV_FS_CACHE_VIEW_MAX   1
+#endif
+
+#define BLOCK_CNT       (LV_FS_CACHE_SIZE / LV_FS_CACHE_BLOCK_SIZE)
+#define A1IN_MAX        (BLOCK_CNT > 4 ? BLOCK_CNT / 4 : 1)     /*Blocks seen only once take max. 25% of the cache*/
+#define GHOST_CNT       (BLOCK_CNT > 2 ? BLOCK_CNT / 2 : 1)     /*Remember the keys of this many evicted A1in blocks*/
+#define BLOCK_NONE      0xFFFFFFFF
+
+#if BLOCK_CNT == 0
+# error "LV_FS_CACHE_SIZE must be at least LV_FS_CACHE_BLOCK_SIZE"
+#endif
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+/*The queues of the 2Q replacement policy*/
+enum {
+    Q_FREE,
+    Q_A1IN,     /*Blocks read once, FIFO*/
+    Q_AM,       /*Blocks read again after being evicted from A1in, LRU*/
+    _Q_LAST
+};
+
+typedef struct {
+    uint32_t file_id;   /*Identifies the content of a file. 0: unused*/
+    uint32_t block;     /*Index of the block in the file*/
+    uint32_t len;       /*Number of valid bytes (less than the block size at the end of the file)*/
+    uint32_t prev;      /*Neighbors in the queue*/
+    uint32_t next;
+    uint32_t hnext;     /*Next block in the same hash bucket*/
+    uint8_t queue;
+} cache_block_t;
+
+typedef struct {
+    uint32_t head;      /*Most recently inserted/used*/
+    uint32_t tail;
+    uint32_t cnt;
+} cache_queue_t;
+
+typedef struct {
+    uint32_t file_id;
+    uint32_t block;
+} cache_ghost_t;
+
+typedef struct {
+    lv_fs_drv_t drv;    /*The registered driver. Must be the first member.*/
+    lv_fs_drv_t * backend;
+} cache_view_t;
+
+/*A file known by the cache. Kept after closing until evicted so its blocks remain usable.*/
+typedef struct {
+    cache_view_t * view;
+    char * path;        /*NULL if the entry is unused*/
+    uint32_t id;        /*New ID if the content changes, so the old blocks are never matched*/
+    uint32_t size;
+    uint32_t ref_cnt;   /*Number of open handles*/
+    uint32_t last_use;
+} cache_file_t;
+
+typedef struct {
+    cache_file_t * file;    /*NULL: the file is not cached, all calls go to the backend*/
+    void * backend_fd;      /*Handle of the backend. Opened on the first miss for cached files.*/
+    uint32_t backend_pos;   /*Position of `backend_fd`*/
+    uint32_t pos;
+    uint8_t advice;         /*The last NORMAL, SEQUENTIAL or RANDOM advice*/
+} cache_handle_t;
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+static void * fs_open (lv_fs_drv_t * drv, const char * path, lv_fs_mode_t mode);
+static lv_fs_res_t fs_close (lv_fs_drv_t * drv, void * file_p);
+static lv_fs_res_t fs_read (lv_fs_drv_t * drv, void * file_p, void * buf, uint32_t btr, uint32_t * br);
+static lv_fs_res_t fs_write(lv_fs_drv_t * drv, void * file_p, const void * buf, uint32_t btw, uint32_t * bw);
+static lv_fs_res_t fs_seek (lv_fs_drv_t * drv, void * file_p, uint32_t pos, lv_fs_whence_t whence);
+static lv_fs_res_t fs_tell (lv_fs_drv_t * drv, void * file_p, uint32_t * pos_p);
+static void * fs_dir_open (lv_fs_drv_t * drv, const char *path);
+static lv_fs_res_t fs_dir_read (lv_fs_drv_t * drv, void * dir_p, char *fn);
+static lv_fs_res_t fs_dir_close (lv_fs_drv_t * drv, void * dir_p);
+static lv_fs_res_t fs_dir_read_batch(lv_fs_drv_t * drv, void * dir_p, lv_fs_if_dir_batch_t * batch);
+static lv_fs_res_t fs_flush(lv_fs_drv_t * drv, void * file_p);
+static lv_fs_res_t fs_advise(lv_fs_drv_t * drv, void * file_p, uint32_t ofs, uint32_t len, lv_fs_if_advice_t advice);
+static lv_fs_res_t fs_map(lv_fs_drv_t * drv, const char * path, const void ** ptr, uint32_t * size, void ** map_d);
+static void fs_unmap(lv_fs_drv_t * drv, const void * ptr, uint32_t size, void * map_d);
+#if LV_FS_IF_PREFETCH
+static lv_fs_res_t fs_prefetch(lv_fs_drv_t * drv, const char * path, uint32_t ofs, uint32_t len);
+#endif
+static cache_file_t * file_get(cache_view_t * view, const char * path, bool create);
+static void file_drop(cache_file_t * file);
+static lv_fs_res_t backend_open(cache_view_t * view, cache_handle_t * h, const char * path, lv_fs_mode_t mode);
+static const cache_block_t * block_get(cache_view_t * view, cache_handle_t * h, uint32_t block, bool hot);
+static void blocks_drop(uint32_t file_id, uint32_t first, uint32_t last);
+static uint32_t block_evict(void);
+static uint32_t hash_find(uint32_t file_id, uint32_t block);
+static void hash_insert(uint32_t b);
+static void hash_remove(uint32_t b);
+static void queue_push(uint8_t q, uint32_t b);
+static void queue_append(uint8_t q, uint32_t b);
+static void queue_remove(uint32_t b);
+static bool ghost_take(uint32_t file_id, uint32_t block);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+LV_FS_IF_POOL_DEF(file_pool, cache_handle_t, LV_FS_IF_FILE_POOL_SIZE);
+static cache_view_t views[LV_FS_CACHE_VIEW_MAX];
+static lv_fs_if_ext_t fs_ext;
+
+static cache_file_t files[LV_FS_CACHE_FILE_MAX];
+static uint32_t file_tick;
+static uint32_t file_id_next = 1;
+
+LV_ATTRIBUTE_LARGE_RAM_ARRAY static uint64_t block_data[BLOCK_CNT][LV_FS_CACHE_BLOCK_SIZE / 8];
+static cache_block_t blocks[BLOCK_CNT];
+static uint32_t buckets[BLOCK_CNT];
+static cache_queue_t queues[_Q_LAST];
+static cache_ghost_t ghosts[GHOST_CNT];
+static uint32_t ghost_next;     /*The oldest ghost which is overwritten next*/
+
+static lv_fs_if_cache_stat_t cache_stat;
+
+#if LV_FS_IF_PREFETCH
+/*The prefetch thread loads blocks while the UI reads*/
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+/**********************
+ *      MACROS
+ **********************/
+#define BLOCK_DATA(b)   ((uint8_t *)block_data[b])
+
+/*Lock the files and the blocks*/
+#if LV_FS_IF_PREFETCH
+# define CACHE_LOCK()       pthread_mutex_lock(&lock)
+# define CACHE_UNLOCK()     pthread_mutex_unlock(&lock)
+#else
+# define CACHE_LOCK()
+# define CACHE_UNLOCK()
+#endif
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+/**
+ * Register the cached view of `LV_FS_CACHE_BACKEND` as `LV_FS_IF_CACHE`
+ */
+void lv_fs_if_cache_init(void)
+{
+    LV_FS_IF_POOL_INIT(file_pool, LV_FS_IF_FILE_POOL_SIZE);
+
+    fs_ext.flush_cb = fs_flush;
+    fs_ext.advise_cb = fs_advise;
+    fs_ext.map_cb = fs_map;
+    fs_ext.unmap_cb = fs_unmap;
+    fs_ext.dir_read_batch_cb = fs_dir_read_batch;
+    fs_ext.file_pool = &file_pool;
+#if LV_FS_IF_PREFETCH
+    fs_ext.prefetch_cb = fs_prefetch;
+#endif
+
+    lv_fs_if_cache_invalidate();
+
+    if(lv_fs_if_cache_add(LV_FS_IF_CACHE, LV_FS_CACHE_BACKEND) != LV_FS_RES_OK) {
+        LV_LOG_WARN("lv_fs_if_cache_init: the backend drive '%c' is not registered", LV_FS_CACHE_BACKEND);
+    }
+}
+
+/**
+ * Register a cached view of a driver under a new letter. All views share the same cache.
+ * Files opened for writing through the view are not cached and drop the cached blocks of the file.
+ * Changes made directly on the backend are not detected, call `lv_fs_if_cache_invalidate()` after them.
+ * @param letter the letter of the cached drive
+ * @param backend_letter the letter of a registered driver to cache
+ * @return LV_FS_RES_OK, LV_FS_RES_NOT_EX if the backend is not registered
+ *         or LV_FS_RES_FULL if there are already `LV_FS_CACHE_VIEW_MAX` views
+ */
+lv_fs_res_t lv_fs_if_cache_add(char letter, char backend_letter)
+{
+    lv_fs_drv_t * backend = lv_fs_get_drv(backend_letter);
+    if(backend == NULL) return LV_FS_RES_NOT_EX;
+
+    cache_view_t * view = NULL;
+    uint32_t i;
+    for(i = 0; i < LV_FS_CACHE_VIEW_MAX; i++) {
+        if(views[i].backend == NULL) {
+            view = &views[i];
+            break;
+        }
+    }
+    if(view == NULL) return LV_FS_RES_FULL;
+
+    view->backend = backend;
+
+    lv_fs_drv_t * fs_drv = &view->drv;
+    lv_fs_drv_init(fs_drv);
+
+    fs_drv->letter = letter;
+    fs_drv->open_cb = fs_open;
+    fs_drv->close_cb = fs_close;
+    fs_drv->read_cb = fs_read;
+    if(backend->write_cb) fs_drv->write_cb = fs_write;
+    fs_drv->seek_cb = fs_seek;
+    fs_drv->tell_cb = fs_tell;
+
+    if(backend->dir_open_cb) fs_drv->dir_open_cb = fs_dir_open;
+    if(backend->dir_read_cb) fs_drv->dir_read_cb = fs_dir_read;
+    if(backend->dir_close_cb) fs_drv->dir_close_cb = fs_dir_close;
+
+    lv_fs_drv_register(fs_drv);
+    lv_fs_if_set_ext(fs_drv, &fs_ext);
+
+#if LV_FS_IF_HOOK
+    lv_fs_if_hook_attach(fs_drv);
+#endif
+
+    return LV_FS_RES_OK;
+}
+
+/**
+ * Drop all cached blocks, e.g. after the files were changed on the backend.
+ * The files should be closed.
+ */
+void lv_fs_if_cache_invalidate(void)
+{
+    CACHE_LOCK();
+
+    uint32_t i;
+    for(i = 0; i < LV_FS_CACHE_FILE_MAX; i++) {
+        if(files[i].path == NULL) continue;
+
+        /*The size might be changed too so forget closed files. The opened ones just won't find their blocks.*/
+        if(files[i].ref_cnt == 0) {
+            lv_mem_free(files[i].path);
+            files[i].path = NULL;
+        }
+        else {
+            files[i].id = file_id_next++;
+        }
+    }
+
+    memset(queues, 0, sizeof(queues));
+    for(i = 0; i < _Q_LAST; i++) {
+        queues[i].head = BLOCK_NONE;
+        queues[i].tail = BLOCK_NONE;
+    }
+
+    for(i = 0; i < BLOCK_CNT; i++) {
+        buckets[i] = BLOCK_NONE;
+        blocks[i].file_id = 0;
+        queue_push(Q_FREE, i);
+    }
+
+    memset(ghosts, 0, sizeof(ghosts));
+    cache_stat.used_cnt = 0;
+
+    CACHE_UNLOCK();
+}
+
+/**
+ * Get the statistics of the cache
+ * @param s pointer to store the statistics
+ */
+void lv_fs_if_cache_get_stat(lv_fs_if_cache_stat_t * s)
+{
+    CACHE_LOCK();
+    *s = cache_stat;
+    CACHE_UNLOCK();
+    s->block_cnt = BLOCK_CNT;
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+/**
+ * Open a file. Files opened for reading are cached, the others go to the backend directly.
+ * @param drv pointer to a driver where this function belongs
+ * @param path path to the file
+ * @param mode read: FS_MODE_RD, write: FS_MODE_WR, both: FS_MODE_RD | FS_MODE_WR
+ * @return pointer to a cache_handle_t or NULL on error
+ */
+static void * fs_open (lv_fs_drv_t * drv, const char * path, lv_fs_mode_t mode)
+{
+    cache_view_t * view = (cache_view_t *)drv;
+
+    cache_handle_t * h = lv_fs_if_pool_alloc(&file_pool);
+    if(h == NULL) return NULL;
+
+    h->file = NULL;
+    h->backend_fd = NULL;
+    h->backend_pos = 0;
+    h->pos = 0;
+    h->advice = LV_FS_IF_ADVICE_NORMAL;
+
+    CACHE_LOCK();
+    if(mode != LV_FS_MODE_RD) {
+        /*The cached content becomes outdated*/
+        cache_file_t * file = file_get(view, path, false);
+        if(file) file_drop(file);
+    }
+    else {
+        h->file = file_get(view, path, true);
+    }
+
+    /*A known file can be read from the cache without opening it on the backend*/
+    if(h->file && h->file->ref_cnt > 0) {
+        h->file->ref_cnt++;
+        CACHE_UNLOCK();
+        return h;
+    }
+
+    if(backend_open(view, h, path, mode) != LV_FS_RES_OK) {
+        if(h->file) file_drop(h->file);
+        CACHE_UNLOCK();
+        lv_fs_if_pool_free(&file_pool, h);
+        return NULL;
+    }
+
+    if(h->file) h->file->ref_cnt++;
+    CACHE_UNLOCK();
+    return h;
+}
+
+/**
+ * Close an opened file
+ * @param drv pointer to a driver where this function belongs
+ * @param file_p pointer to a cache_handle_t
+ * @return LV_FS_RES_OK or any error from lv_fs_res_t enum
+ */
+static lv_fs_res_t fs_close (lv_fs_drv_t * drv, void * file_p)
+{
+    cache_view_t * view = (cache_view_t *)drv;
+    cache_handle_t * h = file_p;
+
+    lv_fs_res_t res = LV_FS_RES_OK;
+    if(h->backend_fd) res = view->backend->close_cb(view->backend, h->backend_fd);
+
+    CACHE_LOCK();
+    if(h->file) h->file->ref_cnt--;
+    CACHE_UNLOCK();
+
+    lv_fs_if_pool_free(&file_pool, h);
+    return res;
+}
+
+/**
+ * Read data from an opened file
+ * @param drv pointer to a driver where this function belongs
+ * @param file_p pointer to a cache_handle_t
+ * @param buf pointer to a memory block where to store the read data
+ * @param btr number of Bytes To Read
+ * @param br the real number of read bytes (Byte Read)
+ * @return LV_FS_RES_OK or any error from lv_fs_res_t enum
+ */
+static lv_fs_res_t fs_read (lv_fs_drv_t * drv, void * file_p, void * buf, uint32_t btr, uint32_t * br)
+{
+    cache_view_t * view = (cache_view_t *)drv;
+    cache_handle_t * h = file_p;
+    *br = 0;
+
+    if(h->file == NULL) {
+        if(h->backend_pos != h->pos) {
+            lv_fs_res_t res = view->backend->seek_cb(view->backend, h->backend_fd, h->pos, LV_FS_SEEK_SET);
+            if(res != LV_FS_RES_OK) return res;
+        }
+        lv_fs_res_t res = view->backend->read_cb(view->backend, h->backend_fd, buf, btr, br);
+        h->pos += *br;
+        h->backend_pos = h->pos;
+        return res;
+    }
+
+    uint8_t * buf8 = buf;
+    lv_fs_res_t res = LV_FS_RES_OK;
+    CACHE_LOCK();
+    while(btr > 0 && h->pos < h->file->size) {
+        uint32_t block = h->pos / LV_FS_CACHE_BLOCK_SIZE;
+        uint32_t ofs = h->pos - block * LV_FS_CACHE_BLOCK_SIZE;
+        const cache_block_t * b = block_get(view, h, block, false);
+        if(b == NULL) {
+            if(*br == 0) res = LV_FS_RES_UNKNOWN;
+            break;
+        }
+        if(ofs >= b->len) break;    /*The file got shorter*/
+
+        uint32_t n = LV_MIN(btr, b->len - ofs);
+        memcpy(buf8, BLOCK_DATA(b - blocks) + ofs, n);
+        buf8 += n;
+        btr -= n;
+        h->pos += n;
+        *br += n;
+    }
+    CACHE_UNLOCK();
+
+    return res;
+}
+
+/**
+ * Write into a file. Only files not opened with LV_FS_MODE_RD only are writable.
+ * @param drv pointer to a driver where this function belongs
+ * @param file_p pointer to a cache_handle_t
+ * @param buf pointer to a buffer with the bytes to write
+ * @param btw Bytes To Write
+ * @param bw the number of real written bytes (Bytes Written)
+ * @return LV_FS_RES_OK or any error from lv_fs_res_t enum
+ */
+static lv_fs_res_t fs_write(lv_fs_drv_t * drv, void * file_p, const void * buf, uint32_t btw, uint32_t * bw)
+{
+    cache_view_t * view = (cache_view_t *)drv;
+    cache_handle_t * h = file_p;
+    *bw = 0;
+    if(h->file) return LV_FS_RES_DENIED;
+
+    if(h->backend_pos != h->pos) {
+        lv_fs_res_t res = view->backend->seek_cb(view->backend, h->backend_fd, h->pos, LV_FS_SEEK_SET);
+        if(res != LV_FS_RES_OK) return res;
+    }
+    lv_fs_res_t res = view->backend->write_cb(view->backend, h->backend_fd, buf, btw, bw);
+    h->pos += *bw;
+    h->backend_pos = h->pos;
+    return res;
+}
+
+/**
+ * Set the read write pointer
+ * @param drv pointer to a driver where this function belongs
+ * @param file_p pointer to a cache_handle_t
+ * @param pos the new position of read write pointer
+ * @param whence tells from where to interpret the `pos`. See @lv_fs_whence_t
+ * @return LV_FS_RES_OK or any error from lv_fs_res_t enum
+ */
+static lv_fs_res_t fs_seek (lv_fs_drv_t * drv, void * file_p, uint32_t pos, lv_fs_whence_t whence)
+{
+    cache_view_t * view = (cache_view_t *)drv;
+    cache_handle_t * h = file_p;
+    switch(whence) {
+    case LV_FS_SEEK_SET:
+        h->pos = pos;
+        break;
+    case LV_FS_SEEK_CUR:
+        h->pos += pos;
+        break;
+    case LV_FS_SEEK_END:
+        if(h->file) {
+            h->pos = h->file->size + pos;
+        }
+        else {
+            lv_fs_res_t res = view->backend->seek_cb(view->backend, h->backend_fd, pos, LV_FS_SEEK_END);
+            if(res == LV_FS_RES_OK) res = view->backend->tell_cb(view->backend, h->backend_fd, &h->pos);
+            if(res != LV_FS_RES_OK) return res;
+            h->backend_pos = h->pos;
+        }
+        break;
+    default:
+        return LV_FS_RES_INV_PARAM;
+    }
+    return LV_FS_RES_OK;
+}
+
+/**
+ * Give the position of the read write pointer
+ * @param drv pointer to a driver where this function belongs
+ * @param file_p pointer to a cache_handle_t
+ * @param pos_p pointer to to store the result
+ * @return LV_FS_RES_OK
+ */
+static lv_fs_res_t fs_tell (lv_fs_drv_t * drv, void * file_p, uint32_t * pos_p)
+{
+    (void) drv;     /*Unused*/
+    cache_handle_t * h = file_p;
+    *pos_p = h->pos;
+    return LV_FS_RES_OK;
+}
+
+/**
+ * Open a directory of the backend
+ * @param drv pointer to a driver where this function belongs
+ * @param path path to a directory
+ * @return the directory handle of the backend
+ */
+static void * fs_dir_open (lv_fs_drv_t * drv, const char *path)
+{
+    cache_view_t * view = (cache_view_t *)drv;
+    return view->backend->dir_open_cb(view->backend, path);
+}
+
+/**
+ * Read the next filename from a directory of the backend
+ * @param drv pointer to a driver where this function belongs
+ * @param dir_p the directory handle of the backend
+ * @param fn pointer to a buffer to store the filename
+ * @return LV_FS_RES_OK or any error from lv_fs_res_t enum
+ */
+static lv_fs_res_t fs_dir_read (lv_fs_drv_t * drv, void * dir_p, char *fn)
+{
+    cache_view_t * view = (cache_view_t *)drv;
+    return view->backend->dir_read_cb(view->backend, dir_p, fn);
+}
+
+/**
+ * Close a directory of the backend
+ * @param drv pointer to a driver where this function belongs
+ * @param dir_p the directory handle of the backend
+ * @return LV_FS_RES_OK or any error from lv_fs_res_t enum
+ */
+static lv_fs_res_t fs_dir_close (lv_fs_drv_t * drv, void * dir_p)
+{
+    cache_view_t * view = (cache_view_t *)drv;
+    return view->backend->dir_close_cb(view->backend, dir_p);
+}
+
+/**
+ * Read the next entries of a directory with the backend if it supports it
+ * @param drv pointer to a driver where this function belongs
+ * @param dir_p the directory handle of the backend
+ * @param batch pointer to an empty batch to fill
+ * @return the result of the backend or LV_FS_RES_NOT_IMP
+ */
+static lv_fs_res_t fs_dir_read_batch(lv_fs_drv_t * drv, void * dir_p, lv_fs_if_dir_batch_t * batch)
+{
+    cache_view_t * view = (cache_view_t *)drv;
+    const lv_fs_if_ext_t * ext = lv_fs_if_get_ext(view->backend);
+    if(ext == NULL || ext->dir_read_batch_cb == NULL) return LV_FS_RES_NOT_IMP;
+    return ext->dir_read_batch_cb(view->backend, dir_p, batch);
+}
+
+/**
+ * Flush a file opened for writing on the backend
+ * @param drv pointer to a driver where this function belongs
+ * @param file_p pointer to a cache_handle_t
+ * @return LV_FS_RES_OK or any error from lv_fs_res_t enum
+ */
+static lv_fs_res_t fs_flush(lv_fs_drv_t * drv, void * file_p)
+{
+    cache_view_t * view = (cache_view_t *)drv;
+    cache_handle_t * h = file_p;
+    if(h->file || h->backend_fd == NULL) return LV_FS_RES_OK;
+
+    const lv_fs_if_ext_t * ext = lv_fs_if_get_ext(view->backend);
+    if(ext == NULL || ext->flush_cb == NULL) return LV_FS_RES_OK;
+    return ext->flush_cb(view->backend, h->backend_fd);
+}
+
+/**
+ * Adapt the caching of a file to an advice and pass it to the backend too.
+ * WILLNEED loads the part into the cache as frequently used blocks, DONTNEED drops its blocks,
+ * and the blocks read after SEQUENTIAL are evicted first, so a file read once doesn't push out the others.
+ * @param drv pointer to a driver where this function belongs
+ * @param file_p pointer to a cache_handle_t
+ * @param ofs start of the part
+ * @param len length of the part. 0: until the end of the file
+ * @param advice how the part will be read
+ * @return LV_FS_RES_OK or any error from lv_fs_res_t enum
+ */
+static lv_fs_res_t fs_advise(lv_fs_drv_t * drv, void * file_p, uint32_t ofs, uint32_t len, lv_fs_if_advice_t advice)
+{
+    cache_view_t * view = (cache_view_t *)drv;
+    cache_handle_t * h = file_p;
+    if(advice > LV_FS_IF_ADVICE_DONTNEED) return LV_FS_RES_INV_PARAM;
+
+    if(advice != LV_FS_IF_ADVICE_WILLNEED && advice != LV_FS_IF_ADVICE_DONTNEED) h->advice = advice;
+
+    CACHE_LOCK();
+    if(h->file && h->file->size > ofs && (advice == LV_FS_IF_ADVICE_WILLNEED || advice == LV_FS_IF_ADVICE_DONTNEED)) {
+        if(len == 0 || len > h->file->size - ofs) len = h->file->size - ofs;
+        uint32_t first = ofs / LV_FS_CACHE_BLOCK_SIZE;
+        uint32_t last = (ofs + len - 1) / LV_FS_CACHE_BLOCK_SIZE;
+        if(advice == LV_FS_IF_ADVICE_DONTNEED) {
+            blocks_drop(h->file->id, first, last);
+        }
+        else {
+            /*Loading more than the cache would evict the first blocks of the part*/
+            last = LV_MIN(last, first + BLOCK_CNT - 1);
+            uint32_t block;
+            for(block = first; block <= last; block++) {
+                if(block_get(view, h, block, true) == NULL) break;
+            }
+        }
+    }
+    CACHE_UNLOCK();
+
+    /*The backend can adapt its own caching too, e.g. the page cache on POSIX*/
+    const lv_fs_if_ext_t * ext = lv_fs_if_get_ext(view->backend);
+    if(h->backend_fd == NULL || ext == NULL || ext->advise_cb == NULL) return LV_FS_RES_OK;
+    return ext->advise_cb(view->backend, h->backend_fd, ofs, len, advice);
+}
+
+/**
+ * Map a file with the backend if it supports mapping. A mapped file needs no cache.
+ * @param drv pointer to a driver where this function belongs
+ * @param path path to the file
+ * @param ptr pointer to store the address of the content
+ * @param size pointer to store the size of the content
+ * @param map_d passed to the backend
+ * @return the result of the backend or LV_FS_RES_NOT_IMP
+ */
+static lv_fs_res_t fs_map(lv_fs_drv_t * drv, const char * path, const void ** ptr, uint32_t * size, void ** map_d)
+{
+    cache_view_t * view = (cache_view_t *)drv;
+    const lv_fs_if_ext_t * ext = lv_fs_if_get_ext(view->backend);
+    if(ext == NULL || ext->map_cb == NULL) return LV_FS_RES_NOT_IMP;
+    return ext->map_cb(view->backend, path, ptr, size, map_d);
+}
+
+/**
+ * Release a mapping created by `fs_map`
+ * @param drv pointer to a driver where this function belongs
+ * @param ptr address of the mapping
+ * @param size size of the mapping
+ * @param map_d passed to the backend
+ */
+static void fs_unmap(lv_fs_drv_t * drv, const void * ptr, uint32_t size, void * map_d)
+{
+    cache_view_t * view = (cache_view_t *)drv;
+    const lv_fs_if_ext_t * ext = lv_fs_if_get_ext(view->backend);
+    if(ext && ext->unmap_cb) ext->unmap_cb(view->backend, ptr, size, map_d);
+}
+
+#if LV_FS_IF_PREFETCH
+/**
+ * Load a part of a file into the cache for the prefetch thread.
+ * The blocks are added like the ones read by the UI, so a part read once at boot doesn't push out the hot blocks.
+ * @param drv pointer to a driver where this function belongs
+ * @param path path to the file
+ * @param ofs position of the part
+ * @param len length of the part
+ * @return LV_FS_RES_OK, LV_FS_RES_NOT_IMP if the backend is not thread safe or any error from lv_fs_res_t enum
+ */
+static lv_fs_res_t fs_prefetch(lv_fs_drv_t * drv, const char * path, uint32_t ofs, uint32_t len)
+{
+    /*The UI can use the backend directly at the same time*/
+    cache_view_t * view = (cache_view_t *)drv;
+    const lv_fs_if_ext_t * ext = lv_fs_if_get_ext(view->backend);
+    if(ext == NULL || !ext->thread_safe) return LV_FS_RES_NOT_IMP;
+
+    cache_handle_t * h = fs_open(drv, path, LV_FS_MODE_RD);
+    if(h == NULL) return LV_FS_RES_NOT_EX;
+
+    /*The size doesn't change while the file is open*/
+    lv_fs_res_t res = LV_FS_RES_OK;
+    if(h->file && h->file->size > ofs && len > 0) {
+        uint32_t first = ofs / LV_FS_CACHE_BLOCK_SIZE;
+        uint32_t last = (LV_MIN(len, h->file->size - ofs) + ofs - 1) / LV_FS_CACHE_BLOCK_SIZE;
+        last = LV_MIN(last, first + BLOCK_CNT - 1);
+
+        /*Lock block by block to let the UI in between*/
+        uint32_t block;
+        for(block = first; block <= last && res == LV_FS_RES_OK; block++) {
+            CACHE_LOCK();
+            if(hash_find(h->file->id, block) == BLOCK_NONE && block_get(view, h, block, false) == NULL) {
+                res = LV_FS_RES_UNKNOWN;
+            }
+            CACHE_UNLOCK();
+        }
+    }
+
+    lv_fs_res_t close_res = fs_close(drv, h);
+    return res != LV_FS_RES_OK ? res : close_res;
+}
+#endif
+
+/**
+ * Find a file known by the cache or add it.
+ * The least recently used, not opened file is forgotten if the table is full.
+ * @param view pointer to a view
+ * @param path path of the file on the backend
+ * @param create true: add the file if it's not known
+ * @return pointer to the file, NULL if not found or there is no free entry
+ */
+static cache_file_t * file_get(cache_view_t * view, const char * path, bool create)
+{
+    file_tick++;
+
+    cache_file_t * slot = NULL;
+    uint32_t i;
+    for(i = 0; i < LV_FS_CACHE_FILE_MAX; i++) {
+        cache_file_t * f = &files[i];
+        if(f->path && f->view == view && strcmp(f->path, path) == 0) {
+            f->last_use = file_tick;
+            return f;
+        }
+
+        /*Prefer a free entry, else the least recently used closed one*/
+        if(f->path == NULL) {
+            if(slot == NULL || slot->path) slot = f;
+        }
+        else if(f->ref_cnt == 0 && (slot == NULL || (slot->path && f->last_use < slot->last_use))) {
+            slot = f;
+        }
+    }
+
+    if(!create || slot == NULL) return NULL;
+
+    char * path_copy = lv_mem_alloc(strlen(path) + 1);
+    if(path_copy == NULL) return NULL;
+    strcpy(path_copy, path);
+
+    if(slot->path) file_drop(slot);
+
+    slot->view = view;
+    slot->path = path_copy;
+    slot->id = file_id_next++;
+    slot->size = 0;
+    slot->ref_cnt = 0;
+    slot->last_use = file_tick;
+    return slot;
+}
+
+/**
+ * Drop the cached blocks of a file and forget the file if it's not opened.
+ * If it's opened, it gets a new ID so its handles read the new content.
+ * @param file pointer to a file
+ */
+static void file_drop(cache_file_t * file)
+{
+    blocks_drop(file->id, 0, UINT32_MAX);
+
+    if(file->ref_cnt) {
+        file->id = file_id_next++;
+    }
+    else {
+        lv_mem_free(file->path);
+        file->path = NULL;
+    }
+}
+
+/**
+ * Open the file of a handle on the backend.
+ * The size of a newly added cached file is read here too.
+ * @param view pointer to a view
+ * @param h pointer to a handle
+ * @param path path of the file on the backend
+ * @param mode mode to open the file with
+ * @return LV_FS_RES_OK or any error from lv_fs_res_t enum
+ */
+static lv_fs_res_t backend_open(cache_view_t * view, cache_handle_t * h, const char * path, lv_fs_mode_t mode)
+{
+    lv_fs_drv_t * backend = view->backend;
+    h->backend_fd = backend->open_cb(backend, path, mode);
+    if(h->backend_fd == NULL) return LV_FS_RES_NOT_EX;
+    h->backend_pos = 0;
+
+    if(h->file && h->file->ref_cnt == 0) {
+        lv_fs_res_t res = backend->seek_cb(backend, h->backend_fd, 0, LV_FS_SEEK_END);
+        if(res == LV_FS_RES_OK) res = backend->tell_cb(backend, h->backend_fd, &h->file->size);
+        if(res != LV_FS_RES_OK) {
+            backend->close_cb(backend, h->backend_fd);
+            h->backend_fd = NULL;
+            return res;
+        }
+        h->backend_pos = h->file->size;
+    }
+
+    return LV_FS_RES_OK;
+}
+
+/**
+ * Free the cached blocks of a file in a range
+ * @param file_id ID of the file
+ * @param first index of the first block to drop
+ * @param last index of the last block to drop
+ */
+static void blocks_drop(uint32_t file_id, uint32_t first, uint32_t last)
+{
+    uint32_t i;
+    for(i = 0; i < BLOCK_CNT; i++) {
+        if(blocks[i].file_id == file_id && blocks[i].block >= first && blocks[i].block <= last) {
+            hash_remove(i);
+            queue_remove(i);
+            blocks[i].file_id = 0;
+            queue_push(Q_FREE, i);
+            cache_stat.used_cnt--;
+        }
+    }
+}
+
+/**
+ * Get a block of a file from the cache or read it from the backend
+ * @param view pointer to a view
+ * @param h pointer to a handle of a cached file
+ * @param block index of the block in the file
+ * @param hot true: put the block to Am as it will be used frequently
+ * @return pointer to the block or NULL on error
+ */
+static const cache_block_t * block_get(cache_view_t * view, cache_handle_t * h, uint32_t block, bool hot)
+{
+    uint32_t file_id = h->file->id;
+    uint32_t b = hash_find(file_id, block);
+    if(b != BLOCK_NONE) {
+        cache_stat.hit_cnt++;
+        if(blocks[b].queue == Q_AM || hot) {
+            queue_remove(b);
+            queue_push(Q_AM, b);
+        }
+        return &blocks[b];
+    }
+
+    cache_stat.miss_cnt++;
+
+    /*Cached files are opened on the backend only when needed*/
+    lv_fs_drv_t * backend = view->backend;
+    if(h->backend_fd == NULL) {
+        h->backend_fd = backend->open_cb(backend, h->file->path, LV_FS_MODE_RD);
+        if(h->backend_fd == NULL) return NULL;
+        h->backend_pos = 0;
+    }
+
+    uint32_t pos = block * LV_FS_CACHE_BLOCK_SIZE;
+    if(h->backend_pos != pos) {
+        if(backend->seek_cb(backend, h->backend_fd, pos, LV_FS_SEEK_SET) != LV_FS_RES_OK) return NULL;
+        h->backend_pos = pos;
+    }
+
+    b = queues[Q_FREE].tail;
+    if(b == BLOCK_NONE) b = block_evict();
+    else cache_stat.used_cnt++;
+    queue_remove(b);
+
+    uint32_t br = 0;
+    lv_fs_res_t res = backend->read_cb(backend, h->backend_fd, BLOCK_DATA(b), LV_FS_CACHE_BLOCK_SIZE, &br);
+    h->backend_pos += br;
+    if(res != LV_FS_RES_OK || br == 0) {
+        queue_push(Q_FREE, b);
+        cache_stat.used_cnt--;
+        return NULL;
+    }
+
+    cache_block_t * cb = &blocks[b];
+    cb->file_id = file_id;
+    cb->block = block;
+    cb->len = br;
+    hash_insert(b);
+
+    /*Blocks read again shortly after being evicted are hot, the others are tried in A1in first.
+     *The blocks of files read sequentially are put to the end of A1in to be evicted next.*/
+    if(ghost_take(file_id, block) || hot) queue_push(Q_AM, b);
+    else if(h->advice == LV_FS_IF_ADVICE_SEQUENTIAL) queue_append(Q_A1IN, b);
+    else queue_push(Q_A1IN, b);
+    return cb;
+}
+
+/**
+ * Evict a block according to the 2Q policy. If A1in is over its share its oldest block is evicted
+ * and remembered as a ghost, else the least recently used block of Am.
+ * @return index of the evicted block. It's still in its queue.
+ */
+static uint32_t block_evict(void)
+{
+    uint32_t b;
+    if(queues[Q_A1IN].cnt > A1IN_MAX || queues[Q_AM].cnt == 0) {
+        b = queues[Q_A1IN].tail;
+        ghosts[ghost_next].file_id = blocks[b].file_id;
+        ghosts[ghost_next].block = blocks[b].block;
+        ghost_next = (ghost_next + 1) % GHOST_CNT;
+    }
+    else {
+        b = queues[Q_AM].tail;
+    }
+
+    hash_remove(b);
+    blocks[b].file_id = 0;
+    cache_stat.evict_cnt++;
+    return b;
+}
+
+/**
+ * Find a block in the hash table
+ * @param file_id ID of the file
+ * @param block index of the block in the file
+ * @return index of the block or BLOCK_NONE
+ */
+static uint32_t hash_find(uint32_t file_id, uint32_t block)
+{
+    uint32_t b = buckets[(file_id * 2654435761U + block) % BLOCK_CNT];
+    while(b != BLOCK_NONE) {
+        if(blocks[b].file_id == file_id && blocks[b].block == block) return b;
+        b = blocks[b].hnext;
+    }
+
+    return BLOCK_NONE;
+}
+
+static void hash_insert(uint32_t b)
+{
+    uint32_t * head = &buckets[(blocks[b].file_id * 2654435761U + blocks[b].block) % BLOCK_CNT];
+    blocks[b].hnext = *head;
+    *head = b;
+}
+
+static void hash_remove(uint32_t b)
+{
+    uint32_t * p = &buckets[(blocks[b].file_id * 2654435761U + blocks[b].block) % BLOCK_CNT];
+    while(*p != BLOCK_NONE) {
+        if(*p == b) {
+            *p = blocks[b].hnext;
+            return;
+        }
+        p = &blocks[*p].hnext;
+    }
+}
+
+/**
+ * Insert a block to the head of a queue
+ * @param q the queue
+ * @param b index of the block
+ */
+static void queue_push(uint8_t q, uint32_t b)
+{
+    cache_queue_t * qu = &queues[q];
+    blocks[b].queue = q;
+    blocks[b].prev = BLOCK_NONE;
+    blocks[b].next = qu->head;
+    if(qu->head != BLOCK_NONE) blocks[qu->head].prev = b;
+    else qu->tail = b;
+    qu->head = b;
+    qu->cnt++;
+}
+
+/**
+ * Insert a block to the tail of a queue
+ * @param q the queue
+ * @param b index of the block
+ */
+static void queue_append(uint8_t q, uint32_t b)
+{
+    cache_queue_t * qu = &queues[q];
+    blocks[b].queue = q;
+    blocks[b].next = BLOCK_NONE;
+    blocks[b].prev = qu->tail;
+    if(qu->tail != BLOCK_NONE) blocks[qu->tail].next = b;
+    else qu->head = b;
+    qu->tail = b;
+    qu->cnt++;
+}
+
+/**
+ * Remove a block from its queue
+ * @param b index of the block
+ */
+static void queue_remove(uint32_t b)
+{
+    cache_queue_t * qu = &queues[blocks[b].queue];
+    if(blocks[b].prev != BLOCK_NONE) blocks[blocks[b].prev].next = blocks[b].next;
+    else qu->head = blocks[b].next;
+    if(blocks[b].next != BLOCK_NONE) blocks[blocks[b].next].prev = blocks[b].prev;
+    else qu->tail = blocks[b].prev;
+    qu->cnt--;
+}
+
+/**
+ * Check whether a block was evicted from A1in recently and forget it
+ * @param file_id ID of the file
+ * @param block index of the block in the file
+ * @return true: the block was a ghost
+ */
+static bool ghost_take(uint32_t file_id, uint32_t block)
+{
+    uint32_t i;
+    for(i = 0; i < GHOST_CNT; i++) {
+        if(ghosts[i].file_id == file_id && ghosts[i].block == block) {
+            ghosts[i].file_id = 0;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+#endif  /*LV_FS_IF_CACHE*/
+#endif  /*LV_USE_FS_IF*/
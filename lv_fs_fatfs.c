@@ -11,19 +11,108 @@
 #if LV_USE_FS_IF
 #if LV_FS_IF_FATFS != '\0'
 #include "ff.h"
+#if LV_FS_FATFS_DEFERRED_MOUNT == 2 || (LV_FS_FATFS_HANDLE_MAX && (LV_FS_IF_ASYNC || LV_FS_IF_PREFETCH))
+#include <pthread.h>
+#endif
 
 /*********************
  *      DEFINES
  *********************/
+/*Build a cluster link map table for the files opened for reading to make seeking O(1)*/
+#ifndef LV_FS_FATFS_FASTSEEK
+# define LV_FS_FATFS_FASTSEEK               0
+#endif
+
+/*Max. number of cached link map tables. They are reused when the same file is opened again*/
+#ifndef LV_FS_FATFS_FASTSEEK_CACHE_CNT
+# define LV_FS_FATFS_FASTSEEK_CACHE_CNT     4
+#endif
+
+/*Max. total size of the cached link map tables in DWORDs (4 bytes)*/
+#ifndef LV_FS_FATFS_FASTSEEK_BUDGET
+# define LV_FS_FATFS_FASTSEEK_BUDGET        256
+#endif
+
+/*Max. number of FILs (each with a sector buffer) open at once. Any number of files can be opened:
+ *the idle ones are closed (LRU) and reopened and re-seeked transparently on the next access. 0: disable*/
+#ifndef LV_FS_FATFS_HANDLE_MAX
+# define LV_FS_FATFS_HANDLE_MAX             0
+#endif
+
+/*When to run `fs_init()` (mount the card). 0: in `lv_fs_if_init()`, 1: on the first open,
+ *2: on a background thread started by `lv_fs_if_init()`. Opening waits until the mount is finished*/
+#ifndef LV_FS_FATFS_DEFERRED_MOUNT
+# define LV_FS_FATFS_DEFERRED_MOUNT         0
+#endif
+
+#if LV_FS_FATFS_FASTSEEK && !FF_USE_FASTSEEK
+# error "LV_FS_FATFS_FASTSEEK requires FF_USE_FASTSEEK 1 in ffconf.h"
+#endif
 
 /**********************
  *      TYPEDEFS
  **********************/
+#if LV_FS_FATFS_FASTSEEK
+typedef struct {
+    FATFS * fs;         /*The volume of the file. NULL if the file was written since: free the table when unused*/
+    DWORD sclust;       /*Start cluster of the file. Identifies the file on the volume*/
+    FSIZE_t size;       /*Size of the file when the table was created*/
+    DWORD * tbl;        /*The link map table. NULL if the entry is unused*/
+    uint32_t ref_cnt;   /*Number of open files using the table*/
+    uint32_t last_use;  /*For LRU eviction*/
+    uint8_t hot;        /*1: advised as RANDOM or WILLNEED, evicted after the others*/
+} clmt_entry_t;
+#endif
+
+#if LV_FS_FATFS_HANDLE_MAX
+/*A file opened by LVGL. It's backed by a FIL only while it's used*/
+typedef struct {
+    FIL * fil;          /*The real file or NULL if it was closed to free its slot*/
+    char * path;        /*Path to reopen the file*/
+    BYTE flags;         /*Flags to reopen the file*/
+    FSIZE_t pos;        /*Position while `fil` is NULL*/
+    FSIZE_t size;       /*Size while `fil` is NULL*/
+    uint32_t last_use;  /*For LRU eviction of `fil`*/
+    uint32_t busy;      /*Number of calls in progress. `fil` isn't closed for an other file while it's not 0.*/
+} fatfs_file_t;
+#endif
+
+#if LV_FS_FATFS_DEFERRED_MOUNT
+typedef enum {
+    MOUNT_NONE,
+    MOUNT_RUNNING,
+    MOUNT_DONE,
+} mount_state_t;
+#endif
 
 /**********************
  *  STATIC PROTOTYPES
  **********************/
-static void fs_init(void);
+lv_fs_res_t lv_fs_if_fatfs_get_mount(uint32_t * time_us);
+static lv_fs_res_t fs_init(void);
+#if LV_FS_FATFS_DEFERRED_MOUNT
+static void mount_run(void);
+static lv_fs_res_t mount_wait(void);
+#if LV_FS_FATFS_DEFERRED_MOUNT == 2
+static void * mount_thread(void * arg);
+#endif
+#endif
+#if LV_FS_FATFS_HANDLE_MAX
+static FIL * fil_get(fatfs_file_t * vf);
+static void fil_pin(fatfs_file_t * vf);
+static void fil_put(fatfs_file_t * vf);
+static int32_t fil_find_slot(void);
+static void fil_release(fatfs_file_t * vf);
+#endif
+static FRESULT fil_open(FIL * f, const char * path, BYTE flags);
+static void fil_close(FIL * f);
+#if LV_FS_FATFS_FASTSEEK
+static void clmt_attach(FIL * f);
+static void clmt_detach(FIL * f);
+static void clmt_invalidate(const FIL * f);
+static void clmt_drop(clmt_entry_t * e);
+static clmt_entry_t * clmt_find(const FIL * f);
+#endif
 
 static void * fs_open (lv_fs_drv_t * drv, const char * path, lv_fs_mode_t mode);
 static lv_fs_res_t fs_close (lv_fs_drv_t * drv, void * file_p);
@@ -31,17 +120,69 @@ static lv_fs_res_t fs_read (lv_fs_drv_t * drv, void * file_p, void * buf, uint32
 static lv_fs_res_t fs_write(lv_fs_drv_t * drv, void * file_p, const void * buf, uint32_t btw, uint32_t * bw);
 static lv_fs_res_t fs_seek (lv_fs_drv_t * drv, void * file_p, uint32_t pos, lv_fs_whence_t whence);
 static lv_fs_res_t fs_tell (lv_fs_drv_t * drv, void * file_p, uint32_t * pos_p);
+static lv_fs_res_t fs_flush(lv_fs_drv_t * drv, void * file_p);
+static lv_fs_res_t fs_advise(lv_fs_drv_t * drv, void * file_p, uint32_t ofs, uint32_t len, lv_fs_if_advice_t advice);
+static lv_fs_res_t fs_readv(lv_fs_drv_t * drv, void * file_p, lv_fs_if_seg_t * segs, uint32_t cnt);
 static void * fs_dir_open (lv_fs_drv_t * drv, const char *path);
 static lv_fs_res_t fs_dir_read (lv_fs_drv_t * drv, void * dir_p, char *fn);
+static lv_fs_res_t fs_dir_read_batch(lv_fs_drv_t * drv, void * dir_p, lv_fs_if_dir_batch_t * batch);
+static uint32_t fat_time_to_unix(WORD fdate, WORD ftime);
 static lv_fs_res_t fs_dir_close (lv_fs_drv_t * drv, void * dir_p);
 
 /**********************
  *  STATIC VARIABLES
  **********************/
+#if LV_FS_FATFS_HANDLE_MAX
+LV_FS_IF_POOL_DEF(file_pool, fatfs_file_t, LV_FS_IF_FILE_POOL_SIZE);
+static FIL fil_slots[LV_FS_FATFS_HANDLE_MAX];
+static fatfs_file_t * fil_owners[LV_FS_FATFS_HANDLE_MAX];     /*The file using a slot or NULL*/
+static uint32_t fil_tick;
+#if LV_FS_IF_ASYNC || LV_FS_IF_PREFETCH
+/*The worker and prefetch threads reopen files too*/
+static pthread_mutex_t slot_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t slot_cond = PTHREAD_COND_INITIALIZER;     /*Signaled when a file gets idle*/
+#endif
+#else
+LV_FS_IF_POOL_DEF(file_pool, FIL, LV_FS_IF_FILE_POOL_SIZE);
+#endif
+LV_FS_IF_POOL_DEF(dir_pool, DIR, LV_FS_IF_DIR_POOL_SIZE);
+#if LV_FS_FATFS_DEFERRED_MOUNT
+static mount_state_t mount_state;
+static lv_fs_res_t mount_res;
+static uint32_t mount_us;
+#if LV_FS_FATFS_DEFERRED_MOUNT == 2
+static pthread_mutex_t mount_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t mount_cond = PTHREAD_COND_INITIALIZER;
+#endif
+#endif
+
+#if LV_FS_FATFS_FASTSEEK
+static clmt_entry_t clmt_cache[LV_FS_FATFS_FASTSEEK_CACHE_CNT];
+static uint32_t clmt_used;      /*Total size of the cached tables in DWORDs*/
+static uint32_t clmt_tick;
+#endif
 
 /**********************
  *      MACROS
  **********************/
+/*The FIL of a file handle, reopened if needed and kept open until `FIL_PUT`. NULL if it couldn't be reopened*/
+#if LV_FS_FATFS_HANDLE_MAX
+# define FIL_GET(file_p)    fil_get(file_p)
+# define FIL_PUT(file_p)    fil_put(file_p)
+#else
+# define FIL_GET(file_p)    ((FIL *)(file_p))
+# define FIL_PUT(file_p)
+#endif
+
+#if LV_FS_FATFS_HANDLE_MAX && (LV_FS_IF_ASYNC || LV_FS_IF_PREFETCH)
+# define SLOT_LOCK()        pthread_mutex_lock(&slot_lock)
+# define SLOT_UNLOCK()      pthread_mutex_unlock(&slot_lock)
+# define SLOT_SIGNAL()      pthread_cond_broadcast(&slot_cond)
+#else
+# define SLOT_LOCK()
+# define SLOT_UNLOCK()
+# define SLOT_SIGNAL()
+#endif
 
 /**********************
  *   GLOBAL FUNCTIONS
@@ -52,7 +193,19 @@ void lv_fs_if_fatfs_init(void)
     /*----------------------------------------------------
      * Initialize your storage device and File System
      * -------------------------------------------------*/
+#if LV_FS_FATFS_DEFERRED_MOUNT == 0
     fs_init();
+#elif LV_FS_FATFS_DEFERRED_MOUNT == 2
+    mount_state = MOUNT_RUNNING;
+    pthread_t thread;
+    if(pthread_create(&thread, NULL, mount_thread, NULL) == 0) {
+        pthread_detach(thread);
+    }
+    else {
+        LV_LOG_WARN("lv_fs_if_fatfs_init: couldn't create the mount thread, mounting now");
+        mount_run();
+    }
+#endif
 
     /*---------------------------------------------------
      * Register the file system interface  in LittlevGL
@@ -76,19 +229,159 @@ void lv_fs_if_fatfs_init(void)
     fs_drv.dir_read_cb = fs_dir_read;
 
     lv_fs_drv_register(&fs_drv);
+
+    LV_FS_IF_POOL_INIT(file_pool, LV_FS_IF_FILE_POOL_SIZE);
+    LV_FS_IF_POOL_INIT(dir_pool, LV_FS_IF_DIR_POOL_SIZE);
+
+    static lv_fs_if_ext_t fs_ext;
+    fs_ext.flush_cb = fs_flush;
+    fs_ext.advise_cb = fs_advise;
+    fs_ext.readv_cb = fs_readv;
+    fs_ext.dir_read_batch_cb = fs_dir_read_batch;
+    fs_ext.file_pool = &file_pool;
+    fs_ext.dir_pool = &dir_pool;
+#if FF_FS_REENTRANT
+    fs_ext.thread_safe = true;      /*FatFS locks the volume*/
+#endif
+    lv_fs_if_set_ext(&fs_drv, &fs_ext);
+}
+
+/**
+ * Get the state of the deferred mount. Used by `lv_fs_if_get_init_stat()`.
+ * @param time_us store the duration of `fs_init()` here (0 if it's not deferred or not finished)
+ * @return LV_FS_RES_OK, LV_FS_RES_BUSY if it's not finished or the error of `fs_init()`
+ */
+lv_fs_res_t lv_fs_if_fatfs_get_mount(uint32_t * time_us)
+{
+#if LV_FS_FATFS_DEFERRED_MOUNT
+    lv_fs_res_t res = LV_FS_RES_BUSY;
+    *time_us = 0;
+#if LV_FS_FATFS_DEFERRED_MOUNT == 2
+    pthread_mutex_lock(&mount_lock);
+#endif
+    if(mount_state == MOUNT_DONE) {
+        res = mount_res;
+        *time_us = mount_us;
+    }
+#if LV_FS_FATFS_DEFERRED_MOUNT == 2
+    pthread_mutex_unlock(&mount_lock);
+#endif
+    return res;
+#else
+    *time_us = 0;
+    return LV_FS_RES_OK;
+#endif
 }
 
+#if LV_FS_IF_DIRECT
+/**
+ * Read from a file without `lv_fs_read()`. Used by `lv_fs_if_direct_read()`.
+ * @param file_p the `file_d` of a file opened on this driver
+ * @param buf pointer to a memory block where to store the read data
+ * @param btr number of Bytes To Read
+ * @param br the real number of read bytes (Byte Read)
+ * @return LV_FS_RES_OK or any error from lv_fs_res_t enum
+ */
+lv_fs_res_t lv_fs_if_fatfs_read(void * file_p, void * buf, uint32_t btr, uint32_t * br)
+{
+    return fs_read(NULL, file_p, buf, btr, br);
+}
+
+/**
+ * Set the read write pointer without `lv_fs_seek()`. Used by `lv_fs_if_direct_seek()`.
+ * @param file_p the `file_d` of a file opened on this driver
+ * @param pos the new position of read write pointer
+ * @param whence LV_FS_SEEK_SET, LV_FS_SEEK_CUR or LV_FS_SEEK_END
+ * @return LV_FS_RES_OK or any error from lv_fs_res_t enum
+ */
+lv_fs_res_t lv_fs_if_fatfs_seek(void * file_p, uint32_t pos, lv_fs_whence_t whence)
+{
+    return fs_seek(NULL, file_p, pos, whence);
+}
+
+/**
+ * Give the position of the read write pointer without `lv_fs_tell()`. Used by `lv_fs_if_direct_tell()`.
+ * @param file_p the `file_d` of a file opened on this driver
+ * @param pos_p pointer to to store the result
+ * @return LV_FS_RES_OK or any error from lv_fs_res_t enum
+ */
+lv_fs_res_t lv_fs_if_fatfs_tell(void * file_p, uint32_t * pos_p)
+{
+    return fs_tell(NULL, file_p, pos_p);
+}
+#endif
+
 /**********************
  *   STATIC FUNCTIONS
  **********************/
 
 /* Initialize your Storage device and File system. */
-static void fs_init(void)
+static lv_fs_res_t fs_init(void)
 {
     /* Initialize the SD card and FatFS itself.
      * Better to do it in your code to keep this library utouched for easy updating*/
+    return LV_FS_RES_OK;
+}
+
+#if LV_FS_FATFS_DEFERRED_MOUNT
+/**
+ * Run `fs_init()` and save its result and duration
+ */
+static void mount_run(void)
+{
+    uint32_t t = lv_fs_if_time_us();
+    lv_fs_res_t res = fs_init();
+    t = lv_fs_if_time_us() - t;
+    LV_LOG_INFO("lv_fs_if: FATFS mounted in %u us (res: %d)", (unsigned)t, res);
+
+#if LV_FS_FATFS_DEFERRED_MOUNT == 2
+    pthread_mutex_lock(&mount_lock);
+#endif
+    mount_res = res;
+    mount_us = t;
+    mount_state = MOUNT_DONE;
+#if LV_FS_FATFS_DEFERRED_MOUNT == 2
+    pthread_cond_broadcast(&mount_cond);
+    pthread_mutex_unlock(&mount_lock);
+#endif
+}
+
+/**
+ * Mount on the first call or wait for the mount thread
+ * @return the result of `fs_init()`
+ */
+static lv_fs_res_t mount_wait(void)
+{
+#if LV_FS_FATFS_DEFERRED_MOUNT == 1
+    if(mount_state == MOUNT_NONE) {
+        mount_state = MOUNT_RUNNING;
+        mount_run();
+    }
+    return mount_res;
+#else
+    pthread_mutex_lock(&mount_lock);
+    while(mount_state != MOUNT_DONE) pthread_cond_wait(&mount_cond, &mount_lock);
+    lv_fs_res_t res = mount_res;
+    pthread_mutex_unlock(&mount_lock);
+    return res;
+#endif
 }
 
+#if LV_FS_FATFS_DEFERRED_MOUNT == 2
+/**
+ * Mount the card without blocking `lv_fs_if_init()`
+ * @param arg unused
+ * @return NULL
+ */
+static void * mount_thread(void * arg)
+{
+    (void) arg;     /*Unused*/
+    mount_run();
+    return NULL;
+}
+#endif
+#endif
+
 /**
  * Open a file
  * @param drv pointer to a driver where this function belongs
@@ -99,24 +392,55 @@ static void fs_init(void)
  */
 static void * fs_open (lv_fs_drv_t * drv, const char * path, lv_fs_mode_t mode)
 {
+#if LV_FS_FATFS_DEFERRED_MOUNT
+    if(mount_wait() != LV_FS_RES_OK) return NULL;
+#endif
+
     uint8_t flags = 0;
 
     if(mode == LV_FS_MODE_WR) flags = FA_WRITE | FA_OPEN_ALWAYS;
     else if(mode == LV_FS_MODE_RD) flags = FA_READ;
     else if(mode == (LV_FS_MODE_WR | LV_FS_MODE_RD)) flags = FA_READ | FA_WRITE | FA_OPEN_ALWAYS;
 
-    FIL * f = lv_mem_alloc(sizeof(FIL));
+#if LV_FS_FATFS_HANDLE_MAX
+    fatfs_file_t * vf = lv_fs_if_pool_alloc(&file_pool);
+    if(vf == NULL) return NULL;
+
+    vf->path = lv_mem_alloc(strlen(path) + 1);
+    if(vf->path == NULL) {
+        lv_fs_if_pool_free(&file_pool, vf);
+        return NULL;
+    }
+    strcpy(vf->path, path);
+    vf->flags = flags;
+    vf->fil = NULL;
+    vf->pos = 0;
+    vf->busy = 0;
+
+    /*Open it right away to report the errors here. Reopening mustn't create the file again*/
+    FIL * f = fil_get(vf);
+    vf->flags &= ~FA_OPEN_ALWAYS;
+    if(f) {
+        fil_put(vf);
+        return vf;
+    }
+
+    lv_mem_free(vf->path);
+    lv_fs_if_pool_free(&file_pool, vf);
+    return NULL;
+#else
+    FIL * f = lv_fs_if_pool_alloc(&file_pool);
     if(f == NULL) return NULL;
 
-    FRESULT res = f_open(f, path, flags);
+    FRESULT res = fil_open(f, path, flags);
 
     if(res == FR_OK) {
-    	f_lseek(f, 0);
     	return f;
     } else {
-        lv_mem_free(f);
+        lv_fs_if_pool_free(&file_pool, f);
     	return NULL;
     }
+#endif
 }
 
 
@@ -129,8 +453,17 @@ static void * fs_open (lv_fs_drv_t * drv, const char * path, lv_fs_mode_t mode)
  */
 static lv_fs_res_t fs_close (lv_fs_drv_t * drv, void * file_p)
 {
-    f_close(file_p);
-    lv_mem_free(file_p);
+#if LV_FS_FATFS_HANDLE_MAX
+    fatfs_file_t * vf = file_p;
+    SLOT_LOCK();
+    fil_release(vf);
+    SLOT_SIGNAL();
+    SLOT_UNLOCK();
+    lv_mem_free(vf->path);
+#else
+    fil_close(file_p);
+#endif
+    lv_fs_if_pool_free(&file_pool, file_p);
     return LV_FS_RES_OK;
 }
 
@@ -146,7 +479,11 @@ static lv_fs_res_t fs_close (lv_fs_drv_t * drv, void * file_p)
  */
 static lv_fs_res_t fs_read (lv_fs_drv_t * drv, void * file_p, void * buf, uint32_t btr, uint32_t * br)
 {
-    FRESULT res = f_read(file_p, buf, btr, (UINT*)br);
+    FIL * f = FIL_GET(file_p);
+    if(f == NULL) return LV_FS_RES_UNKNOWN;
+
+    FRESULT res = f_read(f, buf, btr, (UINT*)br);
+    FIL_PUT(file_p);
     if(res == FR_OK) return LV_FS_RES_OK;
     else return LV_FS_RES_UNKNOWN;
 }
@@ -162,7 +499,11 @@ static lv_fs_res_t fs_read (lv_fs_drv_t * drv, void * file_p, void * buf, uint32
  */
 static lv_fs_res_t fs_write(lv_fs_drv_t * drv, void * file_p, const void * buf, uint32_t btw, uint32_t * bw)
 {
-	FRESULT res = f_write(file_p, buf, btw, (UINT*)bw);
+    FIL * f = FIL_GET(file_p);
+    if(f == NULL) return LV_FS_RES_UNKNOWN;
+
+	FRESULT res = f_write(f, buf, btw, (UINT*)bw);
+    FIL_PUT(file_p);
     if(res == FR_OK) return LV_FS_RES_OK;
     else return LV_FS_RES_UNKNOWN;
 }
@@ -178,21 +519,52 @@ static lv_fs_res_t fs_write(lv_fs_drv_t * drv, void * file_p, const void * buf,
  */
 static lv_fs_res_t fs_seek (lv_fs_drv_t * drv, void * file_p, uint32_t pos, lv_fs_whence_t whence)
 {
+#if LV_FS_FATFS_HANDLE_MAX
+    /*Don't reopen a closed file only to seek. The position is applied when it's reopened*/
+    fatfs_file_t * vf = file_p;
+    fil_pin(vf);
+    if(vf->fil == NULL) {
+        switch (whence)
+        {
+        case LV_FS_SEEK_SET:
+            vf->pos = pos;
+            break;
+        case LV_FS_SEEK_CUR:
+            vf->pos += pos;
+            break;
+        case LV_FS_SEEK_END:
+            vf->pos = vf->size + pos;
+            break;
+        default:
+            break;
+        }
+        fil_put(vf);
+        return LV_FS_RES_OK;
+    }
+    FIL * f = vf->fil;
+#else
+    FIL * f = file_p;
+#endif
+
+    FRESULT res;
     switch (whence)
     {
     case LV_FS_SEEK_SET:
-        f_lseek(file_p, pos);
+        res = f_lseek(f, pos);
         break;
     case LV_FS_SEEK_CUR:
-        f_lseek(file_p, f_tell((FIL *)file_p) + pos);
+        res = f_lseek(f, f_tell(f) + pos);
         break;
     case LV_FS_SEEK_END:
-        f_lseek(file_p, f_size((FIL *)file_p) + pos);
+        res = f_lseek(f, f_size(f) + pos);
         break;
     default:
+        res = FR_INVALID_PARAMETER;
         break;
     }
-    return LV_FS_RES_OK;
+    FIL_PUT(file_p);
+    if(res == FR_OK) return LV_FS_RES_OK;
+    else return LV_FS_RES_UNKNOWN;
 }
 
 /**
@@ -205,10 +577,124 @@ static lv_fs_res_t fs_seek (lv_fs_drv_t * drv, void * file_p, uint32_t pos, lv_f
  */
 static lv_fs_res_t fs_tell (lv_fs_drv_t * drv, void * file_p, uint32_t * pos_p)
 {
+#if LV_FS_FATFS_HANDLE_MAX
+    fatfs_file_t * vf = file_p;
+    fil_pin(vf);
+    *pos_p = vf->fil ? f_tell(vf->fil) : vf->pos;
+    fil_put(vf);
+#else
 	*pos_p = f_tell(((FIL *)file_p));
+#endif
     return LV_FS_RES_OK;
 }
 
+/**
+ * Write the cached data of a file to the disk with `f_sync`
+ * @param drv pointer to a driver where this function belongs
+ * @param file_p pointer to a FIL variable
+ * @return LV_FS_RES_OK or any error from lv_fs_res_t enum
+ */
+static lv_fs_res_t fs_flush(lv_fs_drv_t * drv, void * file_p)
+{
+#if LV_FS_FATFS_HANDLE_MAX
+    /*A closed file has no cached data*/
+    fatfs_file_t * vf = file_p;
+    fil_pin(vf);
+    FRESULT res = vf->fil ? f_sync(vf->fil) : FR_OK;
+    fil_put(vf);
+#else
+    FRESULT res = f_sync(file_p);
+#endif
+    if(res == FR_OK) return LV_FS_RES_OK;
+    else return LV_FS_RES_UNKNOWN;
+}
+
+/**
+ * Adapt the fast seek of a file to an advice. FatFS has no read-ahead, so only the cluster link map
+ * table can be kept or dropped: RANDOM and WILLNEED create it (for files opened only for reading)
+ * and keep it cached longer, SEQUENTIAL and DONTNEED don't need it as `f_read` follows the FAT chain anyway.
+ * @param drv pointer to a driver where this function belongs
+ * @param file_p pointer to a FIL variable
+ * @param ofs unused, the table covers the whole file
+ * @param len unused
+ * @param advice how the file will be read
+ * @return LV_FS_RES_OK
+ */
+static lv_fs_res_t fs_advise(lv_fs_drv_t * drv, void * file_p, uint32_t ofs, uint32_t len, lv_fs_if_advice_t advice)
+{
+#if LV_FS_FATFS_FASTSEEK
+    FIL * f = FIL_GET(file_p);
+    if(f == NULL) return LV_FS_RES_UNKNOWN;
+
+    /*The tables are attached and detached by the reopens on other threads too*/
+    SLOT_LOCK();
+    clmt_entry_t * e;
+    switch(advice) {
+    case LV_FS_IF_ADVICE_RANDOM:
+    case LV_FS_IF_ADVICE_WILLNEED:
+        if(f->cltbl == NULL && !(f->flag & FA_WRITE)) clmt_attach(f);
+        e = clmt_find(f);
+        if(e) e->hot = 1;
+        break;
+    case LV_FS_IF_ADVICE_SEQUENTIAL:
+        e = clmt_find(f);
+        if(e) e->hot = 0;
+        clmt_detach(f);
+        break;
+    case LV_FS_IF_ADVICE_DONTNEED:
+        /*Free the table right away if no other file uses it*/
+        e = clmt_find(f);
+        clmt_detach(f);
+        if(e && e->tbl && e->ref_cnt == 0) clmt_drop(e);
+        break;
+    default:
+        e = clmt_find(f);
+        if(e) e->hot = 0;
+        break;
+    }
+    SLOT_UNLOCK();
+    FIL_PUT(file_p);
+#else
+    (void) file_p;  /*Unused*/
+    (void) advice;  /*Unused*/
+#endif
+    return LV_FS_RES_OK;
+}
+
+/**
+ * Read several parts of a file without changing its position.
+ * `f_lseek` is called only if a segment doesn't continue the previous one.
+ * @param drv pointer to a driver where this function belongs
+ * @param file_p pointer to a FIL variable
+ * @param segs the segments sorted by offset
+ * @param cnt number of segments
+ * @return LV_FS_RES_OK or any error from lv_fs_res_t enum
+ */
+static lv_fs_res_t fs_readv(lv_fs_drv_t * drv, void * file_p, lv_fs_if_seg_t * segs, uint32_t cnt)
+{
+    FIL * f = FIL_GET(file_p);
+    if(f == NULL) return LV_FS_RES_UNKNOWN;
+    FSIZE_t pos_ori = f_tell(f);
+    FRESULT res = FR_OK;
+
+    uint32_t i;
+    for(i = 0; i < cnt && res == FR_OK; i++) {
+        /*Seeking beyond the end would expand the files opened for writing*/
+        if(segs[i].ofs >= f_size(f)) break;
+        if(f_tell(f) != segs[i].ofs) res = f_lseek(f, segs[i].ofs);
+        if(res == FR_OK) res = f_read(f, segs[i].buf, segs[i].len, (UINT *)&segs[i].br);
+    }
+
+    if(f_tell(f) != pos_ori) {
+        FRESULT seek_res = f_lseek(f, pos_ori);
+        if(res == FR_OK) res = seek_res;
+    }
+    FIL_PUT(file_p);
+
+    if(res == FR_OK) return LV_FS_RES_OK;
+    else return LV_FS_RES_UNKNOWN;
+}
+
 /**
  * Initialize a 'fs_read_dir_t' variable for directory reading
  * @param drv pointer to a driver where this function belongs
@@ -218,12 +704,16 @@ static lv_fs_res_t fs_tell (lv_fs_drv_t * drv, void * file_p, uint32_t * pos_p)
  */
 static void * fs_dir_open (lv_fs_drv_t * drv, const char *path)
 {
-    DIR * d = lv_mem_alloc(sizeof(DIR));
+#if LV_FS_FATFS_DEFERRED_MOUNT
+    if(mount_wait() != LV_FS_RES_OK) return NULL;
+#endif
+
+    DIR * d = lv_fs_if_pool_alloc(&dir_pool);
     if(d == NULL) return NULL;
 
     FRESULT res = f_opendir(d, path);
     if(res != FR_OK) {
-        lv_mem_free(d);
+        lv_fs_if_pool_free(&dir_pool, d);
         d = NULL;
     }
     return d;
@@ -258,6 +748,57 @@ static lv_fs_res_t fs_dir_read (lv_fs_drv_t * drv, void * dir_p, char *fn)
     return LV_FS_RES_OK;
 }
 
+/**
+ * Read the next entries of a directory with the size and time `f_readdir` provides anyway
+ * @param drv pointer to a driver where this function belongs
+ * @param dir_p pointer to a DIR
+ * @param batch pointer to an empty batch to fill
+ * @return LV_FS_RES_OK or any error from lv_fs_res_t enum
+ */
+static lv_fs_res_t fs_dir_read_batch(lv_fs_drv_t * drv, void * dir_p, lv_fs_if_dir_batch_t * batch)
+{
+    FILINFO fno;
+    while(lv_fs_if_dir_batch_has_room(batch)) {
+        FRESULT res = f_readdir(dir_p, &fno);
+        if(res != FR_OK) return LV_FS_RES_UNKNOWN;
+        if(fno.fname[0] == '\0') break;
+        if(strcmp(fno.fname, ".") == 0 || strcmp(fno.fname, "..") == 0) continue;
+
+        lv_fs_if_dirent_t * e = lv_fs_if_dir_batch_add(batch, fno.fname, strlen(fno.fname));
+        if(e == NULL) return LV_FS_RES_UNKNOWN;    /*Longer than LV_FS_IF_DIRENT_NAME_MAX*/
+
+        e->type = (fno.fattrib & AM_DIR) ? LV_FS_IF_DIRENT_DIR : LV_FS_IF_DIRENT_FILE;
+        if(!(fno.fattrib & AM_DIR)) e->size = fno.fsize;
+        e->mtime = fat_time_to_unix(fno.fdate, fno.ftime);
+    }
+
+    return LV_FS_RES_OK;
+}
+
+/**
+ * Convert a FAT time stamp to Unix time. FAT stores the local time without time zone.
+ * @param fdate date in FAT format
+ * @param ftime time in FAT format
+ * @return seconds since 1970
+ */
+static uint32_t fat_time_to_unix(WORD fdate, WORD ftime)
+{
+    uint32_t y = 1980 + (fdate >> 9);
+    uint32_t m = (fdate >> 5) & 0xF;
+    uint32_t d = fdate & 0x1F;
+    if(m < 1 || m > 12 || d < 1) return 0;
+
+    /*Days since 1970 counting the years from March so the leap day is at the end*/
+    if(m <= 2) y--;
+    uint32_t era = y / 400;
+    uint32_t yoe = y - era * 400;
+    uint32_t doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+    uint32_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    uint32_t days = era * 146097 + doe - 719468;
+
+    return days * 86400 + (ftime >> 11) * 3600 + ((ftime >> 5) & 0x3F) * 60 + (ftime & 0x1F) * 2;
+}
+
 /**
  * Close the directory reading
  * @param drv pointer to a driver where this function belongs
@@ -267,9 +808,288 @@ static lv_fs_res_t fs_dir_read (lv_fs_drv_t * drv, void * dir_p, char *fn)
 static lv_fs_res_t fs_dir_close (lv_fs_drv_t * drv, void * dir_p)
 {
 	f_closedir(dir_p);
-    lv_mem_free(dir_p);
+    lv_fs_if_pool_free(&dir_pool, dir_p);
     return LV_FS_RES_OK;
 }
 
+/**
+ * Open a FIL and attach a link map table if it's read only.
+ * If it's opened for writing the cached tables of the file are invalidated.
+ * @param f pointer to a FIL
+ * @param path path to the file
+ * @param flags the mode flags of `f_open`
+ * @return the result of `f_open`
+ */
+static FRESULT fil_open(FIL * f, const char * path, BYTE flags)
+{
+    FRESULT res = f_open(f, path, flags);
+    if(res != FR_OK) return res;
+
+    f_lseek(f, 0);
+#if LV_FS_FATFS_FASTSEEK
+    if(flags == FA_READ) clmt_attach(f);
+    else if(flags & FA_WRITE) clmt_invalidate(f);
+#endif
+    return FR_OK;
+}
+
+/**
+ * Close a FIL opened with `fil_open()`
+ * @param f pointer to a FIL
+ */
+static void fil_close(FIL * f)
+{
+#if LV_FS_FATFS_FASTSEEK
+    clmt_detach(f);
+    /*Writing might have changed the cluster chain (an empty file got its first cluster)*/
+    if(f->flag & FA_WRITE) clmt_invalidate(f);
+#endif
+    f_close(f);
+}
+
+#if LV_FS_FATFS_HANDLE_MAX
+/**
+ * Get the FIL of a file and keep it open until `fil_put()`. If it was closed it's reopened and
+ * sought to its last position, closing the least recently used idle file if all slots are used.
+ * @param vf pointer to a file
+ * @return pointer to the FIL or NULL if the file couldn't be reopened
+ */
+static FIL * fil_get(fatfs_file_t * vf)
+{
+    SLOT_LOCK();
+    vf->last_use = ++fil_tick;
+    vf->busy++;
+
+    if(vf->fil == NULL) {
+        int32_t slot = fil_find_slot();
+#if LV_FS_IF_ASYNC || LV_FS_IF_PREFETCH
+        /*All the open files are used by other threads, wait until one is done*/
+        while(slot < 0) {
+            pthread_cond_wait(&slot_cond, &slot_lock);
+            slot = fil_find_slot();
+        }
+#endif
+        if(slot >= 0) {
+            if(fil_owners[slot]) fil_release(fil_owners[slot]);
+
+            FIL * f = &fil_slots[slot];
+            if(fil_open(f, vf->path, vf->flags) == FR_OK) {
+                if(vf->pos == 0 || f_lseek(f, vf->pos) == FR_OK) {
+                    fil_owners[slot] = vf;
+                    vf->fil = f;
+                }
+                else {
+                    fil_close(f);
+                }
+            }
+        }
+    }
+
+    FIL * f = vf->fil;
+    if(f == NULL) vf->busy--;
+    SLOT_UNLOCK();
+    return f;
+}
+
+/**
+ * Keep the FIL of a file open or closed as it is until `fil_put()`
+ * @param vf pointer to a file
+ */
+static void fil_pin(fatfs_file_t * vf)
+{
+    SLOT_LOCK();
+    vf->last_use = ++fil_tick;
+    vf->busy++;
+    SLOT_UNLOCK();
+}
+
+/**
+ * Release a file kept by `fil_get()` or `fil_pin()`. Its FIL can be closed for other files again.
+ * @param vf pointer to a file
+ */
+static void fil_put(fatfs_file_t * vf)
+{
+    SLOT_LOCK();
+    vf->busy--;
+    if(vf->busy == 0) {
+        SLOT_SIGNAL();      /*Its slot can be taken by a waiting thread now*/
+    }
+    SLOT_UNLOCK();
+}
+
+/**
+ * Find a slot for a file to open. Called with the slots locked.
+ * @return index of a free slot or the slot of the least recently used idle file, -1 if all files are busy
+ */
+static int32_t fil_find_slot(void)
+{
+    int32_t slot = -1;
+    uint32_t i;
+    for(i = 0; i < LV_FS_FATFS_HANDLE_MAX; i++) {
+        if(fil_owners[i] == NULL) return i;
+        if(fil_owners[i]->busy) continue;
+        if(slot < 0 || fil_owners[i]->last_use < fil_owners[slot]->last_use) slot = i;
+    }
+    return slot;
+}
+
+/**
+ * Close the FIL of a file to free its slot. The position and size are saved to reopen it later.
+ * Called with the slots locked.
+ * @param vf pointer to a file
+ */
+static void fil_release(fatfs_file_t * vf)
+{
+    FIL * f = vf->fil;
+    if(f == NULL) return;
+
+    vf->pos = f_tell(f);
+    vf->size = f_size(f);
+    fil_close(f);
+    fil_owners[f - fil_slots] = NULL;
+    vf->fil = NULL;
+}
+#endif
+
+#if LV_FS_FATFS_FASTSEEK
+/**
+ * Give a cluster link map table to a file opened for reading.
+ * A cached table is reused if the same file was opened before, else a new one is created.
+ * If the table doesn't fit into LV_FS_FATFS_FASTSEEK_BUDGET the file is used without fast seek.
+ * @param f pointer to an opened FIL
+ */
+static void clmt_attach(FIL * f)
+{
+    clmt_tick++;
+
+    uint32_t i;
+    for(i = 0; i < LV_FS_FATFS_FASTSEEK_CACHE_CNT; i++) {
+        clmt_entry_t * e = &clmt_cache[i];
+        if(e->tbl && e->fs == f->obj.fs && e->sclust == f->obj.sclust && e->size == f_size(f)) {
+            e->ref_cnt++;
+            e->last_use = clmt_tick;
+            f->cltbl = e->tbl;
+            return;
+        }
+    }
+
+    /*Ask FatFS for the required table size*/
+    DWORD probe = 1;
+    f->cltbl = &probe;
+    FRESULT res = f_lseek(f, CREATE_LINKMAP);
+    f->cltbl = NULL;
+    if(res != FR_NOT_ENOUGH_CORE || probe > LV_FS_FATFS_FASTSEEK_BUDGET) return;
+
+    /*Free the least recently used, unused tables (the ones not advised as hot first) until the new one fits*/
+    clmt_entry_t * slot = NULL;
+    while(1) {
+        clmt_entry_t * lru = NULL;
+        for(i = 0; i < LV_FS_FATFS_FASTSEEK_CACHE_CNT; i++) {
+            clmt_entry_t * e = &clmt_cache[i];
+            if(e->tbl == NULL) {
+                if(slot == NULL) slot = e;
+            }
+            else if(e->ref_cnt == 0 && (lru == NULL || e->hot < lru->hot ||
+                                        (e->hot == lru->hot && e->last_use < lru->last_use))) {
+                lru = e;
+            }
+        }
+
+        if(slot && clmt_used + probe <= LV_FS_FATFS_FASTSEEK_BUDGET) break;
+        if(lru == NULL) return;     /*All tables are in use*/
+
+        clmt_drop(lru);
+    }
+
+    DWORD * tbl = lv_mem_alloc(probe * sizeof(DWORD));
+    if(tbl == NULL) return;
+    tbl[0] = probe;
+
+    f->cltbl = tbl;
+    res = f_lseek(f, CREATE_LINKMAP);
+    if(res != FR_OK) {
+        f->cltbl = NULL;
+        lv_mem_free(tbl);
+        return;
+    }
+
+    /*f_lseek stored the number of used items in tbl[0]: keep the allocated size there*/
+    tbl[0] = probe;
+    slot->fs = f->obj.fs;
+    slot->sclust = f->obj.sclust;
+    slot->size = f_size(f);
+    slot->tbl = tbl;
+    slot->ref_cnt = 1;
+    slot->last_use = clmt_tick;
+    slot->hot = 0;
+    clmt_used += probe;
+}
+
+/**
+ * Release the link map table of a file. The table stays cached for the next open.
+ * @param f pointer to an opened FIL
+ */
+static void clmt_detach(FIL * f)
+{
+    if(f->cltbl == NULL) return;
+
+    uint32_t i;
+    for(i = 0; i < LV_FS_FATFS_FASTSEEK_CACHE_CNT; i++) {
+        clmt_entry_t * e = &clmt_cache[i];
+        if(e->tbl == f->cltbl) {
+            e->ref_cnt--;
+            if(e->ref_cnt == 0 && e->fs == NULL) clmt_drop(e);
+            break;
+        }
+    }
+    f->cltbl = NULL;
+}
+
+/**
+ * Invalidate the cached link map tables of a file which is written.
+ * Unused tables are freed, the ones still used by open files are freed when they are detached.
+ * @param f pointer to a FIL opened for writing
+ */
+static void clmt_invalidate(const FIL * f)
+{
+    uint32_t i;
+    for(i = 0; i < LV_FS_FATFS_FASTSEEK_CACHE_CNT; i++) {
+        clmt_entry_t * e = &clmt_cache[i];
+        if(e->tbl == NULL || e->fs != f->obj.fs || e->sclust != f->obj.sclust) continue;
+
+        if(e->ref_cnt == 0) clmt_drop(e);
+        else e->fs = NULL;
+    }
+}
+
+/**
+ * Free a cached link map table
+ * @param e pointer to a used cache entry
+ */
+static void clmt_drop(clmt_entry_t * e)
+{
+    clmt_used -= e->tbl[0];
+    lv_mem_free(e->tbl);
+    e->tbl = NULL;
+}
+
+/**
+ * Get the cache entry of the link map table of a file
+ * @param f pointer to an opened FIL
+ * @return pointer to the entry or NULL if the file has no table
+ */
+static clmt_entry_t * clmt_find(const FIL * f)
+{
+    if(f->cltbl == NULL) return NULL;
+
+    uint32_t i;
+    for(i = 0; i < LV_FS_FATFS_FASTSEEK_CACHE_CNT; i++) {
+        if(clmt_cache[i].tbl == f->cltbl) return &clmt_cache[i];
+    }
+
+    return NULL;
+}
+#endif
+
 #endif	/*LV_USE_FS_IF*/
 #endif  /*LV_FS_IF_FATFS*/
@@ -7,9 +7,14 @@
  *      INCLUDES
  *********************/
 #include "lv_fs_if.h"
+#include <string.h>
 
 #if LV_USE_FS_IF
 
+#if !defined(LV_FS_IF_TIME_US) && !defined(WIN32)
+#include <time.h>
+#endif
+
 /*********************
  *      DEFINES
  *********************/
@@ -17,12 +22,29 @@
 /**********************
  *      TYPEDEFS
  **********************/
+typedef struct {
+    lv_fs_drv_t * drv;
+    const lv_fs_if_ext_t * ext;
+} ext_dsc_t;
+
+typedef struct {
+    char letter;
+    uint32_t init_us;
+} init_dsc_t;
+
+typedef struct {
+    const void * ptr;
+    uint32_t size;
+    lv_fs_drv_t * drv;      /*The driver which mapped the file or NULL if it was read into a buffer*/
+    void * map_d;
+} map_dsc_t;
 
 /**********************
  *  STATIC PROTOTYPES
  **********************/
 #if LV_FS_IF_FATFS != '\0'
 void lv_fs_if_fatfs_init(void);
+lv_fs_res_t lv_fs_if_fatfs_get_mount(uint32_t * time_us);
 #endif
 
 #if LV_FS_IF_PC != '\0'
@@ -34,9 +56,45 @@ void lv_fs_if_pc_init(void);
 void lv_fs_if_posix_init(void);
 #endif
 
+#if LV_FS_IF_ARCHIVE != '\0'
+void lv_fs_if_archive_init(void);
+#endif
+
+#if LV_FS_IF_RAM != '\0'
+void lv_fs_if_ram_init(void);
+#endif
+
+#if LV_FS_IF_CACHE != '\0'
+void lv_fs_if_cache_init(void);
+#endif
+
+#if LV_FS_IF_ASYNC
+void lv_fs_if_async_init(void);
+#endif
+
+#if LV_FS_IF_TRACE
+void lv_fs_if_trace_init(void);
+#endif
+
+#if LV_FS_IF_PREFETCH
+void lv_fs_if_prefetch_init(void);
+#endif
+
+static void init_dsc_add(char letter, uint32_t t_start);
+static lv_fs_res_t map_buffered(const char * path, const void ** ptr, uint32_t * size);
+static void seg_sort(lv_fs_if_seg_t * segs, uint32_t cnt);
+static lv_fs_res_t readv_loop(lv_fs_file_t * file, lv_fs_if_seg_t * segs, uint32_t cnt);
+static lv_fs_res_t dir_read_loop(lv_fs_dir_t * dir, lv_fs_if_dir_batch_t * batch);
+#if LV_FS_IF_STATS && LV_FS_IF_STATS_DUMP_PERIOD
+static void stats_dump_timer_cb(lv_timer_t * t);
+#endif
+
 /**********************
  *  STATIC VARIABLES
  **********************/
+static ext_dsc_t ext_dsc[LV_FS_IF_EXT_MAX];
+static init_dsc_t init_dsc[LV_FS_IF_EXT_MAX];
+static lv_ll_t map_ll;
 
 /**********************
  *      MACROS
@@ -51,22 +109,527 @@ void lv_fs_if_posix_init(void);
  */
 void lv_fs_if_init(void)
 {
+    _lv_ll_init(&map_ll, sizeof(map_dsc_t));
+    uint32_t t;
+    (void) t;   /*Unused if no driver is enabled*/
+
 #if LV_FS_IF_FATFS != '\0'
+    t = lv_fs_if_time_us();
 	lv_fs_if_fatfs_init();
+    init_dsc_add(LV_FS_IF_FATFS, t);
+#if LV_FS_IF_HOOK
+    lv_fs_if_hook_attach(lv_fs_get_drv(LV_FS_IF_FATFS));
+#endif
 #endif
 
 #if LV_FS_IF_PC != '\0'
+    t = lv_fs_if_time_us();
 	lv_fs_if_pc_init();
+    init_dsc_add(LV_FS_IF_PC, t);
+#if LV_FS_IF_HOOK
+    lv_fs_if_hook_attach(lv_fs_get_drv(LV_FS_IF_PC));
+#endif
 #endif
 
 #if LV_FS_IF_POSIX != '\0'
+    t = lv_fs_if_time_us();
     lv_fs_if_posix_init();
+    init_dsc_add(LV_FS_IF_POSIX, t);
+#if LV_FS_IF_HOOK
+    lv_fs_if_hook_attach(lv_fs_get_drv(LV_FS_IF_POSIX));
+#endif
 #endif
 
+#if LV_FS_IF_ARCHIVE != '\0'
+    t = lv_fs_if_time_us();
+    lv_fs_if_archive_init();
+    init_dsc_add(LV_FS_IF_ARCHIVE, t);
+#if LV_FS_IF_HOOK
+    lv_fs_if_hook_attach(lv_fs_get_drv(LV_FS_IF_ARCHIVE));
+#endif
+#endif
+
+    /*Registered last so it can preload files from the other drivers*/
+#if LV_FS_IF_RAM != '\0'
+    t = lv_fs_if_time_us();
+    lv_fs_if_ram_init();
+    init_dsc_add(LV_FS_IF_RAM, t);
+#if LV_FS_IF_HOOK
+    lv_fs_if_hook_attach(lv_fs_get_drv(LV_FS_IF_RAM));
+#endif
+#endif
+
+    /*Needs its backend to be registered. The hooks are attached by `lv_fs_if_cache_add()`*/
+#if LV_FS_IF_CACHE != '\0'
+    t = lv_fs_if_time_us();
+    lv_fs_if_cache_init();
+    init_dsc_add(LV_FS_IF_CACHE, t);
+#endif
+
+#if LV_FS_IF_ASYNC
+    lv_fs_if_async_init();
+#endif
+
+    /*The calls are traced since the drivers were wrapped, the trace file is opened when they are ready*/
+#if LV_FS_IF_TRACE
+    lv_fs_if_trace_init();
+#endif
+
+    /*Last so the reads of the other drivers while initializing are not recorded*/
+#if LV_FS_IF_PREFETCH
+    lv_fs_if_prefetch_init();
+#endif
+
+#if LV_FS_IF_STATS && LV_FS_IF_STATS_DUMP_PERIOD
+    lv_timer_create(stats_dump_timer_cb, LV_FS_IF_STATS_DUMP_PERIOD, NULL);
+#endif
+}
+
+/**
+ * Get how long the initialization of a driver took
+ * @param letter the letter of a driver registered by `lv_fs_if_init()`
+ * @param stat pointer to store the timings
+ * @return LV_FS_RES_OK, LV_FS_RES_NOT_EX if the driver is not registered by `lv_fs_if_init()`
+ */
+lv_fs_res_t lv_fs_if_get_init_stat(char letter, lv_fs_if_init_stat_t * stat)
+{
+    uint32_t i;
+    for(i = 0; i < LV_FS_IF_EXT_MAX && init_dsc[i].letter != letter; i++);
+    if(letter == '\0' || i == LV_FS_IF_EXT_MAX) return LV_FS_RES_NOT_EX;
+
+    stat->init_us = init_dsc[i].init_us;
+    stat->mount_us = 0;
+    stat->res = LV_FS_RES_OK;
+#if LV_FS_IF_FATFS != '\0'
+    if(letter == LV_FS_IF_FATFS) stat->res = lv_fs_if_fatfs_get_mount(&stat->mount_us);
+#endif
+    return LV_FS_RES_OK;
+}
+
+/**
+ * Get a monotonic time stamp. Define `LV_FS_IF_TIME_US()` in `lv_conf.h` to provide a custom source.
+ * @return time in microseconds
+ */
+uint32_t lv_fs_if_time_us(void)
+{
+#if defined(LV_FS_IF_TIME_US)
+    return LV_FS_IF_TIME_US();
+#elif !defined(WIN32)
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#else
+    return lv_tick_get() * 1000;
+#endif
+}
+
+/**
+ * Attach extra features to a registered driver
+ * @param drv pointer to a driver
+ * @param ext pointer to a static extension descriptor. Only the pointer is saved.
+ */
+void lv_fs_if_set_ext(lv_fs_drv_t * drv, const lv_fs_if_ext_t * ext)
+{
+    uint32_t i;
+    for(i = 0; i < LV_FS_IF_EXT_MAX; i++) {
+        if(ext_dsc[i].drv == drv || ext_dsc[i].drv == NULL) {
+            ext_dsc[i].drv = drv;
+            ext_dsc[i].ext = ext;
+            return;
+        }
+    }
+
+    LV_LOG_WARN("lv_fs_if_set_ext: no free slot, increase LV_FS_IF_EXT_MAX");
+}
+
+/**
+ * Get the extra features of a driver
+ * @param drv pointer to a driver
+ * @return pointer to the extension descriptor or NULL if there is none
+ */
+const lv_fs_if_ext_t * lv_fs_if_get_ext(const lv_fs_drv_t * drv)
+{
+    uint32_t i;
+    for(i = 0; i < LV_FS_IF_EXT_MAX && ext_dsc[i].drv; i++) {
+        if(ext_dsc[i].drv == drv) return ext_dsc[i].ext;
+    }
+
+    return NULL;
+}
+
+/**
+ * Get the whole content of a file as a stable, read-only pointer.
+ * If the driver can't map the file (e.g. FATFS) the file is read into an `lv_mem_alloc`ed buffer.
+ * @param path path to the file beginning with the driver letter (e.g. S:/folder/file.bin)
+ * @param ptr pointer to store the address of the content
+ * @param size pointer to store the size of the content in bytes
+ * @return LV_FS_RES_OK or any error from lv_fs_res_t enum
+ */
+lv_fs_res_t lv_fs_if_map(const char * path, const void ** ptr, uint32_t * size)
+{
+    *ptr = NULL;
+    *size = 0;
+
+    lv_fs_drv_t * drv = lv_fs_get_drv(path[0]);
+    if(drv == NULL) return LV_FS_RES_NOT_EX;
+
+    map_dsc_t * dsc = _lv_ll_ins_head(&map_ll);
+    if(dsc == NULL) return LV_FS_RES_OUT_OF_MEM;
+
+    /*Try to map the file in place first*/
+    lv_fs_res_t res = LV_FS_RES_NOT_IMP;
+    const lv_fs_if_ext_t * ext = lv_fs_if_get_ext(drv);
+    if(ext && ext->map_cb) {
+        /*Skip the driver letter and ':' the same way as LVGL does*/
+        const char * real_path = path + 1;
+        if(*real_path == ':') real_path++;
+
+        dsc->map_d = NULL;
+        res = ext->map_cb(drv, real_path, ptr, size, &dsc->map_d);
+        dsc->drv = drv;
+    }
+
+    /*Read the file into a buffer if it couldn't be mapped*/
+    if(res == LV_FS_RES_NOT_IMP) {
+        res = map_buffered(path, ptr, size);
+        dsc->drv = NULL;
+        dsc->map_d = NULL;
+    }
+
+    if(res != LV_FS_RES_OK) {
+        _lv_ll_remove(&map_ll, dsc);
+        lv_mem_free(dsc);
+        return res;
+    }
+
+    dsc->ptr = *ptr;
+    dsc->size = *size;
+    return LV_FS_RES_OK;
+}
+
+/**
+ * Release a content returned by `lv_fs_if_map()`
+ * @param ptr the pointer returned by `lv_fs_if_map()`
+ */
+void lv_fs_if_unmap(const void * ptr)
+{
+    map_dsc_t * dsc;
+    _LV_LL_READ(&map_ll, dsc) {
+        if(dsc->ptr == ptr) break;
+    }
+
+    if(dsc == NULL) {
+        LV_LOG_WARN("lv_fs_if_unmap: %p is not mapped", ptr);
+        return;
+    }
+
+    if(dsc->drv) {
+        const lv_fs_if_ext_t * ext = lv_fs_if_get_ext(dsc->drv);
+        if(ext && ext->unmap_cb) ext->unmap_cb(dsc->drv, dsc->ptr, dsc->size, dsc->map_d);
+    }
+    else {
+        lv_mem_free((void *)dsc->ptr);
+    }
+
+    _lv_ll_remove(&map_ll, dsc);
+    lv_mem_free(dsc);
+}
+
+/**
+ * Write the data buffered by the driver for an opened file to the storage.
+ * Closing a file flushes it too.
+ * @param file pointer to an opened file
+ * @return LV_FS_RES_OK (also if the driver doesn't buffer) or any error from lv_fs_res_t enum
+ */
+lv_fs_res_t lv_fs_if_flush(lv_fs_file_t * file)
+{
+    if(file->drv == NULL || file->file_d == NULL) return LV_FS_RES_INV_PARAM;
+
+    const lv_fs_if_ext_t * ext = lv_fs_if_get_ext(file->drv);
+    if(ext == NULL || ext->flush_cb == NULL) return LV_FS_RES_OK;
+
+    return ext->flush_cb(file->drv, file->file_d);
+}
+
+/**
+ * Tell the driver how a part of a file will be read so it can adapt its caching and reading ahead.
+ * It's only a hint, the reads return the same data either way.
+ * @param file pointer to an opened file
+ * @param ofs start of the part
+ * @param len length of the part. 0: until the end of the file
+ * @param advice how the part will be read
+ * @return LV_FS_RES_OK (also if the driver ignores the advice) or any error from lv_fs_res_t enum
+ */
+lv_fs_res_t lv_fs_if_advise(lv_fs_file_t * file, uint32_t ofs, uint32_t len, lv_fs_if_advice_t advice)
+{
+    if(file->drv == NULL || file->file_d == NULL) return LV_FS_RES_INV_PARAM;
+
+    const lv_fs_if_ext_t * ext = lv_fs_if_get_ext(file->drv);
+    if(ext == NULL || ext->advise_cb == NULL) return LV_FS_RES_OK;
+
+    return ext->advise_cb(file->drv, file->file_d, ofs, len, advice);
+}
+
+/**
+ * Read several parts of a file with as few seeks and system calls as the driver allows
+ * (e.g. the header, the palette and some rows of an image).
+ * The segments are read in the order of their offsets and segments continuing each other are read together.
+ * The read/write position of the file doesn't change.
+ * @param file pointer to an opened file
+ * @param segs the parts to read. They are sorted by `ofs` in place and `br` is set in each.
+ * @param cnt number of segments
+ * @return LV_FS_RES_OK (also if some segments are beyond the end of the file) or any error from lv_fs_res_t enum
+ */
+lv_fs_res_t lv_fs_if_readv(lv_fs_file_t * file, lv_fs_if_seg_t * segs, uint32_t cnt)
+{
+    if(file->drv == NULL || file->file_d == NULL) return LV_FS_RES_INV_PARAM;
+
+    uint32_t i;
+    for(i = 0; i < cnt; i++) segs[i].br = 0;
+    seg_sort(segs, cnt);
+
+    /*LVGL's own file cache tracks the position itself so the driver can't be bypassed then*/
+    const lv_fs_if_ext_t * ext = lv_fs_if_get_ext(file->drv);
+    if(ext && ext->readv_cb && file->drv->cache_size == 0) {
+        return ext->readv_cb(file->drv, file->file_d, segs, cnt);
+    }
+
+    return readv_loop(file, segs, cnt);
+}
+
+/**
+ * Initialize a buffer for `lv_fs_if_dir_read_batch()`
+ * @param batch pointer to a batch to initialize
+ * @param buf memory for the entries and names. Must be aligned for pointers.
+ *            At least `sizeof(lv_fs_if_dirent_t) + LV_FS_IF_DIRENT_NAME_MAX` bytes, a few KB to read many entries at once.
+ * @param buf_size size of `buf` in bytes
+ */
+void lv_fs_if_dir_batch_init(lv_fs_if_dir_batch_t * batch, void * buf, uint32_t buf_size)
+{
+    batch->entries = buf;
+    batch->cnt = 0;
+    batch->buf = buf;
+    batch->buf_size = buf_size;
+    batch->name_ofs = buf_size;
+}
+
+/**
+ * Read as many entries of a directory into a batch as fit, replacing the previous entries.
+ * With the drivers supporting it (POSIX, FATFS) the type, size and modification time
+ * come from the directory listing itself, the files don't need to be opened.
+ * "." and ".." are skipped.
+ * @param dir pointer to a directory opened with `lv_fs_dir_open()`
+ * @param batch pointer to an initialized batch. `batch->cnt` is 0 at the end of the directory.
+ * @return LV_FS_RES_OK, LV_FS_RES_INV_PARAM if the batch is too small or any error from lv_fs_res_t enum
+ */
+lv_fs_res_t lv_fs_if_dir_read_batch(lv_fs_dir_t * dir, lv_fs_if_dir_batch_t * batch)
+{
+    batch->cnt = 0;
+    batch->name_ofs = batch->buf_size;
+    if(dir->drv == NULL || dir->dir_d == NULL) return LV_FS_RES_INV_PARAM;
+    if(!lv_fs_if_dir_batch_has_room(batch)) return LV_FS_RES_INV_PARAM;
+
+    const lv_fs_if_ext_t * ext = lv_fs_if_get_ext(dir->drv);
+    if(ext && ext->dir_read_batch_cb) {
+        lv_fs_res_t res = ext->dir_read_batch_cb(dir->drv, dir->dir_d, batch);
+        if(res != LV_FS_RES_NOT_IMP) return res;
+    }
+
+    return dir_read_loop(dir, batch);
+}
+
+/**
+ * Check whether an entry with the longest possible name can be added to a batch. Used by the drivers.
+ * @param batch pointer to a batch
+ * @return true: there is room
+ */
+bool lv_fs_if_dir_batch_has_room(const lv_fs_if_dir_batch_t * batch)
+{
+    uint32_t used = (batch->cnt + 1) * sizeof(lv_fs_if_dirent_t);
+    return used <= batch->name_ofs && batch->name_ofs - used >= LV_FS_IF_DIRENT_NAME_MAX;
+}
+
+/**
+ * Add an entry to a batch. Used by the drivers.
+ * @param batch pointer to a batch
+ * @param name name of the entry. It's copied into the batch.
+ * @param name_len length of the name without the closing '\0'
+ * @return pointer to the new entry to set its other fields or NULL if there is no room
+ */
+lv_fs_if_dirent_t * lv_fs_if_dir_batch_add(lv_fs_if_dir_batch_t * batch, const char * name, uint32_t name_len)
+{
+    uint32_t used = (batch->cnt + 1) * sizeof(lv_fs_if_dirent_t);
+    if(used > batch->name_ofs || batch->name_ofs - used < name_len + 1) return NULL;
+
+    batch->name_ofs -= name_len + 1;
+    char * name_copy = (char *)batch->buf + batch->name_ofs;
+    memcpy(name_copy, name, name_len);
+    name_copy[name_len] = '\0';
+
+    lv_fs_if_dirent_t * e = &batch->entries[batch->cnt];
+    batch->cnt++;
+    e->name = name_copy;
+    e->size = 0;
+    e->mtime = 0;
+    e->type = LV_FS_IF_DIRENT_FILE;
+    return e;
 }
 
 /**********************
  *   STATIC FUNCTIONS
  **********************/
 
+/**
+ * Save how long the initialization of a driver took
+ * @param letter the letter of the driver
+ * @param t_start the time stamp before the initialization
+ */
+static void init_dsc_add(char letter, uint32_t t_start)
+{
+    uint32_t t = lv_fs_if_time_us() - t_start;
+    LV_LOG_INFO("lv_fs_if_init: '%c' initialized in %u us", letter, (unsigned)t);
+
+    uint32_t i;
+    for(i = 0; i < LV_FS_IF_EXT_MAX; i++) {
+        if(init_dsc[i].letter == '\0' || init_dsc[i].letter == letter) {
+            init_dsc[i].letter = letter;
+            init_dsc[i].init_us = t;
+            return;
+        }
+    }
+}
+
+/**
+ * Read a whole file into a newly allocated buffer
+ * @param path path to the file beginning with the driver letter
+ * @param ptr pointer to store the address of the buffer
+ * @param size pointer to store the size of the file
+ * @return LV_FS_RES_OK or any error from lv_fs_res_t enum
+ */
+static lv_fs_res_t map_buffered(const char * path, const void ** ptr, uint32_t * size)
+{
+    lv_fs_file_t f;
+    lv_fs_res_t res = lv_fs_open(&f, path, LV_FS_MODE_RD);
+    if(res != LV_FS_RES_OK) return res;
+
+    uint32_t file_size = 0;
+    res = lv_fs_seek(&f, 0, LV_FS_SEEK_END);
+    if(res == LV_FS_RES_OK) res = lv_fs_tell(&f, &file_size);
+    if(res == LV_FS_RES_OK) res = lv_fs_seek(&f, 0, LV_FS_SEEK_SET);
+    if(res != LV_FS_RES_OK) {
+        lv_fs_close(&f);
+        return res;
+    }
+
+    uint8_t * buf = lv_mem_alloc(file_size);
+    if(buf == NULL) {
+        lv_fs_close(&f);
+        return LV_FS_RES_OUT_OF_MEM;
+    }
+
+    uint32_t br = 0;
+    res = lv_fs_read(&f, buf, file_size, &br);
+    lv_fs_close(&f);
+    if(res == LV_FS_RES_OK && br != file_size) res = LV_FS_RES_UNKNOWN;
+    if(res != LV_FS_RES_OK) {
+        lv_mem_free(buf);
+        return res;
+    }
+
+    *ptr = buf;
+    *size = file_size;
+    return LV_FS_RES_OK;
+}
+
+/**
+ * Sort segments by their offset. Insertion sort as there are only a few segments
+ * and they are often sorted already.
+ * @param segs the segments
+ * @param cnt number of segments
+ */
+static void seg_sort(lv_fs_if_seg_t * segs, uint32_t cnt)
+{
+    uint32_t i;
+    for(i = 1; i < cnt; i++) {
+        lv_fs_if_seg_t tmp = segs[i];
+        uint32_t j = i;
+        while(j > 0 && segs[j - 1].ofs > tmp.ofs) {
+            segs[j] = segs[j - 1];
+            j--;
+        }
+        segs[j] = tmp;
+    }
+}
+
+/**
+ * Read sorted segments with seek and read if the driver has no `readv_cb`.
+ * Seeking is skipped if a segment continues the previous one.
+ * @param file pointer to an opened file
+ * @param segs the sorted segments
+ * @param cnt number of segments
+ * @return LV_FS_RES_OK or any error from lv_fs_res_t enum
+ */
+static lv_fs_res_t readv_loop(lv_fs_file_t * file, lv_fs_if_seg_t * segs, uint32_t cnt)
+{
+    uint32_t pos_ori;
+    lv_fs_res_t res = lv_fs_tell(file, &pos_ori);
+    if(res != LV_FS_RES_OK) return res;
+
+    uint32_t pos = pos_ori;
+    uint32_t i;
+    for(i = 0; i < cnt; i++) {
+        if(pos != segs[i].ofs) {
+            res = lv_fs_seek(file, segs[i].ofs, LV_FS_SEEK_SET);
+            if(res != LV_FS_RES_OK) break;
+            pos = segs[i].ofs;
+        }
+
+        res = lv_fs_read(file, segs[i].buf, segs[i].len, &segs[i].br);
+        if(res != LV_FS_RES_OK) break;
+        pos = segs[i].ofs + segs[i].br;
+    }
+
+    /*Also restore after an error as the position is unknown then*/
+    if(pos != pos_ori || res != LV_FS_RES_OK) {
+        lv_fs_res_t seek_res = lv_fs_seek(file, pos_ori, LV_FS_SEEK_SET);
+        if(res == LV_FS_RES_OK) res = seek_res;
+    }
+
+    return res;
+}
+
+/**
+ * Fill a batch with the names returned by `lv_fs_dir_read()` if the driver has no `dir_read_batch_cb`.
+ * The sizes and modification times are unknown.
+ * @param dir pointer to an opened directory
+ * @param batch pointer to an empty batch
+ * @return LV_FS_RES_OK or any error from lv_fs_res_t enum
+ */
+static lv_fs_res_t dir_read_loop(lv_fs_dir_t * dir, lv_fs_if_dir_batch_t * batch)
+{
+    char fn[LV_FS_IF_DIRENT_NAME_MAX + 1];     /*The drivers put a '/' before the names of the directories*/
+    while(lv_fs_if_dir_batch_has_room(batch)) {
+        fn[0] = '\0';
+        lv_fs_res_t res = lv_fs_dir_read(dir, fn);
+        if(res != LV_FS_RES_OK) return res;
+        if(fn[0] == '\0') break;
+
+        bool is_dir = fn[0] == '/';
+        const char * name = is_dir ? fn + 1 : fn;
+        lv_fs_if_dirent_t * e = lv_fs_if_dir_batch_add(batch, name, strlen(name));
+        if(e == NULL) return LV_FS_RES_UNKNOWN;    /*Longer than LV_FS_IF_DIRENT_NAME_MAX*/
+        e->type = is_dir ? LV_FS_IF_DIRENT_DIR : LV_FS_IF_DIRENT_FILE;
+    }
+
+    return LV_FS_RES_OK;
+}
+
+#if LV_FS_IF_STATS && LV_FS_IF_STATS_DUMP_PERIOD
+static void stats_dump_timer_cb(lv_timer_t * t)
+{
+    (void) t;   /*Unused*/
+    lv_fs_if_stats_dump();
+}
+#endif
+
 #endif
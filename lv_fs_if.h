@@ -24,10 +24,308 @@ extern "C" {
 /*********************
  *      DEFINES
  *********************/
+/*The letter of the RAM disk driver. '\0': disabled*/
+#ifndef LV_FS_IF_RAM
+# define LV_FS_IF_RAM   '\0'
+#endif
+
+/*The letter of the archive driver. '\0': disabled*/
+#ifndef LV_FS_IF_ARCHIVE
+# define LV_FS_IF_ARCHIVE   '\0'
+#endif
+
+/*The letter of the block cache driver caching `LV_FS_CACHE_BACKEND`. '\0': disabled*/
+#ifndef LV_FS_IF_CACHE
+# define LV_FS_IF_CACHE     '\0'
+#endif
+
+/*Max. number of drivers with extensions or hooks*/
+#ifndef LV_FS_IF_EXT_MAX
+# define LV_FS_IF_EXT_MAX   8
+#endif
+
+/*Number of file and directory handles per driver served from a static pool.
+ *If a pool is full (or the size is 0) `lv_mem_alloc` is used*/
+#ifndef LV_FS_IF_FILE_POOL_SIZE
+# define LV_FS_IF_FILE_POOL_SIZE    0
+#endif
+
+#ifndef LV_FS_IF_DIR_POOL_SIZE
+# define LV_FS_IF_DIR_POOL_SIZE     0
+#endif
+
+/*Collect call counts, transferred bytes and latency histograms per driver*/
+#ifndef LV_FS_IF_STATS
+# define LV_FS_IF_STATS                 0
+#endif
+
+/*Print the statistics with LV_LOG_USER in every this many milliseconds. 0: never*/
+#ifndef LV_FS_IF_STATS_DUMP_PERIOD
+# define LV_FS_IF_STATS_DUMP_PERIOD     0
+#endif
+
+/*Number of log2 latency buckets. Bucket `i` counts the calls taking less than 2^i microseconds*/
+#define LV_FS_IF_STATS_HIST_SIZE        20
+
+/*Read files on worker threads with `lv_fs_if_read_async()`. Needs pthreads.*/
+#ifndef LV_FS_IF_ASYNC
+# define LV_FS_IF_ASYNC                 0
+#endif
+
+/*Record the reads of a boot into a trace file and prefetch them ahead of the UI on the next boots. Needs pthreads.*/
+#ifndef LV_FS_IF_PREFETCH
+# define LV_FS_IF_PREFETCH              0
+#endif
+
+/*Record every call of the drivers of `lv_fs_if_init()` into a binary trace file to replay it with
+ *tools/lv_fs_if_replay.c*/
+#ifndef LV_FS_IF_TRACE
+# define LV_FS_IF_TRACE                 0
+#endif
+
+/*Max. length of a name in a directory with the closing '\0'. Directory batches keep room for such a name.*/
+#ifndef LV_FS_IF_DIRENT_NAME_MAX
+# define LV_FS_IF_DIRENT_NAME_MAX       256
+#endif
+
+/*The driver callbacks are wrapped if any feature needs to see the calls*/
+#define LV_FS_IF_HOOK   (LV_FS_IF_STATS || LV_FS_IF_PREFETCH || LV_FS_IF_TRACE)
+
+/*Provide `lv_fs_if_direct_read/seek/tell()` bound at compile time to the only enabled one of
+ *`LV_FS_IF_FATFS`, `LV_FS_IF_PC` and `LV_FS_IF_POSIX`*/
+#ifndef LV_FS_IF_DIRECT
+# define LV_FS_IF_DIRECT                0
+#endif
+
+#if LV_FS_IF_DIRECT
+# if (LV_FS_IF_FATFS != '\0') + (LV_FS_IF_PC != '\0') + (LV_FS_IF_POSIX != '\0') != 1
+#  error "LV_FS_IF_DIRECT requires exactly one of LV_FS_IF_FATFS, LV_FS_IF_PC and LV_FS_IF_POSIX"
+# endif
+# if LV_FS_IF_PREFETCH
+#  error "LV_FS_IF_DIRECT can't be used with LV_FS_IF_PREFETCH as the direct reads are not recorded"
+# endif
+# if LV_FS_IF_FATFS != '\0'
+#  define LV_FS_IF_DIRECT_LETTER    LV_FS_IF_FATFS
+# elif LV_FS_IF_PC != '\0'
+#  define LV_FS_IF_DIRECT_LETTER    LV_FS_IF_PC
+# else
+#  define LV_FS_IF_DIRECT_LETTER    LV_FS_IF_POSIX
+# endif
+#endif
+
+/**
+ * Define a static pool of `cnt` objects of `type`. Initialize it with `lv_fs_if_pool_init()`.
+ */
+#define LV_FS_IF_POOL_DEF(name, type, cnt)                                              \
+    static union { type obj; void * next; } name##_buf[(cnt) > 0 ? (cnt) : 1];          \
+    static lv_fs_if_pool_t name
+
+/**
+ * Initialize a pool defined with `LV_FS_IF_POOL_DEF`
+ */
+#define LV_FS_IF_POOL_INIT(name, cnt) \
+    lv_fs_if_pool_init(&name, name##_buf, sizeof(name##_buf[0]), cnt)
 
 /**********************
  *      TYPEDEFS
  **********************/
+/**
+ * The driver callbacks
+ */
+typedef enum {
+    LV_FS_IF_OP_OPEN,
+    LV_FS_IF_OP_CLOSE,
+    LV_FS_IF_OP_READ,
+    LV_FS_IF_OP_WRITE,
+    LV_FS_IF_OP_SEEK,
+    LV_FS_IF_OP_TELL,
+    LV_FS_IF_OP_DIR_OPEN,
+    LV_FS_IF_OP_DIR_READ,
+    LV_FS_IF_OP_DIR_CLOSE,
+    _LV_FS_IF_OP_LAST
+} lv_fs_if_op_t;
+
+#if LV_FS_IF_CACHE != '\0'
+/**
+ * Statistics of the block cache
+ */
+typedef struct {
+    uint32_t hit_cnt;       /**< Number of blocks found in the cache*/
+    uint32_t miss_cnt;      /**< Number of blocks read from the backend*/
+    uint32_t evict_cnt;     /**< Number of blocks dropped to make room for others*/
+    uint32_t block_cnt;     /**< Number of blocks in the cache*/
+    uint32_t used_cnt;      /**< Number of blocks holding data*/
+} lv_fs_if_cache_stat_t;
+#endif
+
+#if LV_FS_IF_HOOK
+/**
+ * Describes a finished driver call. Passed to the features enabled in `LV_FS_IF_HOOK`.
+ */
+typedef struct {
+    lv_fs_drv_t * drv;
+    lv_fs_if_op_t op;
+    lv_fs_res_t res;
+    void * handle;          /**< File or directory handle of the driver (the result of open)*/
+    const char * path;      /**< Path for open and dir_open, else NULL*/
+    uint32_t arg;           /**< Requested bytes for read/write, position for seek, mode for open*/
+    uint32_t ret;           /**< Transferred bytes for read/write, position for tell*/
+    uint32_t start_us;      /**< Start time of the call*/
+    uint32_t time_us;       /**< Duration of the call*/
+    bool nested;            /**< Made by an other driver's call, e.g. the block cache reading its backend*/
+} lv_fs_if_event_t;
+#endif
+
+#if LV_FS_IF_STATS
+/**
+ * Statistics of a driver
+ */
+typedef struct {
+    uint32_t cnt[_LV_FS_IF_OP_LAST];        /**< Number of calls*/
+    uint32_t err_cnt[_LV_FS_IF_OP_LAST];    /**< Number of calls not returning LV_FS_RES_OK*/
+    uint64_t time_us[_LV_FS_IF_OP_LAST];    /**< Total time spent in the calls*/
+    uint32_t hist[_LV_FS_IF_OP_LAST][LV_FS_IF_STATS_HIST_SIZE]; /**< Latency histograms*/
+    uint64_t read_bytes;
+    uint64_t write_bytes;
+} lv_fs_if_stats_t;
+#endif
+
+/**
+ * Timings of the initialization of a driver
+ */
+typedef struct {
+    uint32_t init_us;       /**< Time spent in `lv_fs_if_init()` for the driver*/
+    uint32_t mount_us;      /**< Time of the deferred mount (FATFS with `LV_FS_FATFS_DEFERRED_MOUNT`), 0 if there is none*/
+    lv_fs_res_t res;        /**< LV_FS_RES_OK: ready, LV_FS_RES_BUSY: the deferred mount is not finished yet,
+                                 else the error of the mount*/
+} lv_fs_if_init_stat_t;
+
+/**
+ * Usage statistics of a handle pool
+ */
+typedef struct {
+    uint32_t total;         /**< Number of objects in the pool*/
+    uint32_t used;          /**< Number of objects currently allocated from the pool*/
+    uint32_t max_used;      /**< Highest `used` value seen so far*/
+    uint32_t fallback_cnt;  /**< Number of allocations served by `lv_mem_alloc` as the pool was full*/
+} lv_fs_if_pool_stat_t;
+
+/**
+ * Fixed size pool of equally sized objects. Allocation and free are O(1) and lock-free
+ * (with GCC/Clang atomics), so the pools can be used from the worker and prefetch threads too.
+ */
+typedef struct {
+    uint8_t * buf;          /**< The objects*/
+    uint32_t obj_size;      /**< Size of an object in bytes*/
+    uint32_t free_head;     /**< Index + 1 of the first free object (0: none) in the lower 16 bits and a tag
+                                 against ABA in the upper 16 bits. Free objects store the next index + 1.*/
+    lv_fs_if_pool_stat_t stat;
+} lv_fs_if_pool_t;
+
+/**
+ * A part of a file to read with `lv_fs_if_readv()`
+ */
+typedef struct {
+    uint32_t ofs;           /**< Position in the file to read from*/
+    uint32_t len;           /**< Number of bytes to read*/
+    void * buf;             /**< Buffer to read into*/
+    uint32_t br;            /**< Number of bytes read. Less than `len` at the end of the file*/
+} lv_fs_if_seg_t;
+
+/**
+ * Type of a directory entry
+ */
+typedef enum {
+    LV_FS_IF_DIRENT_FILE,
+    LV_FS_IF_DIRENT_DIR,
+} lv_fs_if_dirent_type_t;
+
+/**
+ * An entry of a directory read by `lv_fs_if_dir_read_batch()`
+ */
+typedef struct {
+    const char * name;      /**< Name of the entry. Directories have no '/' prefix, see `type`*/
+    uint32_t size;          /**< Size of a file in bytes. 0 for directories and if the driver can't tell it*/
+    uint32_t mtime;         /**< Time of the last modification as Unix time. 0 if the driver can't tell it*/
+    uint8_t type;           /**< A `lv_fs_if_dirent_type_t` value*/
+} lv_fs_if_dirent_t;
+
+/**
+ * A buffer filled with directory entries by `lv_fs_if_dir_read_batch()`.
+ * The entries are stored from the beginning and their names from the end of the buffer.
+ */
+typedef struct {
+    lv_fs_if_dirent_t * entries;    /**< The entries of the last batch*/
+    uint32_t cnt;                   /**< Number of entries in the last batch. 0: end of the directory*/
+    uint8_t * buf;
+    uint32_t buf_size;
+    uint32_t name_ofs;              /**< Start of the names in `buf`*/
+} lv_fs_if_dir_batch_t;
+
+/**
+ * How a part of a file will be read. See `lv_fs_if_advise()`.
+ */
+typedef enum {
+    LV_FS_IF_ADVICE_NORMAL,         /**< Nothing special, undo the earlier advice*/
+    LV_FS_IF_ADVICE_SEQUENTIAL,     /**< Read from the beginning to the end, e.g. a splash screen shown once*/
+    LV_FS_IF_ADVICE_RANDOM,         /**< Read at random positions so reading ahead is a waste*/
+    LV_FS_IF_ADVICE_WILLNEED,       /**< Read soon and often, e.g. hot icons*/
+    LV_FS_IF_ADVICE_DONTNEED,       /**< Not read again, its cached data can be dropped*/
+} lv_fs_if_advice_t;
+
+#if LV_FS_IF_ASYNC
+/**
+ * Called on the LVGL thread when an asynchronous read is finished
+ * @param file the file passed to `lv_fs_if_read_async()`
+ * @param buf the buffer passed to `lv_fs_if_read_async()`
+ * @param br number of bytes read. Less than requested at the end of the file.
+ * @param res LV_FS_RES_OK or any error from lv_fs_res_t enum
+ * @param user_data the user data passed to `lv_fs_if_read_async()`
+ */
+typedef void (*lv_fs_if_async_cb_t)(lv_fs_file_t * file, void * buf, uint32_t br, lv_fs_res_t res, void * user_data);
+#endif
+
+/**
+ * Optional features of a driver beyond the callbacks of `lv_fs_drv_t`.
+ * Attached to a driver with `lv_fs_if_set_ext()`. Unused callbacks can be `NULL`.
+ */
+typedef struct {
+    /**Provide a stable pointer to the whole content of a file.
+     * `map_d` can be set to anything needed by `unmap_cb` later.
+     * Return `LV_FS_RES_NOT_IMP` to fall back to a buffered read.*/
+    lv_fs_res_t (*map_cb)(lv_fs_drv_t * drv, const char * path, const void ** ptr, uint32_t * size, void ** map_d);
+
+    /**Release a mapping created by `map_cb`*/
+    void (*unmap_cb)(lv_fs_drv_t * drv, const void * ptr, uint32_t size, void * map_d);
+
+    /**Write the data buffered for a file to the storage*/
+    lv_fs_res_t (*flush_cb)(lv_fs_drv_t * drv, void * file_p);
+
+    /**Read several parts of a file at once. The segments are sorted by offset and their `br` is 0.
+     * The read/write position of the file must not change.*/
+    lv_fs_res_t (*readv_cb)(lv_fs_drv_t * drv, void * file_p, lv_fs_if_seg_t * segs, uint32_t cnt);
+
+    /**Add the next entries of a directory to an empty batch with `lv_fs_if_dir_batch_add()`
+     * while `lv_fs_if_dir_batch_has_room()`. Add nothing at the end of the directory.
+     * Return `LV_FS_RES_NOT_IMP` to fall back to `dir_read_cb`.*/
+    lv_fs_res_t (*dir_read_batch_cb)(lv_fs_drv_t * drv, void * dir_p, lv_fs_if_dir_batch_t * batch);
+
+    /**Start loading a part of a file into a cache (e.g. the page cache of the OS) so reading it later is fast.
+     * Called from the prefetch thread while the UI can use the driver, so the state it touches must be locked.
+     * Drives without it are not prefetched.*/
+    lv_fs_res_t (*prefetch_cb)(lv_fs_drv_t * drv, const char * path, uint32_t ofs, uint32_t len);
+
+    /**Adapt the caching and reading ahead of a file to how a part of it will be read. `len` 0: until the end.*/
+    lv_fs_res_t (*advise_cb)(lv_fs_drv_t * drv, void * file_p, uint32_t ofs, uint32_t len, lv_fs_if_advice_t advice);
+
+    /**Pools the file and directory handles are allocated from*/
+    const lv_fs_if_pool_t * file_pool;
+    const lv_fs_if_pool_t * dir_pool;
+
+    /**The callbacks of different files can run at the same time on several threads.
+     * Required by `lv_fs_if_read_async()`.*/
+    bool thread_safe;
+} lv_fs_if_ext_t;
 
 /**********************
  * GLOBAL PROTOTYPES
@@ -38,6 +336,384 @@ extern "C" {
  */
 void lv_fs_if_init(void);
 
+/**
+ * Get how long the initialization of a driver took and whether it's ready.
+ * With `LV_FS_FATFS_DEFERRED_MOUNT` it tells when the card is mounted.
+ * @param letter the letter of a driver registered by `lv_fs_if_init()`
+ * @param stat pointer to store the timings
+ * @return LV_FS_RES_OK, LV_FS_RES_NOT_EX if the driver is not registered by `lv_fs_if_init()`
+ */
+lv_fs_res_t lv_fs_if_get_init_stat(char letter, lv_fs_if_init_stat_t * stat);
+
+/**
+ * Get a monotonic time stamp. Define `LV_FS_IF_TIME_US()` in `lv_conf.h` to provide a custom source.
+ * @return time in microseconds
+ */
+uint32_t lv_fs_if_time_us(void);
+
+/**
+ * Attach extra features to a registered driver
+ * @param drv pointer to a driver
+ * @param ext pointer to a static extension descriptor. Only the pointer is saved.
+ */
+void lv_fs_if_set_ext(lv_fs_drv_t * drv, const lv_fs_if_ext_t * ext);
+
+/**
+ * Get the extra features of a driver
+ * @param drv pointer to a driver
+ * @return pointer to the extension descriptor or NULL if there is none
+ */
+const lv_fs_if_ext_t * lv_fs_if_get_ext(const lv_fs_drv_t * drv);
+
+/**
+ * Get the whole content of a file as a stable, read-only pointer.
+ * If the driver can't map the file (e.g. FATFS) the file is read into an `lv_mem_alloc`ed buffer.
+ * @param path path to the file beginning with the driver letter (e.g. S:/folder/file.bin)
+ * @param ptr pointer to store the address of the content
+ * @param size pointer to store the size of the content in bytes
+ * @return LV_FS_RES_OK or any error from lv_fs_res_t enum
+ */
+lv_fs_res_t lv_fs_if_map(const char * path, const void ** ptr, uint32_t * size);
+
+/**
+ * Release a content returned by `lv_fs_if_map()`
+ * @param ptr the pointer returned by `lv_fs_if_map()`
+ */
+void lv_fs_if_unmap(const void * ptr);
+
+/**
+ * Write the data buffered by the driver for an opened file to the storage.
+ * Closing a file flushes it too.
+ * @param file pointer to an opened file
+ * @return LV_FS_RES_OK (also if the driver doesn't buffer) or any error from lv_fs_res_t enum
+ */
+lv_fs_res_t lv_fs_if_flush(lv_fs_file_t * file);
+
+/**
+ * Tell the driver how a part of a file will be read so it can adapt its caching and reading ahead.
+ * It's only a hint, the reads return the same data either way.
+ * @param file pointer to an opened file
+ * @param ofs start of the part
+ * @param len length of the part. 0: until the end of the file
+ * @param advice how the part will be read
+ * @return LV_FS_RES_OK (also if the driver ignores the advice) or any error from lv_fs_res_t enum
+ */
+lv_fs_res_t lv_fs_if_advise(lv_fs_file_t * file, uint32_t ofs, uint32_t len, lv_fs_if_advice_t advice);
+
+/**
+ * Read several parts of a file with as few seeks and system calls as the driver allows
+ * (e.g. the header, the palette and some rows of an image).
+ * The segments are read in the order of their offsets and segments continuing each other are read together.
+ * The read/write position of the file doesn't change.
+ * @param file pointer to an opened file
+ * @param segs the parts to read. They are sorted by `ofs` in place and `br` is set in each.
+ * @param cnt number of segments
+ * @return LV_FS_RES_OK (also if some segments are beyond the end of the file) or any error from lv_fs_res_t enum
+ */
+lv_fs_res_t lv_fs_if_readv(lv_fs_file_t * file, lv_fs_if_seg_t * segs, uint32_t cnt);
+
+/**
+ * Initialize a buffer for `lv_fs_if_dir_read_batch()`
+ * @param batch pointer to a batch to initialize
+ * @param buf memory for the entries and names. Must be aligned for pointers.
+ *            At least `sizeof(lv_fs_if_dirent_t) + LV_FS_IF_DIRENT_NAME_MAX` bytes, a few KB to read many entries at once.
+ * @param buf_size size of `buf` in bytes
+ */
+void lv_fs_if_dir_batch_init(lv_fs_if_dir_batch_t * batch, void * buf, uint32_t buf_size);
+
+/**
+ * Read as many entries of a directory into a batch as fit, replacing the previous entries.
+ * With the drivers supporting it (POSIX, FATFS) the type, size and modification time
+ * come from the directory listing itself, the files don't need to be opened.
+ * "." and ".." are skipped.
+ * @param dir pointer to a directory opened with `lv_fs_dir_open()`
+ * @param batch pointer to an initialized batch. `batch->cnt` is 0 at the end of the directory.
+ * @return LV_FS_RES_OK, LV_FS_RES_INV_PARAM if the batch is too small or any error from lv_fs_res_t enum
+ */
+lv_fs_res_t lv_fs_if_dir_read_batch(lv_fs_dir_t * dir, lv_fs_if_dir_batch_t * batch);
+
+/**
+ * Check whether an entry with the longest possible name can be added to a batch. Used by the drivers.
+ * @param batch pointer to a batch
+ * @return true: there is room
+ */
+bool lv_fs_if_dir_batch_has_room(const lv_fs_if_dir_batch_t * batch);
+
+/**
+ * Add an entry to a batch. Used by the drivers.
+ * @param batch pointer to a batch
+ * @param name name of the entry. It's copied into the batch.
+ * @param name_len length of the name without the closing '\0'
+ * @return pointer to the new entry to set its other fields or NULL if there is no room
+ */
+lv_fs_if_dirent_t * lv_fs_if_dir_batch_add(lv_fs_if_dir_batch_t * batch, const char * name, uint32_t name_len);
+
+/**
+ * Get the usage statistics of the handle pools of a driver. Useful to tune
+ * `LV_FS_IF_FILE_POOL_SIZE` and `LV_FS_IF_DIR_POOL_SIZE`.
+ * @param letter the letter of the driver
+ * @param file_stat pointer to store the statistics of the file pool (can be NULL)
+ * @param dir_stat pointer to store the statistics of the directory pool (can be NULL)
+ * @return LV_FS_RES_OK or LV_FS_RES_NOT_EX if the driver has no pools
+ */
+lv_fs_res_t lv_fs_if_get_pool_stat(char letter, lv_fs_if_pool_stat_t * file_stat, lv_fs_if_pool_stat_t * dir_stat);
+
+#if LV_FS_IF_RAM != '\0'
+/**
+ * Copy a file from any registered driver to the RAM disk
+ * @param src path of the file to copy with driver letter (e.g. "S:/boot/logo.bin")
+ * @param dst path on the RAM disk without driver letter (e.g. "/logo.bin")
+ * @return LV_FS_RES_OK, LV_FS_RES_FULL if there is no space for the file,
+ *         LV_FS_RES_DENIED if `dst` already exists or any error from lv_fs_res_t enum
+ */
+lv_fs_res_t lv_fs_if_ram_load(const char * src, const char * dst);
+
+/**
+ * Copy a directory with all its files and sub directories to the RAM disk
+ * @param src path of the directory with driver letter (e.g. "S:/boot")
+ * @param dst path of the directory on the RAM disk without driver letter (e.g. "/boot")
+ * @return LV_FS_RES_OK or the first error of `lv_fs_if_ram_load()`
+ */
+lv_fs_res_t lv_fs_if_ram_load_dir(const char * src, const char * dst);
+#endif
+
+#if LV_FS_IF_ARCHIVE != '\0'
+/**
+ * Mount an archive created by `tools/lv_fs_archive.py`. The previous archive is unmounted.
+ * The container is mapped if its driver supports it, else it's kept open and only the index is read.
+ * No files of the previous archive should be open.
+ * @param path path of the archive with driver letter (e.g. "S:/assets.bin"). NULL to only unmount.
+ * @return LV_FS_RES_OK, LV_FS_RES_FS_ERR if it's not a valid archive or any error from lv_fs_res_t enum
+ */
+lv_fs_res_t lv_fs_if_archive_mount(const char * path);
+#endif
+
+#if LV_FS_IF_CACHE != '\0'
+/**
+ * Register a cached view of a driver under a new letter. All views share the same cache.
+ * Files opened for writing through the view are not cached and drop the cached blocks of the file.
+ * @param letter the letter of the cached drive
+ * @param backend_letter the letter of a registered driver to cache
+ * @return LV_FS_RES_OK, LV_FS_RES_NOT_EX if the backend is not registered
+ *         or LV_FS_RES_FULL if there are already `LV_FS_CACHE_VIEW_MAX` views
+ */
+lv_fs_res_t lv_fs_if_cache_add(char letter, char backend_letter);
+
+/**
+ * Drop all cached blocks. Call it if files were changed directly on a backend.
+ */
+void lv_fs_if_cache_invalidate(void);
+
+/**
+ * Get the statistics of the block cache
+ * @param stat pointer to store the statistics
+ */
+void lv_fs_if_cache_get_stat(lv_fs_if_cache_stat_t * stat);
+#endif
+
+#if LV_FS_IF_ASYNC
+/**
+ * Read from the current position of a file on a worker thread.
+ * The requests of the same file are executed in order, each advancing the position.
+ * Don't use the file with other functions and keep `file` and `buf` valid until the callback is called
+ * or the request is cancelled.
+ * The driver has to set `thread_safe` in its `lv_fs_if_ext_t` as it's called from the worker threads
+ * while other files are used in LVGL.
+ * @param file pointer to an opened file
+ * @param buf buffer to read into
+ * @param btr number of bytes to read
+ * @param cb called on the LVGL thread (from an `lv_timer`) when the read is finished
+ * @param user_data passed to `cb`
+ * @return ID of the request or 0 if the queue is full or the driver is not supported
+ */
+uint32_t lv_fs_if_read_async(lv_fs_file_t * file, void * buf, uint32_t btr, lv_fs_if_async_cb_t cb, void * user_data);
+
+/**
+ * Cancel a request. Its callback won't be called.
+ * If the request is running this waits until the current chunk is read,
+ * so `buf` is not written anymore when it returns.
+ * @param id ID returned by `lv_fs_if_read_async()`
+ * @return LV_FS_RES_OK or LV_FS_RES_NOT_EX if the request is already finished
+ */
+lv_fs_res_t lv_fs_if_async_cancel(uint32_t id);
+
+/**
+ * Cancel all the requests of a file, e.g. before closing it
+ * @param file pointer to a file
+ */
+void lv_fs_if_async_cancel_file(lv_fs_file_t * file);
+
+/**
+ * Get the number of requests which are queued, running or waiting for their callback
+ * @return number of requests
+ */
+uint32_t lv_fs_if_async_get_pending(void);
+#endif
+
+#if LV_FS_IF_PREFETCH
+/**
+ * Stop recording and save the reads recorded since `lv_fs_if_init()` to `LV_FS_IF_PREFETCH_FILE`.
+ * Call it when the first screen is ready. Does nothing if a trace was loaded at boot.
+ * @return LV_FS_RES_OK, LV_FS_RES_DENIED if not recording or any error from lv_fs_res_t enum
+ */
+lv_fs_res_t lv_fs_if_prefetch_save(void);
+
+/**
+ * Stop recording or replaying the trace. Waits for the prefetch thread to finish its current read.
+ */
+void lv_fs_if_prefetch_stop(void);
+#endif
+
+#if LV_FS_IF_TRACE
+/**
+ * Write the buffered events to `LV_FS_IF_TRACE_FILE`. Call it from the LVGL thread.
+ * It's also called periodically if `LV_FS_IF_TRACE_FLUSH_PERIOD` is not 0.
+ * @return LV_FS_RES_OK, LV_FS_RES_DENIED if the file is not open or any error from lv_fs_res_t enum
+ */
+lv_fs_res_t lv_fs_if_trace_flush(void);
+
+/**
+ * Stop recording, write the buffered events and close the trace file
+ */
+void lv_fs_if_trace_stop(void);
+#endif
+
+#if LV_FS_IF_STATS
+/**
+ * Get the statistics of a driver
+ * @param letter the letter of the driver
+ * @return pointer to the statistics or NULL if the driver is not registered by `lv_fs_if_init()`
+ */
+const lv_fs_if_stats_t * lv_fs_if_stats_get(char letter);
+
+/**
+ * Clear the statistics of a driver
+ * @param letter the letter of the driver or '\0' to clear all drivers
+ */
+void lv_fs_if_stats_reset(char letter);
+
+/**
+ * Get a percentile of the latency of a callback from the histogram
+ * @param stats pointer to statistics
+ * @param op the callback
+ * @param percent e.g. 50 or 99
+ * @return upper bound of the latency in microseconds (0 if there were no calls)
+ */
+uint32_t lv_fs_if_stats_percentile(const lv_fs_if_stats_t * stats, lv_fs_if_op_t op, uint32_t percent);
+
+/**
+ * Print the statistics of all drivers with `LV_LOG_USER`
+ */
+void lv_fs_if_stats_dump(void);
+#endif
+
+#if LV_FS_IF_DIRECT && LV_FS_IF_FATFS != '\0'
+lv_fs_res_t lv_fs_if_fatfs_read(void * file_p, void * buf, uint32_t btr, uint32_t * br);
+lv_fs_res_t lv_fs_if_fatfs_seek(void * file_p, uint32_t pos, lv_fs_whence_t whence);
+lv_fs_res_t lv_fs_if_fatfs_tell(void * file_p, uint32_t * pos_p);
+#endif
+
+#if LV_FS_IF_DIRECT && LV_FS_IF_PC != '\0'
+lv_fs_res_t lv_fs_if_pc_read(void * file_p, void * buf, uint32_t btr, uint32_t * br);
+lv_fs_res_t lv_fs_if_pc_seek(void * file_p, uint32_t pos, lv_fs_whence_t whence);
+lv_fs_res_t lv_fs_if_pc_tell(void * file_p, uint32_t * pos_p);
+#endif
+
+#if LV_FS_IF_DIRECT && LV_FS_IF_POSIX != '\0'
+lv_fs_res_t lv_fs_if_posix_read(void * file_p, void * buf, uint32_t btr, uint32_t * br);
+lv_fs_res_t lv_fs_if_posix_seek(void * file_p, uint32_t pos, lv_fs_whence_t whence);
+lv_fs_res_t lv_fs_if_posix_tell(void * file_p, uint32_t * pos_p);
+#endif
+
+#if LV_FS_IF_DIRECT
+/**
+ * Read from a file calling the driver of `LV_FS_IF_DIRECT_LETTER` directly, without the checks,
+ * the cache of `lv_fs_drv_t` and the hooks of `lv_fs_read()`. Meant for hot loops reading small parts.
+ * @param file pointer to a file opened with `lv_fs_open()` on `LV_FS_IF_DIRECT_LETTER`
+ * @param buf pointer to a buffer to read into
+ * @param btr number of bytes to read
+ * @param br pointer to store the number of bytes read
+ * @return LV_FS_RES_OK or any error from lv_fs_res_t enum
+ */
+static inline lv_fs_res_t lv_fs_if_direct_read(lv_fs_file_t * file, void * buf, uint32_t btr, uint32_t * br)
+{
+#if LV_FS_IF_FATFS != '\0'
+    return lv_fs_if_fatfs_read(file->file_d, buf, btr, br);
+#elif LV_FS_IF_PC != '\0'
+    return lv_fs_if_pc_read(file->file_d, buf, btr, br);
+#else
+    return lv_fs_if_posix_read(file->file_d, buf, btr, br);
+#endif
+}
+
+/**
+ * Set the read/write position of a file calling the driver of `LV_FS_IF_DIRECT_LETTER` directly
+ * @param file pointer to a file opened with `lv_fs_open()` on `LV_FS_IF_DIRECT_LETTER`
+ * @param pos the new position
+ * @param whence LV_FS_SEEK_SET, LV_FS_SEEK_CUR or LV_FS_SEEK_END
+ * @return LV_FS_RES_OK or any error from lv_fs_res_t enum
+ */
+static inline lv_fs_res_t lv_fs_if_direct_seek(lv_fs_file_t * file, uint32_t pos, lv_fs_whence_t whence)
+{
+#if LV_FS_IF_FATFS != '\0'
+    return lv_fs_if_fatfs_seek(file->file_d, pos, whence);
+#elif LV_FS_IF_PC != '\0'
+    return lv_fs_if_pc_seek(file->file_d, pos, whence);
+#else
+    return lv_fs_if_posix_seek(file->file_d, pos, whence);
+#endif
+}
+
+/**
+ * Get the read/write position of a file calling the driver of `LV_FS_IF_DIRECT_LETTER` directly
+ * @param file pointer to a file opened with `lv_fs_open()` on `LV_FS_IF_DIRECT_LETTER`
+ * @param pos_p pointer to store the position
+ * @return LV_FS_RES_OK or any error from lv_fs_res_t enum
+ */
+static inline lv_fs_res_t lv_fs_if_direct_tell(lv_fs_file_t * file, uint32_t * pos_p)
+{
+#if LV_FS_IF_FATFS != '\0'
+    return lv_fs_if_fatfs_tell(file->file_d, pos_p);
+#elif LV_FS_IF_PC != '\0'
+    return lv_fs_if_pc_tell(file->file_d, pos_p);
+#else
+    return lv_fs_if_posix_tell(file->file_d, pos_p);
+#endif
+}
+#endif
+
+#if LV_FS_IF_HOOK
+/**
+ * Wrap the callbacks of a driver to report every call to the enabled features (e.g. statistics).
+ * Called by `lv_fs_if_init()` for its drivers.
+ * @param drv pointer to a registered driver
+ */
+void lv_fs_if_hook_attach(lv_fs_drv_t * drv);
+#endif
+
+/**
+ * Initialize a pool
+ * @param pool pointer to a pool
+ * @param buf memory for `cnt` objects
+ * @param obj_size size of an object. At least `sizeof(void *)`
+ * @param cnt number of objects
+ */
+void lv_fs_if_pool_init(lv_fs_if_pool_t * pool, void * buf, uint32_t obj_size, uint32_t cnt);
+
+/**
+ * Allocate an object from a pool or with `lv_mem_alloc` if the pool is full
+ * @param pool pointer to a pool
+ * @return pointer to the object or NULL on out of memory
+ */
+void * lv_fs_if_pool_alloc(lv_fs_if_pool_t * pool);
+
+/**
+ * Free an object allocated with `lv_fs_if_pool_alloc()`
+ * @param pool pointer to a pool
+ * @param obj pointer to the object
+ */
+void lv_fs_if_pool_free(lv_fs_if_pool_t * pool, void * obj);
+
 /**********************
  *      MACROS
  **********************/
@@ -0,0 +1,370 @@
+/**
+ * @file lv_fs_if_async.c
+ *
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "lv_fs_if.h"
+
+#if LV_USE_FS_IF && LV_FS_IF_ASYNC
+#include <pthread.h>
+
+/*********************
+ *      DEFINES
+ *********************/
+/*Number of worker threads running the reads*/
+#ifndef LV_FS_IF_ASYNC_THREAD_CNT
+# define LV_FS_IF_ASYNC_THREAD_CNT  1
+#endif
+
+/*Max. number of requests queued, running or waiting for their callback*/
+#ifndef LV_FS_IF_ASYNC_QUEUE_SIZE
+# define LV_FS_IF_ASYNC_QUEUE_SIZE  16
+#endif
+
+/*Reads are split into chunks of this size so cancellation doesn't wait for a whole large read*/
+#ifndef LV_FS_IF_ASYNC_CHUNK_SIZE
+# define LV_FS_IF_ASYNC_CHUNK_SIZE  (32 * 1024U)
+#endif
+
+/*Period of the timer delivering the completions in milliseconds*/
+#ifndef LV_FS_IF_ASYNC_PERIOD
+# define LV_FS_IF_ASYNC_PERIOD      5
+#endif
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+typedef enum {
+    REQ_FREE,
+    REQ_QUEUED,
+    REQ_RUNNING,
+    REQ_DONE,       /*Waiting for the timer to call the callback*/
+} req_state_t;
+
+typedef struct {
+    lv_fs_file_t * file;
+    uint8_t * buf;
+    uint32_t btr;
+    uint32_t br;
+    lv_fs_if_async_cb_t cb;
+    void * user_data;
+    uint32_t id;            /*Increasing, so the queued request with the smallest ID is the oldest*/
+    lv_fs_res_t res;
+    uint8_t state;
+    uint8_t cancel;         /*Stop after the current chunk and don't call the callback*/
+} async_req_t;
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+void lv_fs_if_async_init(void);
+static void * worker_thread(void * arg);
+static async_req_t * next_req(void);
+static bool file_busy(const lv_fs_file_t * file);
+static async_req_t * find_req(uint32_t id);
+static void cancel_req(async_req_t * req);
+static void complete_timer_cb(lv_timer_t * t);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+static async_req_t reqs[LV_FS_IF_ASYNC_QUEUE_SIZE];
+static uint32_t id_next = 1;
+static uint32_t active_cnt;         /*Requests not FREE*/
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t queued_cond = PTHREAD_COND_INITIALIZER;     /*Signaled when a request can be started*/
+static pthread_cond_t done_cond = PTHREAD_COND_INITIALIZER;       /*Signaled when a request stops running*/
+static lv_timer_t * complete_timer;
+
+/**********************
+ *      MACROS
+ **********************/
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+/**
+ * Start the worker threads and the timer delivering the completions. Called by `lv_fs_if_init()`.
+ */
+void lv_fs_if_async_init(void)
+{
+    complete_timer = lv_timer_create(complete_timer_cb, LV_FS_IF_ASYNC_PERIOD, NULL);
+    lv_timer_pause(complete_timer);
+
+    uint32_t i;
+    for(i = 0; i < LV_FS_IF_ASYNC_THREAD_CNT; i++) {
+        pthread_t thread;
+        if(pthread_create(&thread, NULL, worker_thread, NULL) != 0) {
+            LV_LOG_ERROR("lv_fs_if_async_init: couldn't create a worker thread");
+            break;
+        }
+        pthread_detach(thread);
+    }
+}
+
+/**
+ * Read from the current position of a file on a worker thread.
+ * The requests of the same file are executed in order, each advancing the position.
+ * Don't use the file with other functions and keep `file` and `buf` valid until the callback is called
+ * or the request is cancelled.
+ * The driver has to set `thread_safe` in its `lv_fs_if_ext_t` as it's called from the worker threads
+ * while other files are used in LVGL.
+ * @param file pointer to an opened file
+ * @param buf buffer to read into
+ * @param btr number of bytes to read
+ * @param cb called on the LVGL thread (from an `lv_timer`) when the read is finished
+ * @param user_data passed to `cb`
+ * @return ID of the request or 0 if the queue is full or the driver is not supported
+ */
+uint32_t lv_fs_if_read_async(lv_fs_file_t * file, void * buf, uint32_t btr, lv_fs_if_async_cb_t cb, void * user_data)
+{
+    /*The driver callbacks are called directly so LVGL's own file cache would get out of sync*/
+    if(file->drv == NULL || file->file_d == NULL || file->drv->read_cb == NULL) return 0;
+    if(file->drv->cache_size != 0) {
+        LV_LOG_WARN("lv_fs_if_read_async: drivers with cache_size are not supported");
+        return 0;
+    }
+
+    const lv_fs_if_ext_t * ext = lv_fs_if_get_ext(file->drv);
+    if(ext == NULL || !ext->thread_safe) {
+        LV_LOG_WARN("lv_fs_if_read_async: the driver is not thread safe");
+        return 0;
+    }
+
+    pthread_mutex_lock(&lock);
+
+    async_req_t * req = NULL;
+    uint32_t i;
+    for(i = 0; i < LV_FS_IF_ASYNC_QUEUE_SIZE; i++) {
+        if(reqs[i].state == REQ_FREE) {
+            req = &reqs[i];
+            break;
+        }
+    }
+
+    if(req == NULL) {
+        pthread_mutex_unlock(&lock);
+        return 0;
+    }
+
+    req->file = file;
+    req->buf = buf;
+    req->btr = btr;
+    req->br = 0;
+    req->cb = cb;
+    req->user_data = user_data;
+    req->id = id_next++;
+    if(id_next == 0) id_next = 1;
+    req->res = LV_FS_RES_OK;
+    req->cancel = 0;
+    req->state = REQ_QUEUED;
+    active_cnt++;
+
+    uint32_t id = req->id;
+    pthread_cond_signal(&queued_cond);
+    pthread_mutex_unlock(&lock);
+
+    lv_timer_resume(complete_timer);
+    return id;
+}
+
+/**
+ * Cancel a request. Its callback won't be called.
+ * If the request is running this waits until the current chunk is read,
+ * so `buf` is not written anymore when it returns.
+ * @param id ID returned by `lv_fs_if_read_async()`
+ * @return LV_FS_RES_OK or LV_FS_RES_NOT_EX if the request is already finished
+ */
+lv_fs_res_t lv_fs_if_async_cancel(uint32_t id)
+{
+    pthread_mutex_lock(&lock);
+    async_req_t * req = find_req(id);
+    if(req) cancel_req(req);
+    pthread_mutex_unlock(&lock);
+
+    return req ? LV_FS_RES_OK : LV_FS_RES_NOT_EX;
+}
+
+/**
+ * Cancel all the requests of a file, e.g. before closing it
+ * @param file pointer to a file
+ */
+void lv_fs_if_async_cancel_file(lv_fs_file_t * file)
+{
+    pthread_mutex_lock(&lock);
+    uint32_t i;
+    for(i = 0; i < LV_FS_IF_ASYNC_QUEUE_SIZE; i++) {
+        if(reqs[i].state != REQ_FREE && reqs[i].file == file) cancel_req(&reqs[i]);
+    }
+    pthread_mutex_unlock(&lock);
+}
+
+/**
+ * Get the number of requests which are queued, running or waiting for their callback
+ * @return number of requests
+ */
+uint32_t lv_fs_if_async_get_pending(void)
+{
+    pthread_mutex_lock(&lock);
+    uint32_t cnt = active_cnt;
+    pthread_mutex_unlock(&lock);
+    return cnt;
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+/**
+ * Run the queued requests
+ * @param arg unused
+ * @return never returns
+ */
+static void * worker_thread(void * arg)
+{
+    (void) arg;     /*Unused*/
+
+    pthread_mutex_lock(&lock);
+    while(1) {
+        async_req_t * req = next_req();
+        if(req == NULL) {
+            pthread_cond_wait(&queued_cond, &lock);
+            continue;
+        }
+
+        req->state = REQ_RUNNING;
+        lv_fs_file_t * file = req->file;
+
+        /*Read in chunks without holding the lock so the request can be cancelled in between*/
+        while(!req->cancel && req->br < req->btr && req->res == LV_FS_RES_OK) {
+            uint32_t btr = LV_MIN(req->btr - req->br, LV_FS_IF_ASYNC_CHUNK_SIZE);
+            uint8_t * buf = req->buf + req->br;
+            pthread_mutex_unlock(&lock);
+
+            uint32_t br = 0;
+            lv_fs_res_t res = file->drv->read_cb(file->drv, file->file_d, buf, btr, &br);
+
+            pthread_mutex_lock(&lock);
+            req->res = res;
+            req->br += br;
+            if(br < btr) break;     /*End of the file*/
+        }
+
+        if(req->cancel) {
+            req->state = REQ_FREE;
+            active_cnt--;
+        }
+        else {
+            req->state = REQ_DONE;
+        }
+
+        pthread_cond_broadcast(&done_cond);
+
+        /*The next request of the same file might be waiting for this one*/
+        pthread_cond_broadcast(&queued_cond);
+    }
+
+    return NULL;
+}
+
+/**
+ * Get the oldest queued request whose file is not used by an other worker. Called with the lock held.
+ * @return pointer to the request or NULL if there is none
+ */
+static async_req_t * next_req(void)
+{
+    /*The older requests of a file are never skipped, so the requests of a file run in order*/
+    async_req_t * oldest = NULL;
+    uint32_t i;
+    for(i = 0; i < LV_FS_IF_ASYNC_QUEUE_SIZE; i++) {
+        async_req_t * req = &reqs[i];
+        if(req->state != REQ_QUEUED || file_busy(req->file)) continue;
+        if(oldest == NULL || (int32_t)(req->id - oldest->id) < 0) oldest = req;
+    }
+
+    return oldest;
+}
+
+/**
+ * Check whether a request of a file is running. Called with the lock held.
+ * @param file pointer to a file
+ * @return true: a worker reads the file
+ */
+static bool file_busy(const lv_fs_file_t * file)
+{
+    uint32_t i;
+    for(i = 0; i < LV_FS_IF_ASYNC_QUEUE_SIZE; i++) {
+        if(reqs[i].state == REQ_RUNNING && reqs[i].file == file) return true;
+    }
+
+    return false;
+}
+
+/**
+ * Find an unfinished request. Called with the lock held.
+ * @param id ID of the request
+ * @return pointer to the request or NULL
+ */
+static async_req_t * find_req(uint32_t id)
+{
+    uint32_t i;
+    for(i = 0; i < LV_FS_IF_ASYNC_QUEUE_SIZE; i++) {
+        if(reqs[i].state != REQ_FREE && reqs[i].id == id) return &reqs[i];
+    }
+
+    return NULL;
+}
+
+/**
+ * Cancel a request and wait if it's running. Called with the lock held.
+ * @param req pointer to the request
+ */
+static void cancel_req(async_req_t * req)
+{
+    uint32_t id = req->id;
+    req->cancel = 1;
+    while(req->state == REQ_RUNNING && req->id == id) {
+        pthread_cond_wait(&done_cond, &lock);
+    }
+
+    /*The worker frees it if it was running*/
+    if(req->id == id && (req->state == REQ_QUEUED || req->state == REQ_DONE)) {
+        req->state = REQ_FREE;
+        active_cnt--;
+    }
+}
+
+/**
+ * Call the callbacks of the finished requests on the LVGL thread
+ * @param t pointer to the timer
+ */
+static void complete_timer_cb(lv_timer_t * t)
+{
+    uint32_t i;
+    for(i = 0; i < LV_FS_IF_ASYNC_QUEUE_SIZE; i++) {
+        pthread_mutex_lock(&lock);
+        async_req_t * req = &reqs[i];
+        if(req->state != REQ_DONE) {
+            pthread_mutex_unlock(&lock);
+            continue;
+        }
+
+        /*Free the slot before calling the callback so it can start a new request*/
+        async_req_t done = *req;
+        req->state = REQ_FREE;
+        active_cnt--;
+        pthread_mutex_unlock(&lock);
+
+        if(done.cb) done.cb(done.file, done.buf, done.br, done.res, done.user_data);
+    }
+
+    pthread_mutex_lock(&lock);
+    if(active_cnt == 0) lv_timer_pause(t);
+    pthread_mutex_unlock(&lock);
+}
+
+#endif /*LV_USE_FS_IF && LV_FS_IF_ASYNC*/
@@ -0,0 +1,261 @@
+/**
+ * @file lv_fs_if_hook.c
+ *
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "lv_fs_if.h"
+
+#if LV_USE_FS_IF && LV_FS_IF_HOOK
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+typedef struct {
+    lv_fs_drv_t * drv;      /*The wrapped driver*/
+    lv_fs_drv_t orig;       /*Copy of the driver with the original callbacks*/
+} hook_dsc_t;
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+#if LV_FS_IF_STATS
+void lv_fs_if_stats_add(lv_fs_drv_t * drv);
+void lv_fs_if_stats_event(const lv_fs_if_event_t * e);
+#endif
+
+#if LV_FS_IF_PREFETCH
+void lv_fs_if_prefetch_event(const lv_fs_if_event_t * e);
+#endif
+
+#if LV_FS_IF_TRACE
+void lv_fs_if_trace_event(const lv_fs_if_event_t * e);
+#endif
+
+static void * hook_open(lv_fs_drv_t * drv, const char * path, lv_fs_mode_t mode);
+static lv_fs_res_t hook_close(lv_fs_drv_t * drv, void * file_p);
+static lv_fs_res_t hook_read(lv_fs_drv_t * drv, void * file_p, void * buf, uint32_t btr, uint32_t * br);
+static lv_fs_res_t hook_write(lv_fs_drv_t * drv, void * file_p, const void * buf, uint32_t btw, uint32_t * bw);
+static lv_fs_res_t hook_seek(lv_fs_drv_t * drv, void * file_p, uint32_t pos, lv_fs_whence_t whence);
+static lv_fs_res_t hook_tell(lv_fs_drv_t * drv, void * file_p, uint32_t * pos_p);
+static void * hook_dir_open(lv_fs_drv_t * drv, const char * path);
+static lv_fs_res_t hook_dir_read(lv_fs_drv_t * drv, void * dir_p, char * fn);
+static lv_fs_res_t hook_dir_close(lv_fs_drv_t * drv, void * dir_p);
+static const lv_fs_drv_t * get_orig(const lv_fs_drv_t * drv);
+static void event_start(lv_fs_if_event_t * e, lv_fs_drv_t * drv, lv_fs_if_op_t op, void * handle);
+static void event_send(lv_fs_if_event_t * e);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+static hook_dsc_t hook_dsc[LV_FS_IF_EXT_MAX];
+
+/*Number of hooked calls in progress, to mark the ones made by other drivers (e.g. by a cache to its backend)*/
+#if LV_FS_IF_ASYNC || LV_FS_IF_PREFETCH
+static __thread uint32_t call_depth;
+#else
+static uint32_t call_depth;
+#endif
+
+/**********************
+ *      MACROS
+ **********************/
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+/**
+ * Wrap the callbacks of a driver to report every call to the enabled features (e.g. statistics).
+ * Called by `lv_fs_if_init()` for its drivers.
+ * @param drv pointer to a registered driver
+ */
+void lv_fs_if_hook_attach(lv_fs_drv_t * drv)
+{
+    if(drv == NULL || get_orig(drv)) return;
+
+    uint32_t i;
+    for(i = 0; i < LV_FS_IF_EXT_MAX; i++) {
+        if(hook_dsc[i].drv == NULL) break;
+    }
+
+    if(i == LV_FS_IF_EXT_MAX) {
+        LV_LOG_WARN("lv_fs_if_hook_attach: no free slot, increase LV_FS_IF_EXT_MAX");
+        return;
+    }
+
+    hook_dsc[i].drv = drv;
+    hook_dsc[i].orig = *drv;
+
+    /*Wrap only the implemented callbacks to keep LVGL's "not implemented" checks working*/
+    if(drv->open_cb) drv->open_cb = hook_open;
+    if(drv->close_cb) drv->close_cb = hook_close;
+    if(drv->read_cb) drv->read_cb = hook_read;
+    if(drv->write_cb) drv->write_cb = hook_write;
+    if(drv->seek_cb) drv->seek_cb = hook_seek;
+    if(drv->tell_cb) drv->tell_cb = hook_tell;
+    if(drv->dir_open_cb) drv->dir_open_cb = hook_dir_open;
+    if(drv->dir_read_cb) drv->dir_read_cb = hook_dir_read;
+    if(drv->dir_close_cb) drv->dir_close_cb = hook_dir_close;
+
+#if LV_FS_IF_STATS
+    lv_fs_if_stats_add(drv);
+#endif
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+static void * hook_open(lv_fs_drv_t * drv, const char * path, lv_fs_mode_t mode)
+{
+    lv_fs_if_event_t e;
+    event_start(&e, drv, LV_FS_IF_OP_OPEN, NULL);
+    e.handle = get_orig(drv)->open_cb(drv, path, mode);
+    e.res = e.handle ? LV_FS_RES_OK : LV_FS_RES_UNKNOWN;
+    e.path = path;
+    e.arg = mode;
+    event_send(&e);
+    return e.handle;
+}
+
+static lv_fs_res_t hook_close(lv_fs_drv_t * drv, void * file_p)
+{
+    lv_fs_if_event_t e;
+    event_start(&e, drv, LV_FS_IF_OP_CLOSE, file_p);
+    e.res = get_orig(drv)->close_cb(drv, file_p);
+    event_send(&e);
+    return e.res;
+}
+
+static lv_fs_res_t hook_read(lv_fs_drv_t * drv, void * file_p, void * buf, uint32_t btr, uint32_t * br)
+{
+    lv_fs_if_event_t e;
+    event_start(&e, drv, LV_FS_IF_OP_READ, file_p);
+    e.res = get_orig(drv)->read_cb(drv, file_p, buf, btr, br);
+    e.arg = btr;
+    e.ret = *br;
+    event_send(&e);
+    return e.res;
+}
+
+static lv_fs_res_t hook_write(lv_fs_drv_t * drv, void * file_p, const void * buf, uint32_t btw, uint32_t * bw)
+{
+    lv_fs_if_event_t e;
+    event_start(&e, drv, LV_FS_IF_OP_WRITE, file_p);
+    e.res = get_orig(drv)->write_cb(drv, file_p, buf, btw, bw);
+    e.arg = btw;
+    e.ret = *bw;
+    event_send(&e);
+    return e.res;
+}
+
+static lv_fs_res_t hook_seek(lv_fs_drv_t * drv, void * file_p, uint32_t pos, lv_fs_whence_t whence)
+{
+    lv_fs_if_event_t e;
+    event_start(&e, drv, LV_FS_IF_OP_SEEK, file_p);
+    e.res = get_orig(drv)->seek_cb(drv, file_p, pos, whence);
+    e.arg = pos;
+    e.ret = whence;
+    event_send(&e);
+    return e.res;
+}
+
+static lv_fs_res_t hook_tell(lv_fs_drv_t * drv, void * file_p, uint32_t * pos_p)
+{
+    lv_fs_if_event_t e;
+    event_start(&e, drv, LV_FS_IF_OP_TELL, file_p);
+    e.res = get_orig(drv)->tell_cb(drv, file_p, pos_p);
+    e.ret = *pos_p;
+    event_send(&e);
+    return e.res;
+}
+
+static void * hook_dir_open(lv_fs_drv_t * drv, const char * path)
+{
+    lv_fs_if_event_t e;
+    event_start(&e, drv, LV_FS_IF_OP_DIR_OPEN, NULL);
+    e.handle = get_orig(drv)->dir_open_cb(drv, path);
+    e.res = e.handle ? LV_FS_RES_OK : LV_FS_RES_UNKNOWN;
+    e.path = path;
+    event_send(&e);
+    return e.handle;
+}
+
+static lv_fs_res_t hook_dir_read(lv_fs_drv_t * drv, void * dir_p, char * fn)
+{
+    lv_fs_if_event_t e;
+    event_start(&e, drv, LV_FS_IF_OP_DIR_READ, dir_p);
+    e.res = get_orig(drv)->dir_read_cb(drv, dir_p, fn);
+    event_send(&e);
+    return e.res;
+}
+
+static lv_fs_res_t hook_dir_close(lv_fs_drv_t * drv, void * dir_p)
+{
+    lv_fs_if_event_t e;
+    event_start(&e, drv, LV_FS_IF_OP_DIR_CLOSE, dir_p);
+    e.res = get_orig(drv)->dir_close_cb(drv, dir_p);
+    event_send(&e);
+    return e.res;
+}
+
+/**
+ * Get the original callbacks of a wrapped driver
+ * @param drv pointer to a driver
+ * @return the copy of the driver with the original callbacks or NULL if not wrapped
+ */
+static const lv_fs_drv_t * get_orig(const lv_fs_drv_t * drv)
+{
+    uint32_t i;
+    for(i = 0; i < LV_FS_IF_EXT_MAX && hook_dsc[i].drv; i++) {
+        if(hook_dsc[i].drv == drv) return &hook_dsc[i].orig;
+    }
+
+    return NULL;
+}
+
+/**
+ * Start an event. The calls are not locked, the features lock their own state.
+ */
+static void event_start(lv_fs_if_event_t * e, lv_fs_drv_t * drv, lv_fs_if_op_t op, void * handle)
+{
+    e->drv = drv;
+    e->op = op;
+    e->handle = handle;
+    e->path = NULL;
+    e->arg = 0;
+    e->ret = 0;
+    e->nested = call_depth > 0;
+    call_depth++;
+    e->start_us = lv_fs_if_time_us();
+}
+
+/**
+ * Finish an event and pass it to the enabled features
+ */
+static void event_send(lv_fs_if_event_t * e)
+{
+    e->time_us = lv_fs_if_time_us() - e->start_us;
+    call_depth--;
+
+#if LV_FS_IF_STATS
+    lv_fs_if_stats_event(e);
+#endif
+
+#if LV_FS_IF_TRACE
+    lv_fs_if_trace_event(e);
+#endif
+
+#if LV_FS_IF_PREFETCH
+    lv_fs_if_prefetch_event(e);
+#endif
+}
+
+#endif /*LV_USE_FS_IF && LV_FS_IF_HOOK*/
@@ -0,0 +1,172 @@
+/**
+ * @file lv_fs_if_pool.c
+ *
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "lv_fs_if.h"
+#include <string.h>
+
+#if LV_USE_FS_IF
+
+/*********************
+ *      DEFINES
+ *********************/
+#define IDX_MASK        0xFFFFU
+#define TAG_INC         0x10000U
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+static void stat_used_inc(lv_fs_if_pool_t * pool);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+
+/**********************
+ *      MACROS
+ **********************/
+#if defined(__GNUC__) || defined(__clang__)
+# define POOL_LOAD(p)           __atomic_load_n(p, __ATOMIC_ACQUIRE)
+# define POOL_STORE(p, v)       __atomic_store_n(p, v, __ATOMIC_RELAXED)
+# define POOL_CAS(p, old, new)  __atomic_compare_exchange_n(p, old, new, true, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)
+# define POOL_ADD(p, v)         __atomic_add_fetch(p, v, __ATOMIC_RELAXED)
+#else
+/*No atomics: the calls of a pool must not run concurrently*/
+# define POOL_LOAD(p)           (*(p))
+# define POOL_STORE(p, v)       (*(p) = (v))
+# define POOL_CAS(p, old, new)  (*(p) == *(old) ? (*(p) = (new), true) : (*(old) = *(p), false))
+# define POOL_ADD(p, v)         (*(p) += (v))
+#endif
+
+/*The first bytes of a free object hold the index + 1 of the next free object*/
+#define OBJ_NEXT(pool, idx)     ((uint32_t *)((pool)->buf + (idx) * (pool)->obj_size))
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+/**
+ * Initialize a pool
+ * @param pool pointer to a pool
+ * @param buf memory for `cnt` objects
+ * @param obj_size size of an object. At least `sizeof(void *)`
+ * @param cnt number of objects
+ */
+void lv_fs_if_pool_init(lv_fs_if_pool_t * pool, void * buf, uint32_t obj_size, uint32_t cnt)
+{
+    LV_ASSERT(cnt < IDX_MASK);
+
+    pool->buf = buf;
+    pool->obj_size = obj_size;
+    pool->stat.total = cnt;
+    pool->stat.used = 0;
+    pool->stat.max_used = 0;
+    pool->stat.fallback_cnt = 0;
+
+    /*Chain the objects into a free list*/
+    uint32_t i;
+    for(i = 0; i < cnt; i++) {
+        *OBJ_NEXT(pool, i) = i + 1 < cnt ? i + 2 : 0;
+    }
+    pool->free_head = cnt ? 1 : 0;
+}
+
+/**
+ * Allocate an object from a pool or with `lv_mem_alloc` if the pool is full
+ * @param pool pointer to a pool
+ * @return pointer to the object or NULL on out of memory
+ */
+void * lv_fs_if_pool_alloc(lv_fs_if_pool_t * pool)
+{
+    uint32_t head = POOL_LOAD(&pool->free_head);
+    uint32_t idx;
+    do {
+        idx = head & IDX_MASK;
+        if(idx == 0) {
+            POOL_ADD(&pool->stat.fallback_cnt, 1);
+            return lv_mem_alloc(pool->obj_size);
+        }
+
+        /*`next` might be stale if an other thread took the object meanwhile, but then the tag changed too*/
+        uint32_t next = POOL_LOAD(OBJ_NEXT(pool, idx - 1));
+        if(POOL_CAS(&pool->free_head, &head, (head & ~IDX_MASK) + TAG_INC + next)) break;
+    } while(1);
+
+    stat_used_inc(pool);
+    return pool->buf + (idx - 1) * pool->obj_size;
+}
+
+/**
+ * Free an object allocated with `lv_fs_if_pool_alloc()`
+ * @param pool pointer to a pool
+ * @param obj pointer to the object
+ */
+void lv_fs_if_pool_free(lv_fs_if_pool_t * pool, void * obj)
+{
+    uint8_t * p = obj;
+    if(p < pool->buf || p >= pool->buf + pool->stat.total * pool->obj_size) {
+        lv_mem_free(obj);
+        return;
+    }
+
+    /*Uncount first so `used` can't exceed `total` when an other thread takes the object right away*/
+    POOL_ADD(&pool->stat.used, (uint32_t)-1);
+
+    uint32_t idx = (p - pool->buf) / pool->obj_size + 1;
+    uint32_t head = POOL_LOAD(&pool->free_head);
+    do {
+        POOL_STORE(OBJ_NEXT(pool, idx - 1), head & IDX_MASK);
+    } while(!POOL_CAS(&pool->free_head, &head, (head & ~IDX_MASK) + TAG_INC + idx));
+}
+
+/**
+ * Get the usage statistics of the handle pools of a driver. Useful to tune
+ * `LV_FS_IF_FILE_POOL_SIZE` and `LV_FS_IF_DIR_POOL_SIZE`.
+ * @param letter the letter of the driver
+ * @param file_stat pointer to store the statistics of the file pool (can be NULL)
+ * @param dir_stat pointer to store the statistics of the directory pool (can be NULL)
+ * @return LV_FS_RES_OK or LV_FS_RES_NOT_EX if the driver has no pools
+ */
+lv_fs_res_t lv_fs_if_get_pool_stat(char letter, lv_fs_if_pool_stat_t * file_stat, lv_fs_if_pool_stat_t * dir_stat)
+{
+    lv_fs_drv_t * drv = lv_fs_get_drv(letter);
+    const lv_fs_if_ext_t * ext = drv ? lv_fs_if_get_ext(drv) : NULL;
+    if(ext == NULL || (ext->file_pool == NULL && ext->dir_pool == NULL)) return LV_FS_RES_NOT_EX;
+
+    if(file_stat) {
+        if(ext->file_pool) *file_stat = ext->file_pool->stat;
+        else memset(file_stat, 0, sizeof(lv_fs_if_pool_stat_t));
+    }
+
+    if(dir_stat) {
+        if(ext->dir_pool) *dir_stat = ext->dir_pool->stat;
+        else memset(dir_stat, 0, sizeof(lv_fs_if_pool_stat_t));
+    }
+
+    return LV_FS_RES_OK;
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+/**
+ * Count an allocation and update the high-water mark
+ * @param pool pointer to a pool
+ */
+static void stat_used_inc(lv_fs_if_pool_t * pool)
+{
+    uint32_t used = POOL_ADD(&pool->stat.used, 1);
+    uint32_t max = POOL_LOAD(&pool->stat.max_used);
+    while(used > max && !POOL_CAS(&pool->stat.max_used, &max, used));
+}
+
+#endif /*LV_USE_FS_IF*/
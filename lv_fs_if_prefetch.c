@@ -0,0 +1,560 @@
+/**
+ * @file lv_fs_if_prefetch.c
+ *
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "lv_fs_if.h"
+
+#if LV_USE_FS_IF && LV_FS_IF_PREFETCH
+#include <pthread.h>
+#include <string.h>
+
+/*********************
+ *      DEFINES
+ *********************/
+/*The trace file. Loaded by `lv_fs_if_init()` and written by `lv_fs_if_prefetch_save()`*/
+#ifndef LV_FS_IF_PREFETCH_FILE
+# define LV_FS_IF_PREFETCH_FILE         "S:/boot.trace"
+#endif
+
+/*Max. number of bytes prefetched beyond the last read of the UI found in the trace*/
+#ifndef LV_FS_IF_PREFETCH_AHEAD
+# define LV_FS_IF_PREFETCH_AHEAD        (256 * 1024U)
+#endif
+
+/*Max. number of reads in a trace. Contiguous reads of a file are stored as one.*/
+#ifndef LV_FS_IF_PREFETCH_REC_MAX
+# define LV_FS_IF_PREFETCH_REC_MAX      512
+#endif
+
+/*Max. number of different files in a trace*/
+#ifndef LV_FS_IF_PREFETCH_PATH_MAX
+# define LV_FS_IF_PREFETCH_PATH_MAX     64
+#endif
+
+/*Memory for the paths of the files in a trace in bytes*/
+#ifndef LV_FS_IF_PREFETCH_PATH_BUF_SIZE
+# define LV_FS_IF_PREFETCH_PATH_BUF_SIZE    2048
+#endif
+
+/*Max. number of files opened at the same time which are tracked*/
+#ifndef LV_FS_IF_PREFETCH_HANDLE_MAX
+# define LV_FS_IF_PREFETCH_HANDLE_MAX   16
+#endif
+
+#define TRACE_MAGIC         "LVPT"
+#define TRACE_VERSION       1
+#define TRACE_HEADER_SIZE   16      /*magic, version (u16), path_cnt (u16), path_buf_size (u32), rec_cnt (u32)*/
+#define TRACE_REC_SIZE      12      /*path (u16), reserved (u16), ofs (u32), len (u32)*/
+#define MERGE_DEPTH         8       /*Look back this many records for a read to continue*/
+#define MATCH_WINDOW        64      /*Look for the reads of the UI this many records beyond the prefetched ones*/
+#define PATH_NONE           0xFFFF
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+typedef enum {
+    PF_IDLE,
+    PF_RECORD,
+    PF_REPLAY,
+} pf_state_t;
+
+typedef struct {
+    uint16_t path;      /*Index of the path*/
+    uint32_t ofs;
+    uint32_t len;
+    uint32_t sum;       /*Total length of the earlier records. Not saved.*/
+} pf_rec_t;
+
+/*A file opened for reading, to know the position of its reads*/
+typedef struct {
+    lv_fs_drv_t * drv;
+    void * handle;      /*NULL: free entry*/
+    uint32_t pos;
+    uint16_t path;
+    uint8_t pos_known;  /*0 after seeking from the end until the next tell*/
+} pf_handle_t;
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+void lv_fs_if_prefetch_init(void);
+void lv_fs_if_prefetch_event(const lv_fs_if_event_t * e);
+static void * prefetch_thread(void * arg);
+static void prefetch_part(uint16_t path_idx, uint32_t ofs, uint32_t len);
+static void ui_progress(uint16_t path, uint32_t ofs, uint32_t len);
+static void rec_add(uint16_t path, uint32_t ofs, uint32_t len);
+static uint16_t path_find(char letter, const char * path, bool add);
+static pf_handle_t * handle_find(const lv_fs_drv_t * drv, const void * handle);
+static lv_fs_res_t trace_load(void);
+static lv_fs_res_t trace_save(void);
+static lv_fs_res_t read_all(lv_fs_file_t * f, void * buf, uint32_t len);
+static lv_fs_res_t write_all(lv_fs_file_t * f, const void * buf, uint32_t len);
+static void put_u16(uint8_t * p, uint16_t v);
+static void put_u32(uint8_t * p, uint32_t v);
+static uint16_t get_u16(const uint8_t * p);
+static uint32_t get_u32(const uint8_t * p);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+static pf_rec_t recs[LV_FS_IF_PREFETCH_REC_MAX];
+static uint32_t rec_cnt;
+
+static char path_buf[LV_FS_IF_PREFETCH_PATH_BUF_SIZE];  /*'\0' terminated paths with the letter, e.g. "S:/img/bg.bin"*/
+static uint32_t path_buf_used;
+static uint32_t path_ofs[LV_FS_IF_PREFETCH_PATH_MAX];
+static lv_fs_drv_t * path_drv[LV_FS_IF_PREFETCH_PATH_MAX];  /*Looked up when the trace is loaded*/
+static uint32_t path_cnt;
+
+static pf_handle_t handles[LV_FS_IF_PREFETCH_HANDLE_MAX];
+static uint8_t state;
+static uint32_t ui_idx;         /*The record the UI reads now (or the one after its last read)*/
+static uint32_t ui_sum;         /*Bytes of the trace read by the UI, counted up to its last read*/
+static uint32_t pf_idx;         /*The record to prefetch next*/
+static uint32_t pf_done;        /*Bytes of `pf_idx` already prefetched*/
+
+static pthread_t thread;
+static bool thread_created;
+static pthread_t thread_self;   /*Set by the prefetch thread itself, to ignore its calls*/
+static bool thread_started;
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t progress_cond = PTHREAD_COND_INITIALIZER;     /*Signaled when the UI reads further*/
+
+/**********************
+ *      MACROS
+ **********************/
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+/**
+ * Replay the trace if there is one, else start recording. Called by `lv_fs_if_init()`.
+ */
+void lv_fs_if_prefetch_init(void)
+{
+    if(trace_load() != LV_FS_RES_OK || rec_cnt == 0) {
+        rec_cnt = 0;
+        path_cnt = 0;
+        path_buf_used = 0;
+        state = PF_RECORD;
+        return;
+    }
+
+    state = PF_REPLAY;
+    if(pthread_create(&thread, NULL, prefetch_thread, NULL) != 0) {
+        LV_LOG_ERROR("lv_fs_if_prefetch_init: couldn't create the prefetch thread");
+        state = PF_IDLE;
+        return;
+    }
+    thread_created = true;
+}
+
+/**
+ * Stop recording and save the reads recorded since `lv_fs_if_init()` to `LV_FS_IF_PREFETCH_FILE`.
+ * Call it when the first screen is ready. Does nothing if a trace was loaded at boot.
+ * @return LV_FS_RES_OK, LV_FS_RES_DENIED if not recording or any error from lv_fs_res_t enum
+ */
+lv_fs_res_t lv_fs_if_prefetch_save(void)
+{
+    pthread_mutex_lock(&lock);
+    bool recording = state == PF_RECORD;
+    if(recording) state = PF_IDLE;
+    pthread_mutex_unlock(&lock);
+
+    /*The records don't change anymore so they can be used without the lock*/
+    return recording ? trace_save() : LV_FS_RES_DENIED;
+}
+
+/**
+ * Stop recording or replaying the trace. Waits for the prefetch thread to finish its current read.
+ */
+void lv_fs_if_prefetch_stop(void)
+{
+    pthread_mutex_lock(&lock);
+    state = PF_IDLE;
+    bool join = thread_created;
+    thread_created = false;
+    pthread_cond_broadcast(&progress_cond);
+    pthread_mutex_unlock(&lock);
+
+    if(join) pthread_join(thread, NULL);
+}
+
+/**
+ * Track the reads of the UI. Called by the hooks after every driver call, from any thread.
+ * @param e pointer to the event
+ */
+void lv_fs_if_prefetch_event(const lv_fs_if_event_t * e)
+{
+    /*The UI reads the files of the outer drive, e.g. the ones of the cache, not of its backend*/
+    if(e->nested) return;
+
+    pthread_mutex_lock(&lock);
+
+    /*Only the reads of the UI matter, not the ones of the prefetcher*/
+    if(state == PF_IDLE || (thread_started && pthread_equal(pthread_self(), thread_self))) {
+        pthread_mutex_unlock(&lock);
+        return;
+    }
+
+    pf_handle_t * h = NULL;
+    if(e->op != LV_FS_IF_OP_OPEN) h = handle_find(e->drv, e->handle);
+
+    switch(e->op) {
+    case LV_FS_IF_OP_OPEN:
+        /*Files opened for writing change so their reads are not worth prefetching*/
+        if(e->res == LV_FS_RES_OK && e->arg == LV_FS_MODE_RD) {
+            uint16_t path = path_find(e->drv->letter, e->path, state == PF_RECORD);
+            h = path == PATH_NONE ? NULL : handle_find(NULL, NULL);
+            if(h) {
+                h->drv = e->drv;
+                h->handle = e->handle;
+                h->pos = 0;
+                h->path = path;
+                h->pos_known = 1;
+            }
+        }
+        break;
+    case LV_FS_IF_OP_CLOSE:
+        if(h) h->handle = NULL;
+        break;
+    case LV_FS_IF_OP_SEEK:
+        if(h == NULL || e->res != LV_FS_RES_OK) break;
+        if(e->ret == LV_FS_SEEK_SET) {
+            h->pos = e->arg;
+            h->pos_known = 1;
+        }
+        else if(e->ret == LV_FS_SEEK_CUR) {
+            h->pos += e->arg;
+        }
+        else {
+            h->pos_known = 0;
+        }
+        break;
+    case LV_FS_IF_OP_TELL:
+        if(h && e->res == LV_FS_RES_OK) {
+            h->pos = e->ret;
+            h->pos_known = 1;
+        }
+        break;
+    case LV_FS_IF_OP_READ:
+        if(h == NULL) break;
+        if(h->pos_known && e->ret > 0) {
+            if(state == PF_RECORD) rec_add(h->path, h->pos, e->ret);
+            else ui_progress(h->path, h->pos, e->ret);
+        }
+        h->pos += e->ret;
+        break;
+    default:
+        break;
+    }
+
+    pthread_mutex_unlock(&lock);
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+/**
+ * Prefetch the records of the trace but at most `LV_FS_IF_PREFETCH_AHEAD` bytes ahead of the UI
+ * @param arg unused
+ * @return NULL
+ */
+static void * prefetch_thread(void * arg)
+{
+    (void) arg;     /*Unused*/
+
+    pthread_mutex_lock(&lock);
+    thread_self = pthread_self();
+    thread_started = true;
+
+    while(state == PF_REPLAY) {
+        /*Skip what the UI has already read*/
+        if(pf_idx < rec_cnt && recs[pf_idx].sum + pf_done < ui_sum) {
+            pf_idx = ui_idx;
+            pf_done = pf_idx < rec_cnt ? ui_sum - recs[pf_idx].sum : 0;
+        }
+        if(pf_idx >= rec_cnt) break;
+
+        /*Parts of the records can be prefetched too as they can be large*/
+        uint32_t ahead = recs[pf_idx].sum + pf_done - ui_sum;
+        if(ahead >= LV_FS_IF_PREFETCH_AHEAD) {
+            pthread_cond_wait(&progress_cond, &lock);
+            continue;
+        }
+
+        const pf_rec_t * rec = &recs[pf_idx];
+        uint32_t len = LV_MIN(rec->len - pf_done, LV_FS_IF_PREFETCH_AHEAD - ahead);
+        uint16_t path = rec->path;
+        uint32_t ofs = rec->ofs + pf_done;
+        pf_done += len;
+        if(pf_done == rec->len) {
+            pf_idx++;
+            pf_done = 0;
+        }
+        pthread_mutex_unlock(&lock);
+
+        prefetch_part(path, ofs, len);
+
+        pthread_mutex_lock(&lock);
+    }
+
+    pthread_mutex_unlock(&lock);
+    return NULL;
+}
+
+/**
+ * Load a part of a file into the cache of its driver with its `prefetch_cb`.
+ * Drives without it are skipped: reading the part without keeping it would only slow down the UI.
+ * @param path_idx index of the path
+ * @param ofs position of the part
+ * @param len length of the part
+ */
+static void prefetch_part(uint16_t path_idx, uint32_t ofs, uint32_t len)
+{
+    lv_fs_drv_t * drv = path_drv[path_idx];
+    if(drv == NULL) return;
+
+    const lv_fs_if_ext_t * ext = lv_fs_if_get_ext(drv);
+    if(ext == NULL || ext->prefetch_cb == NULL) return;
+
+    const char * path = path_buf + path_ofs[path_idx] + 2;     /*Skip "X:"*/
+    ext->prefetch_cb(drv, path, ofs, len);
+}
+
+/**
+ * Find a read of the UI in the trace and let the prefetcher run further. Called with the lock held.
+ * @param path index of the path
+ * @param ofs position of the read
+ * @param len number of bytes read
+ */
+static void ui_progress(uint16_t path, uint32_t ofs, uint32_t len)
+{
+    /*Reads not in the trace are ignored, the UI might have skipped some records though*/
+    uint32_t end = LV_MIN(rec_cnt, LV_MAX(ui_idx, pf_idx) + MATCH_WINDOW);
+    uint32_t i;
+    for(i = ui_idx; i < end; i++) {
+        const pf_rec_t * r = &recs[i];
+        if(r->path != path || ofs >= r->ofs + r->len || ofs + len <= r->ofs) continue;
+
+        /*Stay at the record until it's read to the end*/
+        uint32_t done = LV_MIN(ofs + len - r->ofs, r->len);
+        ui_idx = done == r->len ? i + 1 : i;
+        ui_sum = LV_MAX(ui_sum, r->sum + done);
+        pthread_cond_signal(&progress_cond);
+        return;
+    }
+}
+
+/**
+ * Add a read to the trace. Called with the lock held.
+ * @param path index of the path
+ * @param ofs position of the read
+ * @param len number of bytes read
+ */
+static void rec_add(uint16_t path, uint32_t ofs, uint32_t len)
+{
+    /*Continue a recent read of the file, even if other files were read in between*/
+    uint32_t i;
+    for(i = rec_cnt; i > 0 && i + MERGE_DEPTH > rec_cnt; i--) {
+        pf_rec_t * r = &recs[i - 1];
+        if(r->path == path && r->ofs + r->len == ofs) {
+            r->len += len;
+            return;
+        }
+    }
+
+    if(rec_cnt == LV_FS_IF_PREFETCH_REC_MAX) return;
+
+    recs[rec_cnt].path = path;
+    recs[rec_cnt].ofs = ofs;
+    recs[rec_cnt].len = len;
+    rec_cnt++;
+}
+
+/**
+ * Get the index of a path. Called with the lock held.
+ * @param letter the letter of the driver
+ * @param path the path without the letter
+ * @param add true: add the path if it's new
+ * @return index of the path or PATH_NONE if it's not found or there is no room for it
+ */
+static uint16_t path_find(char letter, const char * path, bool add)
+{
+    uint32_t i;
+    for(i = 0; i < path_cnt; i++) {
+        const char * p = path_buf + path_ofs[i];
+        if(p[0] == letter && strcmp(p + 2, path) == 0) return i;
+    }
+
+    uint32_t len = strlen(path) + 3;     /*"X:" and '\0'*/
+    if(!add || path_cnt == LV_FS_IF_PREFETCH_PATH_MAX || path_buf_used + len > LV_FS_IF_PREFETCH_PATH_BUF_SIZE) {
+        return PATH_NONE;
+    }
+
+    char * p = path_buf + path_buf_used;
+    p[0] = letter;
+    p[1] = ':';
+    strcpy(p + 2, path);
+    path_ofs[path_cnt] = path_buf_used;
+    path_buf_used += len;
+    return path_cnt++;
+}
+
+/**
+ * Find a tracked file. Called with the lock held.
+ * @param drv pointer to the driver
+ * @param handle handle of the driver or NULL to find a free entry
+ * @return pointer to the entry or NULL if not found
+ */
+static pf_handle_t * handle_find(const lv_fs_drv_t * drv, const void * handle)
+{
+    uint32_t i;
+    for(i = 0; i < LV_FS_IF_PREFETCH_HANDLE_MAX; i++) {
+        pf_handle_t * h = &handles[i];
+        if(h->handle == handle && (handle == NULL || h->drv == drv)) return h;
+    }
+
+    return NULL;
+}
+
+/**
+ * Load the trace from `LV_FS_IF_PREFETCH_FILE`
+ * @return LV_FS_RES_OK, LV_FS_RES_FS_ERR if the trace is invalid or any error from lv_fs_res_t enum
+ */
+static lv_fs_res_t trace_load(void)
+{
+    lv_fs_file_t f;
+    lv_fs_res_t res = lv_fs_open(&f, LV_FS_IF_PREFETCH_FILE, LV_FS_MODE_RD);
+    if(res != LV_FS_RES_OK) return res;
+
+    uint8_t hdr[TRACE_HEADER_SIZE];
+    res = read_all(&f, hdr, TRACE_HEADER_SIZE);
+    if(res == LV_FS_RES_OK) {
+        path_cnt = get_u16(hdr + 6);
+        path_buf_used = get_u32(hdr + 8);
+        rec_cnt = get_u32(hdr + 12);
+        if(memcmp(hdr, TRACE_MAGIC, 4) != 0 || get_u16(hdr + 4) != TRACE_VERSION ||
+           path_cnt > LV_FS_IF_PREFETCH_PATH_MAX || path_buf_used > LV_FS_IF_PREFETCH_PATH_BUF_SIZE ||
+           rec_cnt > LV_FS_IF_PREFETCH_REC_MAX) {
+            res = LV_FS_RES_FS_ERR;
+        }
+    }
+
+    if(res == LV_FS_RES_OK) res = read_all(&f, path_buf, path_buf_used);
+
+    /*Split the paths and check that each has a letter and a closing '\0'*/
+    uint32_t ofs = 0;
+    uint32_t i;
+    for(i = 0; i < path_cnt && res == LV_FS_RES_OK; i++) {
+        const char * p = path_buf + ofs;
+        const char * z = memchr(p, '\0', path_buf_used - ofs);
+        if(z == NULL || z - p < 2 || p[1] != ':') {
+            res = LV_FS_RES_FS_ERR;
+            break;
+        }
+        path_ofs[i] = ofs;
+        path_drv[i] = lv_fs_get_drv(p[0]);
+        ofs += z - p + 1;
+    }
+
+    uint32_t sum = 0;
+    for(i = 0; i < rec_cnt && res == LV_FS_RES_OK; i++) {
+        uint8_t buf[TRACE_REC_SIZE];
+        res = read_all(&f, buf, TRACE_REC_SIZE);
+        if(res != LV_FS_RES_OK) break;
+
+        recs[i].path = get_u16(buf);
+        recs[i].ofs = get_u32(buf + 4);
+        recs[i].len = get_u32(buf + 8);
+        recs[i].sum = sum;
+        sum += recs[i].len;
+        if(recs[i].path >= path_cnt) res = LV_FS_RES_FS_ERR;
+    }
+
+    lv_fs_close(&f);
+
+    if(res != LV_FS_RES_OK) {
+        LV_LOG_WARN("lv_fs_if_prefetch: invalid trace in %s", LV_FS_IF_PREFETCH_FILE);
+    }
+    return res;
+}
+
+/**
+ * Write the recorded trace to `LV_FS_IF_PREFETCH_FILE`
+ * @return LV_FS_RES_OK or any error from lv_fs_res_t enum
+ */
+static lv_fs_res_t trace_save(void)
+{
+    lv_fs_file_t f;
+    lv_fs_res_t res = lv_fs_open(&f, LV_FS_IF_PREFETCH_FILE, LV_FS_MODE_WR);
+    if(res != LV_FS_RES_OK) return res;
+
+    uint8_t hdr[TRACE_HEADER_SIZE];
+    memcpy(hdr, TRACE_MAGIC, 4);
+    put_u16(hdr + 4, TRACE_VERSION);
+    put_u16(hdr + 6, path_cnt);
+    put_u32(hdr + 8, path_buf_used);
+    put_u32(hdr + 12, rec_cnt);
+    res = write_all(&f, hdr, TRACE_HEADER_SIZE);
+    if(res == LV_FS_RES_OK) res = write_all(&f, path_buf, path_buf_used);
+
+    uint32_t i;
+    for(i = 0; i < rec_cnt && res == LV_FS_RES_OK; i++) {
+        uint8_t buf[TRACE_REC_SIZE];
+        put_u16(buf, recs[i].path);
+        put_u16(buf + 2, 0);
+        put_u32(buf + 4, recs[i].ofs);
+        put_u32(buf + 8, recs[i].len);
+        res = write_all(&f, buf, TRACE_REC_SIZE);
+    }
+
+    lv_fs_res_t close_res = lv_fs_close(&f);
+    return res != LV_FS_RES_OK ? res : close_res;
+}
+
+static lv_fs_res_t read_all(lv_fs_file_t * f, void * buf, uint32_t len)
+{
+    uint32_t br = 0;
+    lv_fs_res_t res = lv_fs_read(f, buf, len, &br);
+    if(res == LV_FS_RES_OK && br != len) res = LV_FS_RES_FS_ERR;
+    return res;
+}
+
+static lv_fs_res_t write_all(lv_fs_file_t * f, const void * buf, uint32_t len)
+{
+    uint32_t bw = 0;
+    lv_fs_res_t res = lv_fs_write(f, buf, len, &bw);
+    if(res == LV_FS_RES_OK && bw != len) res = LV_FS_RES_FULL;
+    return res;
+}
+
+static void put_u16(uint8_t * p, uint16_t v)
+{
+    p[0] = v & 0xFF;
+    p[1] = v >> 8;
+}
+
+static void put_u32(uint8_t * p, uint32_t v)
+{
+    put_u16(p, v & 0xFFFF);
+    put_u16(p + 2, v >> 16);
+}
+
+static uint16_t get_u16(const uint8_t * p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+static uint32_t get_u32(const uint8_t * p)
+{
+    return get_u16(p) | ((uint32_t)get_u16(p + 2) << 16);
+}
+
+#endif /*LV_USE_FS_IF && LV_FS_IF_PREFETCH*/
@@ -0,0 +1,195 @@
+/**
+ * @file lv_fs_if_stats.c
+ *
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "lv_fs_if.h"
+
+#if LV_USE_FS_IF && LV_FS_IF_STATS
+#include <string.h>
+#if LV_FS_IF_ASYNC || LV_FS_IF_PREFETCH
+#include <pthread.h>
+#endif
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+typedef struct {
+    lv_fs_drv_t * drv;
+    lv_fs_if_stats_t stats;
+} stats_dsc_t;
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+void lv_fs_if_stats_add(lv_fs_drv_t * drv);
+void lv_fs_if_stats_event(const lv_fs_if_event_t * e);
+static stats_dsc_t * get_dsc(const lv_fs_drv_t * drv);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+static stats_dsc_t stats_dsc[LV_FS_IF_EXT_MAX];
+
+#if LV_FS_IF_ASYNC || LV_FS_IF_PREFETCH
+/*The events can come from the worker and prefetch threads too*/
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+static const char * const op_names[_LV_FS_IF_OP_LAST] = {
+    "open", "close", "read", "write", "seek", "tell", "dir_open", "dir_read", "dir_close"
+};
+
+/**********************
+ *      MACROS
+ **********************/
+#if LV_FS_IF_ASYNC || LV_FS_IF_PREFETCH
+# define STATS_LOCK()       pthread_mutex_lock(&lock)
+# define STATS_UNLOCK()     pthread_mutex_unlock(&lock)
+#else
+# define STATS_LOCK()
+# define STATS_UNLOCK()
+#endif
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+/**
+ * Get the statistics of a driver
+ * @param letter the letter of the driver
+ * @return pointer to the statistics or NULL if the driver is not registered by `lv_fs_if_init()`
+ */
+const lv_fs_if_stats_t * lv_fs_if_stats_get(char letter)
+{
+    stats_dsc_t * dsc = get_dsc(lv_fs_get_drv(letter));
+    return dsc ? &dsc->stats : NULL;
+}
+
+/**
+ * Clear the statistics of a driver
+ * @param letter the letter of the driver or '\0' to clear all drivers
+ */
+void lv_fs_if_stats_reset(char letter)
+{
+    STATS_LOCK();
+    uint32_t i;
+    for(i = 0; i < LV_FS_IF_EXT_MAX && stats_dsc[i].drv; i++) {
+        if(letter == '\0' || stats_dsc[i].drv->letter == letter) {
+            memset(&stats_dsc[i].stats, 0, sizeof(lv_fs_if_stats_t));
+        }
+    }
+    STATS_UNLOCK();
+}
+
+/**
+ * Get a percentile of the latency of a callback from the histogram
+ * @param stats pointer to statistics
+ * @param op the callback
+ * @param percent e.g. 50 or 99
+ * @return upper bound of the latency in microseconds (0 if there were no calls)
+ */
+uint32_t lv_fs_if_stats_percentile(const lv_fs_if_stats_t * stats, lv_fs_if_op_t op, uint32_t percent)
+{
+    uint32_t cnt = stats->cnt[op];
+    if(cnt == 0) return 0;
+
+    /*The rank of the sample, rounded up*/
+    uint64_t rank = ((uint64_t)cnt * percent + 99) / 100;
+    uint64_t sum = 0;
+    uint32_t b;
+    for(b = 0; b < LV_FS_IF_STATS_HIST_SIZE - 1; b++) {
+        sum += stats->hist[op][b];
+        if(sum >= rank) break;
+    }
+
+    return (uint32_t)1 << b;
+}
+
+/**
+ * Print the statistics of all drivers with `LV_LOG_USER`
+ */
+void lv_fs_if_stats_dump(void)
+{
+    STATS_LOCK();
+    uint32_t i;
+    for(i = 0; i < LV_FS_IF_EXT_MAX && stats_dsc[i].drv; i++) {
+        const lv_fs_if_stats_t * s = &stats_dsc[i].stats;
+        LV_LOG_USER("%c: read %llu bytes, written %llu bytes", stats_dsc[i].drv->letter,
+                    (unsigned long long)s->read_bytes, (unsigned long long)s->write_bytes);
+
+        uint32_t op;
+        for(op = 0; op < _LV_FS_IF_OP_LAST; op++) {
+            if(s->cnt[op] == 0) continue;
+            LV_LOG_USER("  %-9s cnt: %u, err: %u, avg: %u us, p50: <%u us, p99: <%u us", op_names[op],
+                        (unsigned)s->cnt[op], (unsigned)s->err_cnt[op], (unsigned)(s->time_us[op] / s->cnt[op]),
+                        (unsigned)lv_fs_if_stats_percentile(s, op, 50), (unsigned)lv_fs_if_stats_percentile(s, op, 99));
+        }
+    }
+    STATS_UNLOCK();
+}
+
+/**
+ * Start collecting statistics for a driver. Called when the driver is hooked.
+ * @param drv pointer to a driver
+ */
+void lv_fs_if_stats_add(lv_fs_drv_t * drv)
+{
+    uint32_t i;
+    for(i = 0; i < LV_FS_IF_EXT_MAX; i++) {
+        if(stats_dsc[i].drv == NULL) {
+            stats_dsc[i].drv = drv;
+            return;
+        }
+    }
+}
+
+/**
+ * Account a driver call
+ * @param e pointer to the event describing the call
+ */
+void lv_fs_if_stats_event(const lv_fs_if_event_t * e)
+{
+    stats_dsc_t * dsc = get_dsc(e->drv);
+    if(dsc == NULL) return;
+
+    /*Find the first bucket whose limit (2^b us) is above the latency*/
+    uint32_t b = 0;
+    while(b < LV_FS_IF_STATS_HIST_SIZE - 1 && e->time_us >= ((uint32_t)1 << b)) b++;
+
+    STATS_LOCK();
+    lv_fs_if_stats_t * s = &dsc->stats;
+    s->cnt[e->op]++;
+    if(e->res != LV_FS_RES_OK) s->err_cnt[e->op]++;
+    s->time_us[e->op] += e->time_us;
+    s->hist[e->op][b]++;
+
+    if(e->op == LV_FS_IF_OP_READ) s->read_bytes += e->ret;
+    else if(e->op == LV_FS_IF_OP_WRITE) s->write_bytes += e->ret;
+    STATS_UNLOCK();
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+static stats_dsc_t * get_dsc(const lv_fs_drv_t * drv)
+{
+    if(drv == NULL) return NULL;
+
+    uint32_t i;
+    for(i = 0; i < LV_FS_IF_EXT_MAX && stats_dsc[i].drv; i++) {
+        if(stats_dsc[i].drv == drv) return &stats_dsc[i];
+    }
+
+    return NULL;
+}
+
+#endif /*LV_USE_FS_IF && LV_FS_IF_STATS*/
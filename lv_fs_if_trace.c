@@ -0,0 +1,366 @@
+/**
+ * @file lv_fs_if_trace.c
+ *
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "lv_fs_if.h"
+
+#if LV_USE_FS_IF && LV_FS_IF_TRACE
+#include <string.h>
+#if LV_FS_IF_ASYNC || LV_FS_IF_PREFETCH
+#include <pthread.h>
+#endif
+
+/*********************
+ *      DEFINES
+ *********************/
+/*The file the trace is written to. Opened by `lv_fs_if_init()`*/
+#ifndef LV_FS_IF_TRACE_FILE
+# define LV_FS_IF_TRACE_FILE            "S:/io.trace"
+#endif
+
+/*Size of the ring buffer holding the events until they are written to the file*/
+#ifndef LV_FS_IF_TRACE_BUF_SIZE
+# define LV_FS_IF_TRACE_BUF_SIZE        4096
+#endif
+
+/*Write the buffered events to the file in every this many milliseconds. 0: only in `lv_fs_if_trace_flush()`*/
+#ifndef LV_FS_IF_TRACE_FLUSH_PERIOD
+# define LV_FS_IF_TRACE_FLUSH_PERIOD    1000
+#endif
+
+/*Max. number of files and directories opened at the same time which get an ID*/
+#ifndef LV_FS_IF_TRACE_HANDLE_MAX
+# define LV_FS_IF_TRACE_HANDLE_MAX      32
+#endif
+
+/*The format is read by tools/lv_fs_if_replay.c too*/
+#define TRACE_MAGIC         "LVIT"
+#define TRACE_VERSION       1
+#define TRACE_HEADER_SIZE   16      /*magic, version (u16), rec_size (u16), data_len (u32), lost_cnt (u32)*/
+#define TRACE_REC_SIZE      24      /*op, res, letter, path_len (u8), id (u16), flags (u16),
+                                      delta_us, time_us, arg, ret (u32). Followed by path_len bytes of path*/
+#define TRACE_OP_LOST       0xFF    /*`arg` events were dropped here as the buffer was full*/
+#define TRACE_FLAG_NESTED   0x0001  /*Made by an other driver's call, so it's not replayed on its own*/
+#define ID_NONE             0xFFFF  /*The call has no handle or there was no free ID*/
+#define PATH_LEN_MAX        255
+
+#if LV_FS_IF_TRACE_BUF_SIZE < 2 * (TRACE_REC_SIZE + PATH_LEN_MAX)
+# error "LV_FS_IF_TRACE_BUF_SIZE is too small"
+#endif
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+typedef struct {
+    lv_fs_drv_t * drv;
+    void * handle;          /*NULL: free ID*/
+} trace_id_t;
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+void lv_fs_if_trace_init(void);
+void lv_fs_if_trace_event(const lv_fs_if_event_t * e);
+static uint16_t id_get(const lv_fs_if_event_t * e);
+static bool ring_put(const uint8_t * rec, const char * path, uint32_t path_len);
+static lv_fs_res_t header_write(void);
+#if LV_FS_IF_TRACE_FLUSH_PERIOD
+static void flush_timer_cb(lv_timer_t * t);
+#endif
+static void put_u16(uint8_t * p, uint16_t v);
+static void put_u32(uint8_t * p, uint32_t v);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+static uint8_t ring[LV_FS_IF_TRACE_BUF_SIZE];
+static uint32_t ring_head;      /*Written by the hooks*/
+static uint32_t ring_tail;      /*Advanced by the flush*/
+static uint32_t ring_used;
+
+static trace_id_t ids[LV_FS_IF_TRACE_HANDLE_MAX];
+static uint32_t last_start_us;
+static bool last_start_valid;
+static uint32_t lost_cnt;       /*Dropped since the last LOST record*/
+static uint32_t lost_total;
+
+static lv_fs_file_t file;
+static bool file_opened;
+static bool stopped;
+static bool self_open;          /*Set while the trace file is opened to not to record it*/
+static uint32_t data_len;       /*Bytes of events in the file*/
+
+#if LV_FS_IF_ASYNC || LV_FS_IF_PREFETCH
+/*The events can come from the worker and prefetch threads too*/
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+/**********************
+ *      MACROS
+ **********************/
+#if LV_FS_IF_ASYNC || LV_FS_IF_PREFETCH
+# define TRACE_LOCK()       pthread_mutex_lock(&lock)
+# define TRACE_UNLOCK()     pthread_mutex_unlock(&lock)
+#else
+# define TRACE_LOCK()
+# define TRACE_UNLOCK()
+#endif
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+/**
+ * Open the trace file and start flushing the events recorded since the drivers were wrapped.
+ * Called by `lv_fs_if_init()`.
+ */
+void lv_fs_if_trace_init(void)
+{
+    self_open = true;
+    lv_fs_res_t res = lv_fs_open(&file, LV_FS_IF_TRACE_FILE, LV_FS_MODE_WR);
+    self_open = false;
+    if(res != LV_FS_RES_OK) {
+        LV_LOG_WARN("lv_fs_if_trace: couldn't open %s", LV_FS_IF_TRACE_FILE);
+        TRACE_LOCK();
+        stopped = true;
+        TRACE_UNLOCK();
+        return;
+    }
+
+    file_opened = true;
+    data_len = 0;
+    if(header_write() != LV_FS_RES_OK) {
+        lv_fs_if_trace_stop();
+        return;
+    }
+
+#if LV_FS_IF_TRACE_FLUSH_PERIOD
+    lv_timer_create(flush_timer_cb, LV_FS_IF_TRACE_FLUSH_PERIOD, NULL);
+#endif
+}
+
+/**
+ * Write the buffered events to `LV_FS_IF_TRACE_FILE`. Call it from the LVGL thread.
+ * @return LV_FS_RES_OK, LV_FS_RES_DENIED if the file is not open or any error from lv_fs_res_t enum
+ */
+lv_fs_res_t lv_fs_if_trace_flush(void)
+{
+    if(!file_opened) return LV_FS_RES_DENIED;
+
+    /*The hooks only write after `ring_head`, so the used part can be written without the lock.
+     *The calls on the trace file itself are not recorded.*/
+    TRACE_LOCK();
+    uint32_t tail = ring_tail;
+    uint32_t used = ring_used;
+    TRACE_UNLOCK();
+
+    if(used == 0) return LV_FS_RES_OK;
+
+    lv_fs_res_t res = lv_fs_seek(&file, TRACE_HEADER_SIZE + data_len, LV_FS_SEEK_SET);
+    uint32_t done = 0;
+    while(done < used && res == LV_FS_RES_OK) {
+        uint32_t len = LV_MIN(used - done, LV_FS_IF_TRACE_BUF_SIZE - tail);
+        uint32_t bw = 0;
+        res = lv_fs_write(&file, ring + tail, len, &bw);
+        if(res == LV_FS_RES_OK && bw != len) res = LV_FS_RES_FULL;
+        done += len;
+        tail = (tail + len) % LV_FS_IF_TRACE_BUF_SIZE;
+    }
+
+    TRACE_LOCK();
+    ring_tail = tail;
+    ring_used -= done;
+    TRACE_UNLOCK();
+
+    /*Update the length only after the events so a crash doesn't leave a truncated record in the trace*/
+    if(res == LV_FS_RES_OK) {
+        data_len += done;
+        res = header_write();
+    }
+    if(res == LV_FS_RES_OK) res = lv_fs_if_flush(&file);
+
+    if(res != LV_FS_RES_OK) LV_LOG_WARN("lv_fs_if_trace: couldn't write %s (%d)", LV_FS_IF_TRACE_FILE, res);
+    return res;
+}
+
+/**
+ * Stop recording, write the buffered events and close the trace file
+ */
+void lv_fs_if_trace_stop(void)
+{
+    TRACE_LOCK();
+    stopped = true;
+    TRACE_UNLOCK();
+
+    if(!file_opened) return;
+
+    lv_fs_if_trace_flush();
+    lv_fs_close(&file);
+    file_opened = false;
+
+    if(lost_total) LV_LOG_WARN("lv_fs_if_trace: %u events were dropped, increase LV_FS_IF_TRACE_BUF_SIZE",
+                                   (unsigned)lost_total);
+}
+
+/**
+ * Add a driver call to the trace. Called by the hooks.
+ * @param e the finished call
+ */
+void lv_fs_if_trace_event(const lv_fs_if_event_t * e)
+{
+    if(self_open) return;
+
+    TRACE_LOCK();
+    if(stopped || (file_opened && e->drv == file.drv && e->handle == file.file_d)) {
+        TRACE_UNLOCK();
+        return;
+    }
+
+    uint32_t path_len = 0;
+    if(e->path) path_len = LV_MIN(strlen(e->path), PATH_LEN_MAX);
+
+    /*The first event of a file gets a new ID, the close frees it after recording*/
+    uint16_t id = id_get(e);
+
+    uint8_t rec[TRACE_REC_SIZE];
+    rec[0] = e->op;
+    rec[1] = e->res;
+    rec[2] = e->drv->letter;
+    rec[3] = path_len;
+    put_u16(rec + 4, id);
+    put_u16(rec + 6, e->nested ? TRACE_FLAG_NESTED : 0);
+    put_u32(rec + 8, last_start_valid ? e->start_us - last_start_us : 0);
+    put_u32(rec + 12, e->time_us);
+    put_u32(rec + 16, e->arg);
+    put_u32(rec + 20, e->ret);
+
+    /*Mark where the events were lost so the replay knows the trace is incomplete*/
+    bool ok = true;
+    if(lost_cnt) {
+        uint8_t lost[TRACE_REC_SIZE];
+        memset(lost, 0, sizeof(lost));
+        lost[0] = TRACE_OP_LOST;
+        put_u16(lost + 4, ID_NONE);
+        put_u32(lost + 16, lost_cnt);
+        ok = ring_put(lost, NULL, 0);
+        if(ok) lost_cnt = 0;
+    }
+
+    if(ok) ok = ring_put(rec, e->path, path_len);
+
+    if(ok) {
+        last_start_us = e->start_us;
+        last_start_valid = true;
+    }
+    else {
+        lost_cnt++;
+        lost_total++;
+    }
+
+    if((e->op == LV_FS_IF_OP_CLOSE || e->op == LV_FS_IF_OP_DIR_CLOSE) && id != ID_NONE) {
+        ids[id].handle = NULL;
+    }
+    TRACE_UNLOCK();
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+/**
+ * Get the ID of the handle of an event. Called with the lock held.
+ * @param e pointer to an event
+ * @return the ID or ID_NONE
+ */
+static uint16_t id_get(const lv_fs_if_event_t * e)
+{
+    if(e->handle == NULL) return ID_NONE;
+
+    uint32_t i;
+    uint32_t free_i = LV_FS_IF_TRACE_HANDLE_MAX;
+    for(i = 0; i < LV_FS_IF_TRACE_HANDLE_MAX; i++) {
+        if(ids[i].handle == e->handle && ids[i].drv == e->drv) return i;
+        if(ids[i].handle == NULL && free_i == LV_FS_IF_TRACE_HANDLE_MAX) free_i = i;
+    }
+
+    /*Only the opens get a new ID, the calls of handles opened before the tracing are not replayable*/
+    if(e->op != LV_FS_IF_OP_OPEN && e->op != LV_FS_IF_OP_DIR_OPEN) return ID_NONE;
+    if(free_i == LV_FS_IF_TRACE_HANDLE_MAX) return ID_NONE;
+
+    ids[free_i].drv = e->drv;
+    ids[free_i].handle = e->handle;
+    return free_i;
+}
+
+/**
+ * Append a record to the ring buffer. Called with the lock held.
+ * @param rec the record
+ * @param path the path following the record or NULL
+ * @param path_len length of the path
+ * @return true: added, false: there is no room
+ */
+static bool ring_put(const uint8_t * rec, const char * path, uint32_t path_len)
+{
+    uint32_t len = TRACE_REC_SIZE + path_len;
+    if(LV_FS_IF_TRACE_BUF_SIZE - ring_used < len) return false;
+
+    uint32_t i;
+    for(i = 0; i < len; i++) {
+        ring[ring_head] = i < TRACE_REC_SIZE ? rec[i] : (uint8_t)path[i - TRACE_REC_SIZE];
+        ring_head = (ring_head + 1) % LV_FS_IF_TRACE_BUF_SIZE;
+    }
+    ring_used += len;
+    return true;
+}
+
+/**
+ * Write the header with the current length of the events to the start of the file
+ * @return LV_FS_RES_OK or any error from lv_fs_res_t enum
+ */
+static lv_fs_res_t header_write(void)
+{
+    uint8_t hdr[TRACE_HEADER_SIZE];
+    memcpy(hdr, TRACE_MAGIC, 4);
+    put_u16(hdr + 4, TRACE_VERSION);
+    put_u16(hdr + 6, TRACE_REC_SIZE);
+    put_u32(hdr + 8, data_len);
+    put_u32(hdr + 12, lost_total);
+
+    lv_fs_res_t res = lv_fs_seek(&file, 0, LV_FS_SEEK_SET);
+    if(res != LV_FS_RES_OK) return res;
+
+    uint32_t bw = 0;
+    res = lv_fs_write(&file, hdr, TRACE_HEADER_SIZE, &bw);
+    if(res == LV_FS_RES_OK && bw != TRACE_HEADER_SIZE) res = LV_FS_RES_FULL;
+    return res;
+}
+
+#if LV_FS_IF_TRACE_FLUSH_PERIOD
+static void flush_timer_cb(lv_timer_t * t)
+{
+    if(!file_opened) {
+        lv_timer_del(t);
+        return;
+    }
+
+    lv_fs_if_trace_flush();
+}
+#endif
+
+static void put_u16(uint8_t * p, uint16_t v)
+{
+    p[0] = v & 0xFF;
+    p[1] = v >> 8;
+}
+
+static void put_u32(uint8_t * p, uint32_t v)
+{
+    put_u16(p, v & 0xFFFF);
+    put_u16(p + 2, v >> 16);
+}
+
+#endif /*LV_USE_FS_IF && LV_FS_IF_TRACE*/
@@ -12,12 +12,17 @@
 #if LV_FS_IF_PC != '\0'
 
 #include <stdio.h>
+#include <string.h>
 #include <errno.h>
 #include <dirent.h>
 #include <unistd.h>
+#include <sys/stat.h>
 #ifdef WIN32
 #include <windows.h>
 #endif
+#if (LV_FS_PC_FILE_CACHE_SIZE && LV_FS_IF_ASYNC) || (LV_FS_PC_HANDLE_MAX && (LV_FS_IF_ASYNC || LV_FS_IF_PREFETCH))
+#include <pthread.h>
+#endif
 
 /*********************
  *      DEFINES
@@ -30,9 +35,70 @@
 # endif
 #endif /*LV_FS_PATH*/
 
+/*Size of the stdio buffer of the files opened for writing. Small writes are collected in it
+ *and written with one system call. 0: use the default of the C library (usually BUFSIZ)*/
+#ifndef LV_FS_PC_WRITE_BUF
+# define LV_FS_PC_WRITE_BUF         0
+#endif
+
+/*Size of the stdio buffer of the files advised as SEQUENTIAL with `lv_fs_if_advise()`*/
+#ifndef LV_FS_PC_SEQ_BUF
+# define LV_FS_PC_SEQ_BUF           (64 * 1024U)
+#endif
+
+/*Size of the stdio buffer of the files advised as RANDOM. 0: unbuffered*/
+#ifndef LV_FS_PC_RANDOM_BUF
+# define LV_FS_PC_RANDOM_BUF        0
+#endif
+
+/*Number of read-only files kept open after closing them to make reopening cheap. 0: disable*/
+#ifndef LV_FS_PC_FILE_CACHE_SIZE
+# define LV_FS_PC_FILE_CACHE_SIZE   0
+#endif
+
+/*Max. number of streams open at once for the files not served from the file cache.
+ *Any number of files can be opened: the idle ones are closed (LRU) and reopened transparently
+ *on the next access. 0: disable*/
+#ifndef LV_FS_PC_HANDLE_MAX
+# define LV_FS_PC_HANDLE_MAX        0
+#endif
+
 /**********************
  *      TYPEDEFS
  **********************/
+/*A file opened with fopen(). Shared by all handles of the same file if it's in the file cache*/
+typedef struct {
+	FILE * fp;
+	uint32_t fp_pos;	/*Position of the stream*/
+	uint8_t writing;	/*1: the last operation was a write, 0: it was a read or seek*/
+	uint8_t used;		/*1: the stream was used or its buffer was set so setvbuf() can't be called*/
+	void * vbuf;		/*Buffer given to setvbuf() or NULL. Freed after closing the stream.*/
+#if LV_FS_PC_FILE_CACHE_SIZE
+	char * path;		/*Path of a cached file or NULL if the entry is free*/
+	uint32_t ref_cnt;	/*Number of handles using the file*/
+	uint32_t last_use;	/*For LRU eviction*/
+	ino_t ino;			/*Inode, size and modification time when opened to notice if the file changed*/
+	off_t fsize;
+	time_t mtime;
+	uint8_t stale;		/*1: the file changed since, close it when released and don't give it out again*/
+#if LV_FS_IF_ASYNC
+	pthread_mutex_t lock;	/*Serializes the handles sharing the stream, they can be read by the workers in parallel*/
+#endif
+#endif
+} pc_fd_t;
+
+typedef struct {
+	pc_fd_t * f;		/*Either `own` or an entry of the file cache*/
+	pc_fd_t own;
+	uint32_t pos;		/*Logical read/write position*/
+#if LV_FS_PC_HANDLE_MAX
+	char * path;		/*Path to reopen `own` after it was closed to free its slot*/
+	const char * flags;	/*Mode to reopen `own`*/
+	uint8_t wr;			/*1: opened for writing*/
+	uint32_t last_use;	/*For LRU eviction of `own`*/
+	uint32_t busy;		/*Number of calls in progress. `own` isn't closed for an other file while it's not 0.*/
+#endif
+} pc_file_t;
 
 /**********************
  *  STATIC PROTOTYPES
@@ -43,17 +109,81 @@ static lv_fs_res_t fs_read (lv_fs_drv_t * drv, void * file_p, void * buf, uint32
 static lv_fs_res_t fs_write(lv_fs_drv_t * drv, void * file_p, const void * buf, uint32_t btw, uint32_t * bw);
 static lv_fs_res_t fs_seek (lv_fs_drv_t * drv, void * file_p, uint32_t pos, lv_fs_whence_t whence);
 static lv_fs_res_t fs_tell (lv_fs_drv_t * drv, void * file_p, uint32_t * pos_p);
+static lv_fs_res_t fs_flush(lv_fs_drv_t * drv, void * file_p);
+static lv_fs_res_t fs_advise(lv_fs_drv_t * drv, void * file_p, uint32_t ofs, uint32_t len, lv_fs_if_advice_t advice);
+static lv_fs_res_t fs_readv(lv_fs_drv_t * drv, void * file_p, lv_fs_if_seg_t * segs, uint32_t cnt);
 static void * fs_dir_open (lv_fs_drv_t * drv, const char *path);
 static lv_fs_res_t fs_dir_read (lv_fs_drv_t * drv, void * dir_p, char *fn);
 static lv_fs_res_t fs_dir_close (lv_fs_drv_t * drv, void * dir_p);
+static lv_fs_res_t own_open(pc_file_t * fp, const char * path, const char * flags, uint8_t wr);
+#if LV_FS_PC_HANDLE_MAX
+static lv_fs_res_t fd_get(pc_file_t * fp);
+static void fd_pin(pc_file_t * fp);
+static void fd_put(pc_file_t * fp);
+static int32_t fd_find_slot(void);
+static void fd_release(pc_file_t * fp);
+#endif
+static lv_fs_res_t fd_sync_pos(pc_fd_t * f, uint32_t pos);
+static lv_fs_res_t fd_set_dir(pc_fd_t * f, uint8_t writing);
+static lv_fs_res_t fd_set_vbuf(pc_fd_t * f, uint32_t size);
+#if LV_FS_PC_FILE_CACHE_SIZE
+static lv_fs_res_t fd_cache_get(const char * path, pc_fd_t ** f);
+static void fd_cache_release(pc_fd_t * f);
+static void fd_cache_drop(const char * path);
+static void fd_cache_evict(pc_fd_t * e);
+#endif
 
 /**********************
  *  STATIC VARIABLES
  **********************/
+LV_FS_IF_POOL_DEF(file_pool, pc_file_t, LV_FS_IF_FILE_POOL_SIZE);
+#if LV_FS_PC_FILE_CACHE_SIZE
+static pc_fd_t fd_cache[LV_FS_PC_FILE_CACHE_SIZE];
+static uint32_t fd_cache_tick;
+#endif
+#if LV_FS_PC_HANDLE_MAX
+static pc_file_t * fd_owners[LV_FS_PC_HANDLE_MAX];	/*The files whose `own` is open*/
+static uint32_t fd_tick;
+#if LV_FS_IF_ASYNC || LV_FS_IF_PREFETCH
+/*The worker and prefetch threads reopen files too*/
+static pthread_mutex_t slot_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t slot_cond = PTHREAD_COND_INITIALIZER;		/*Signaled when a file gets idle*/
+#endif
+#endif
 
 /**********************
  *      MACROS
  **********************/
+/*Reopen the stream of a file if it was closed to free its slot and keep it open until `FD_PUT`.
+ *`FD_PIN` only keeps it as it is (open or closed).*/
+#if LV_FS_PC_HANDLE_MAX
+# define FD_GET(fp)		fd_get(fp)
+# define FD_PIN(fp)		fd_pin(fp)
+# define FD_PUT(fp)		fd_put(fp)
+#else
+# define FD_GET(fp)		LV_FS_RES_OK
+# define FD_PIN(fp)
+# define FD_PUT(fp)
+#endif
+
+#if LV_FS_PC_HANDLE_MAX && (LV_FS_IF_ASYNC || LV_FS_IF_PREFETCH)
+# define SLOT_LOCK()		pthread_mutex_lock(&slot_lock)
+# define SLOT_UNLOCK()		pthread_mutex_unlock(&slot_lock)
+# define SLOT_SIGNAL()		pthread_cond_broadcast(&slot_cond)
+#else
+# define SLOT_LOCK()
+# define SLOT_UNLOCK()
+# define SLOT_SIGNAL()
+#endif
+
+/*Lock the stream of a file while it's moved and used if it's shared with other handles*/
+#if LV_FS_PC_FILE_CACHE_SIZE && LV_FS_IF_ASYNC
+# define FD_LOCK(fp)		do { if((fp)->f != &(fp)->own) pthread_mutex_lock(&(fp)->f->lock); } while(0)
+# define FD_UNLOCK(fp)		do { if((fp)->f != &(fp)->own) pthread_mutex_unlock(&(fp)->f->lock); } while(0)
+#else
+# define FD_LOCK(fp)
+# define FD_UNLOCK(fp)
+#endif
 
 /**********************
  *   GLOBAL FUNCTIONS
@@ -87,12 +217,65 @@ void lv_fs_if_pc_init(void)
 
 	lv_fs_drv_register(&fs_drv);
 
+	LV_FS_IF_POOL_INIT(file_pool, LV_FS_IF_FILE_POOL_SIZE);
+
+#if LV_FS_PC_FILE_CACHE_SIZE && LV_FS_IF_ASYNC
+	uint32_t i;
+	for(i = 0; i < LV_FS_PC_FILE_CACHE_SIZE; i++) pthread_mutex_init(&fd_cache[i].lock, NULL);
+#endif
+
+	static lv_fs_if_ext_t fs_ext;
+	fs_ext.flush_cb = fs_flush;
+	fs_ext.advise_cb = fs_advise;
+	fs_ext.readv_cb = fs_readv;
+	fs_ext.file_pool = &file_pool;
+	fs_ext.thread_safe = true;
+	lv_fs_if_set_ext(&fs_drv, &fs_ext);
+
 	char cur_path[512];
 	getcwd(cur_path, sizeof(cur_path));
 	LV_LOG_USER("LV_FS_PC is initialized with.");
 	LV_LOG_USER("The following path is considered as root directory:\n%s", cur_path);
 }
 
+#if LV_FS_IF_DIRECT
+/**
+ * Read from a file without `lv_fs_read()`. Used by `lv_fs_if_direct_read()`.
+ * @param file_p the `file_d` of a file opened on this driver
+ * @param buf pointer to a memory block where to store the read data
+ * @param btr number of Bytes To Read
+ * @param br the real number of read bytes (Byte Read)
+ * @return LV_FS_RES_OK or any error from lv_fs_res_t enum
+ */
+lv_fs_res_t lv_fs_if_pc_read(void * file_p, void * buf, uint32_t btr, uint32_t * br)
+{
+	return fs_read(NULL, file_p, buf, btr, br);
+}
+
+/**
+ * Set the read write pointer without `lv_fs_seek()`. Used by `lv_fs_if_direct_seek()`.
+ * @param file_p the `file_d` of a file opened on this driver
+ * @param pos the new position of read write pointer
+ * @param whence LV_FS_SEEK_SET, LV_FS_SEEK_CUR or LV_FS_SEEK_END
+ * @return LV_FS_RES_OK or any error from lv_fs_res_t enum
+ */
+lv_fs_res_t lv_fs_if_pc_seek(void * file_p, uint32_t pos, lv_fs_whence_t whence)
+{
+	return fs_seek(NULL, file_p, pos, whence);
+}
+
+/**
+ * Give the position of the read write pointer without `lv_fs_tell()`. Used by `lv_fs_if_direct_tell()`.
+ * @param file_p the `file_d` of a file opened on this driver
+ * @param pos_p pointer to to store the result
+ * @return LV_FS_RES_OK or any error from lv_fs_res_t enum
+ */
+lv_fs_res_t lv_fs_if_pc_tell(void * file_p, uint32_t * pos_p)
+{
+	return fs_tell(NULL, file_p, pos_p);
+}
+#endif
+
 /**********************
  *   STATIC FUNCTIONS
  **********************/
@@ -126,13 +309,47 @@ static void * fs_open (lv_fs_drv_t * drv, const char * path, lv_fs_mode_t mode)
 	sprintf(buf, LV_FS_PC_PATH "%s", path);
 #endif
 
-	FILE * f = fopen(buf, flags);
-	if(f == NULL) return NULL;
+	pc_file_t * fp = lv_fs_if_pool_alloc(&file_pool);
+	if(fp == NULL) return NULL;
+
+	lv_fs_res_t res = LV_FS_RES_OK;
+	fp->f = NULL;
+#if LV_FS_PC_FILE_CACHE_SIZE
+	if(mode == LV_FS_MODE_RD) res = fd_cache_get(buf, &fp->f);
+	else fd_cache_drop(buf);
+#endif
+
+	/*Open the file only for this handle if it's not cached*/
+	if(res == LV_FS_RES_OK && fp->f == NULL) {
+		fp->f = &fp->own;
+#if LV_FS_PC_HANDLE_MAX
+		fp->own.fp = NULL;
+		fp->flags = flags;
+		fp->wr = (mode & LV_FS_MODE_WR) ? 1 : 0;
+		fp->busy = 0;
+		fp->path = lv_mem_alloc(strlen(buf) + 1);
+		if(fp->path == NULL) {
+			lv_fs_if_pool_free(&file_pool, fp);
+			return NULL;
+		}
+		strcpy(fp->path, buf);
+
+		res = fd_get(fp);
+		fp->flags = fp->wr ? "rb+" : "rb";		/*Don't truncate it again when it's reopened*/
+		if(res == LV_FS_RES_OK) fd_put(fp);
+		else lv_mem_free(fp->path);
+#else
+		res = own_open(fp, buf, flags, mode & LV_FS_MODE_WR);
+#endif
+	}
 
-	/*Be sure we are the beginning of the file*/
-	fseek(f, 0, SEEK_SET);
+	if(res != LV_FS_RES_OK) {
+		lv_fs_if_pool_free(&file_pool, fp);
+		return NULL;
+	}
 
-	return f;
+	fp->pos = 0;
+	return fp;
 }
 
 
@@ -146,7 +363,25 @@ static void * fs_open (lv_fs_drv_t * drv, const char * path, lv_fs_mode_t mode)
 static lv_fs_res_t fs_close (lv_fs_drv_t * drv, void * file_p)
 {
 	(void) drv;		/*Unused*/
-	fclose(file_p);
+	pc_file_t * fp = file_p;
+#if LV_FS_PC_HANDLE_MAX
+	if(fp->f == &fp->own) {
+		SLOT_LOCK();
+		fd_release(fp);
+		SLOT_SIGNAL();
+		SLOT_UNLOCK();
+		lv_mem_free(fp->path);
+	}
+#else
+	if(fp->f == &fp->own) {
+		fclose(fp->own.fp);
+		if(fp->own.vbuf) lv_mem_free(fp->own.vbuf);
+	}
+#endif
+#if LV_FS_PC_FILE_CACHE_SIZE
+	else fd_cache_release(fp->f);
+#endif
+	lv_fs_if_pool_free(&file_pool, fp);
 	return LV_FS_RES_OK;
 }
 
@@ -163,8 +398,21 @@ static lv_fs_res_t fs_close (lv_fs_drv_t * drv, void * file_p)
 static lv_fs_res_t fs_read (lv_fs_drv_t * drv, void * file_p, void * buf, uint32_t btr, uint32_t * br)
 {
 	(void) drv;		/*Unused*/
-	*br = fread(buf, 1, btr, file_p);
-	return LV_FS_RES_OK;
+	pc_file_t * fp = file_p;
+	*br = 0;
+	if(FD_GET(fp) != LV_FS_RES_OK) return LV_FS_RES_UNKNOWN;
+
+	lv_fs_res_t res = LV_FS_RES_UNKNOWN;
+	FD_LOCK(fp);
+	if(fd_set_dir(fp->f, 0) == LV_FS_RES_OK && fd_sync_pos(fp->f, fp->pos) == LV_FS_RES_OK) {
+		*br = fread(buf, 1, btr, fp->f->fp);
+		fp->f->fp_pos += *br;
+		fp->pos += *br;
+		res = LV_FS_RES_OK;
+	}
+	FD_UNLOCK(fp);
+	FD_PUT(fp);
+	return res;
 }
 
 /**
@@ -179,8 +427,19 @@ static lv_fs_res_t fs_read (lv_fs_drv_t * drv, void * file_p, void * buf, uint32
 static lv_fs_res_t fs_write(lv_fs_drv_t * drv, void * file_p, const void * buf, uint32_t btw, uint32_t * bw)
 {
 	(void) drv;		/*Unused*/
-	*bw = fwrite(buf, 1, btw, file_p);
-	return LV_FS_RES_OK;
+	pc_file_t * fp = file_p;
+	*bw = 0;
+	if(FD_GET(fp) != LV_FS_RES_OK) return LV_FS_RES_UNKNOWN;
+
+	lv_fs_res_t res = LV_FS_RES_UNKNOWN;
+	if(fd_set_dir(fp->f, 1) == LV_FS_RES_OK && fd_sync_pos(fp->f, fp->pos) == LV_FS_RES_OK) {
+		*bw = fwrite(buf, 1, btw, fp->f->fp);
+		fp->f->fp_pos += *bw;
+		fp->pos += *bw;
+		res = LV_FS_RES_OK;
+	}
+	FD_PUT(fp);
+	return res;
 }
 
 /**
@@ -194,7 +453,35 @@ static lv_fs_res_t fs_write(lv_fs_drv_t * drv, void * file_p, const void * buf,
 static lv_fs_res_t fs_seek (lv_fs_drv_t * drv, void * file_p, uint32_t pos, lv_fs_whence_t whence)
 {
 	(void) drv;		/*Unused*/
-	fseek(file_p, pos, whence);
+	pc_file_t * fp = file_p;
+	switch(whence) {
+	case LV_FS_SEEK_SET:
+		fp->pos = pos;
+		break;
+	case LV_FS_SEEK_CUR:
+		fp->pos += pos;
+		break;
+	case LV_FS_SEEK_END: {
+		if(FD_GET(fp) != LV_FS_RES_OK) return LV_FS_RES_UNKNOWN;
+		lv_fs_res_t res = LV_FS_RES_OK;
+		FD_LOCK(fp);
+		fp->f->used = 1;
+		if(fseek(fp->f->fp, pos, SEEK_END) == 0) {
+			fp->f->fp_pos = ftell(fp->f->fp);
+			fp->f->writing = 0;
+			fp->pos = fp->f->fp_pos;
+		}
+		else {
+			res = LV_FS_RES_UNKNOWN;
+		}
+		FD_UNLOCK(fp);
+		FD_PUT(fp);
+		if(res != LV_FS_RES_OK) return res;
+		break;
+	}
+	default:
+		return LV_FS_RES_INV_PARAM;
+	}
 	return LV_FS_RES_OK;
 }
 
@@ -209,10 +496,399 @@ static lv_fs_res_t fs_seek (lv_fs_drv_t * drv, void * file_p, uint32_t pos, lv_f
 static lv_fs_res_t fs_tell (lv_fs_drv_t * drv, void * file_p, uint32_t * pos_p)
 {
 	(void) drv;		/*Unused*/
-	*pos_p = ftell(file_p);
+	pc_file_t * fp = file_p;
+	*pos_p = fp->pos;
+	return LV_FS_RES_OK;
+}
+
+/**
+ * Write the buffered data of a file to the OS with `fflush`
+ * @param drv pointer to a driver where this function belongs
+ * @param file_p pointer to a file_t variable
+ * @return LV_FS_RES_OK or any error from lv_fs_res_t enum
+ */
+static lv_fs_res_t fs_flush(lv_fs_drv_t * drv, void * file_p)
+{
+	(void) drv;		/*Unused*/
+	pc_file_t * fp = file_p;
+
+	/*Keep the stream from being closed by an other thread meanwhile*/
+	FD_PIN(fp);
+	lv_fs_res_t res = LV_FS_RES_OK;
+	if(fp->f->fp && fp->f->writing) {		/*If it's closed to free its slot it's flushed already*/
+		if(fflush(fp->f->fp) == 0) fp->f->writing = 0;
+		else res = LV_FS_RES_UNKNOWN;
+	}
+	FD_PUT(fp);
+	return res;
+}
+
+/**
+ * Size the stdio buffer of a file for SEQUENTIAL or RANDOM reads. The other advices are ignored.
+ * The C library allows it only before the stream is used, so advise right after opening.
+ * @param drv pointer to a driver where this function belongs
+ * @param file_p pointer to a file_t variable
+ * @param ofs unused, the buffer is used for the whole file
+ * @param len unused
+ * @param advice how the file will be read
+ * @return LV_FS_RES_OK, LV_FS_RES_DENIED if the stream was already used or any error from lv_fs_res_t enum
+ */
+static lv_fs_res_t fs_advise(lv_fs_drv_t * drv, void * file_p, uint32_t ofs, uint32_t len, lv_fs_if_advice_t advice)
+{
+	(void) drv;		/*Unused*/
+	(void) ofs;		/*Unused*/
+	(void) len;		/*Unused*/
+	pc_file_t * fp = file_p;
+	if(advice != LV_FS_IF_ADVICE_SEQUENTIAL && advice != LV_FS_IF_ADVICE_RANDOM) return LV_FS_RES_OK;
+	if(FD_GET(fp) != LV_FS_RES_OK) return LV_FS_RES_UNKNOWN;
+
+	FD_LOCK(fp);
+	lv_fs_res_t res = fd_set_vbuf(fp->f, advice == LV_FS_IF_ADVICE_SEQUENTIAL ? LV_FS_PC_SEQ_BUF : LV_FS_PC_RANDOM_BUF);
+	FD_UNLOCK(fp);
+	FD_PUT(fp);
+	return res;
+}
+
+/**
+ * Read several parts of a file without changing its position.
+ * The stream is moved only if a segment doesn't continue the previous one.
+ * @param drv pointer to a driver where this function belongs
+ * @param file_p pointer to a file_t variable
+ * @param segs the segments sorted by offset
+ * @param cnt number of segments
+ * @return LV_FS_RES_OK or any error from lv_fs_res_t enum
+ */
+static lv_fs_res_t fs_readv(lv_fs_drv_t * drv, void * file_p, lv_fs_if_seg_t * segs, uint32_t cnt)
+{
+	(void) drv;		/*Unused*/
+	pc_file_t * fp = file_p;
+	if(FD_GET(fp) != LV_FS_RES_OK) return LV_FS_RES_UNKNOWN;
+
+	lv_fs_res_t res = LV_FS_RES_OK;
+	FD_LOCK(fp);
+	if(fd_set_dir(fp->f, 0) != LV_FS_RES_OK) res = LV_FS_RES_UNKNOWN;
+
+	uint32_t i;
+	for(i = 0; i < cnt && res == LV_FS_RES_OK; i++) {
+		if(fd_sync_pos(fp->f, segs[i].ofs) != LV_FS_RES_OK) {
+			res = LV_FS_RES_UNKNOWN;
+			break;
+		}
+		segs[i].br = fread(segs[i].buf, 1, segs[i].len, fp->f->fp);
+		fp->f->fp_pos += segs[i].br;
+	}
+	FD_UNLOCK(fp);
+	FD_PUT(fp);
+
+	return res;
+}
+
+/**
+ * Open the own stream of a file
+ * @param fp pointer to a pc_file_t
+ * @param path the real path of the file
+ * @param flags mode for fopen()
+ * @param wr 1: the file is opened for writing
+ * @return LV_FS_RES_OK or any error from lv_fs_res_t enum
+ */
+static lv_fs_res_t own_open(pc_file_t * fp, const char * path, const char * flags, uint8_t wr)
+{
+	fp->own.fp = fopen(path, flags);
+	fp->own.fp_pos = 0;
+	fp->own.writing = 0;
+	fp->own.used = 0;
+	fp->own.vbuf = NULL;
+	if(fp->own.fp == NULL) return LV_FS_RES_NOT_EX;
+#if LV_FS_PC_WRITE_BUF
+	/*Give the buffer explicitly, as some C libraries (e.g. glibc) ignore the size if the buffer is NULL.
+	 *If it fails the default buffer of the C library is used.*/
+	if(wr) fd_set_vbuf(&fp->own, LV_FS_PC_WRITE_BUF);
+#else
+	(void) wr;		/*Unused*/
+#endif
+	return LV_FS_RES_OK;
+}
+
+#if LV_FS_PC_HANDLE_MAX
+/**
+ * Make sure the stream of a file is open and keep it open until `fd_put()`.
+ * If it was closed it's reopened, closing the least recently used idle file
+ * if `LV_FS_PC_HANDLE_MAX` files are open.
+ * @param fp pointer to a pc_file_t
+ * @return LV_FS_RES_OK or any error from lv_fs_res_t enum
+ */
+static lv_fs_res_t fd_get(pc_file_t * fp)
+{
+	if(fp->f != &fp->own) return LV_FS_RES_OK;		/*The files of the file cache have no slot*/
+
+	SLOT_LOCK();
+	fp->last_use = ++fd_tick;
+	fp->busy++;
+
+	lv_fs_res_t res = LV_FS_RES_OK;
+	if(fp->own.fp == NULL) {
+		int32_t slot = fd_find_slot();
+#if LV_FS_IF_ASYNC || LV_FS_IF_PREFETCH
+		/*All the open files are used by other threads, wait until one is done*/
+		while(slot < 0) {
+			pthread_cond_wait(&slot_cond, &slot_lock);
+			slot = fd_find_slot();
+		}
+#endif
+		if(slot < 0) {
+			res = LV_FS_RES_BUSY;
+		}
+		else {
+			if(fd_owners[slot]) fd_release(fd_owners[slot]);
+			res = own_open(fp, fp->path, fp->flags, fp->wr);
+			if(res == LV_FS_RES_OK) fd_owners[slot] = fp;
+		}
+	}
+
+	if(res != LV_FS_RES_OK) fp->busy--;
+	SLOT_UNLOCK();
+	return res;
+}
+
+/**
+ * Keep the stream of a file open or closed as it is until `fd_put()`
+ * @param fp pointer to a pc_file_t
+ */
+static void fd_pin(pc_file_t * fp)
+{
+	if(fp->f != &fp->own) return;
+
+	SLOT_LOCK();
+	fp->last_use = ++fd_tick;
+	fp->busy++;
+	SLOT_UNLOCK();
+}
+
+/**
+ * Release a file kept by `fd_get()` or `fd_pin()`. Its stream can be closed for other files again.
+ * @param fp pointer to a pc_file_t
+ */
+static void fd_put(pc_file_t * fp)
+{
+	if(fp->f != &fp->own) return;
+
+	SLOT_LOCK();
+	fp->busy--;
+	if(fp->busy == 0) {
+		SLOT_SIGNAL();		/*Its slot can be taken by a waiting thread now*/
+	}
+	SLOT_UNLOCK();
+}
+
+/**
+ * Find a slot for a file to open. Called with the slots locked.
+ * @return index of a free slot or the slot of the least recently used idle file, -1 if all files are busy
+ */
+static int32_t fd_find_slot(void)
+{
+	int32_t slot = -1;
+	uint32_t i;
+	for(i = 0; i < LV_FS_PC_HANDLE_MAX; i++) {
+		if(fd_owners[i] == NULL) return i;
+		if(fd_owners[i]->busy) continue;
+		if(slot < 0 || fd_owners[i]->last_use < fd_owners[slot]->last_use) slot = i;
+	}
+	return slot;
+}
+
+/**
+ * Close the stream of a file to free its slot. `fclose()` flushes the buffered writes.
+ * The buffer set by an advice is dropped too. Called with the slots locked.
+ * @param fp pointer to a pc_file_t
+ */
+static void fd_release(pc_file_t * fp)
+{
+	uint32_t i;
+	for(i = 0; i < LV_FS_PC_HANDLE_MAX; i++) {
+		if(fd_owners[i] == fp) fd_owners[i] = NULL;
+	}
+
+	if(fp->own.fp == NULL) return;
+	fclose(fp->own.fp);
+	if(fp->own.vbuf) lv_mem_free(fp->own.vbuf);
+	fp->own.fp = NULL;
+}
+#endif
+
+/**
+ * Prepare the stream of a file for reading or writing.
+ * The C library requires a flush or seek between writes and reads of the same stream,
+ * this is where the buffered writes become visible to the reads.
+ * @param f pointer to a pc_fd_t
+ * @param writing 1: prepare for writing, 0: for reading
+ * @return LV_FS_RES_OK or any error from lv_fs_res_t enum
+ */
+static lv_fs_res_t fd_set_dir(pc_fd_t * f, uint8_t writing)
+{
+	f->used = 1;
+	if(f->writing == writing) return LV_FS_RES_OK;
+
+	if(fseek(f->fp, f->fp_pos, SEEK_SET) != 0) return LV_FS_RES_UNKNOWN;
+	f->writing = writing;
 	return LV_FS_RES_OK;
 }
 
+/**
+ * Give a buffer of a given size to the stream of a file. It's freed when the stream is closed.
+ * The C library allows it only once, before the stream is used.
+ * @param f pointer to a pc_fd_t
+ * @param size size of the buffer. 0: make the stream unbuffered
+ * @return LV_FS_RES_OK, LV_FS_RES_DENIED if the stream was already used or any error from lv_fs_res_t enum
+ */
+static lv_fs_res_t fd_set_vbuf(pc_fd_t * f, uint32_t size)
+{
+	if(f->used) return LV_FS_RES_DENIED;
+
+	void * buf = NULL;
+	if(size > 0) {
+		buf = lv_mem_alloc(size);
+		if(buf == NULL) return LV_FS_RES_OUT_OF_MEM;
+	}
+
+	if(setvbuf(f->fp, buf, buf ? _IOFBF : _IONBF, size) != 0) {
+		if(buf) lv_mem_free(buf);
+		return LV_FS_RES_UNKNOWN;
+	}
+
+	f->vbuf = buf;
+	f->used = 1;
+	return LV_FS_RES_OK;
+}
+
+/**
+ * Move the stream of a file to the position of a handle if they differ
+ * @param f pointer to a pc_fd_t
+ * @param pos the required position
+ * @return LV_FS_RES_OK or any error from lv_fs_res_t enum
+ */
+static lv_fs_res_t fd_sync_pos(pc_fd_t * f, uint32_t pos)
+{
+	if(f->fp_pos == pos) return LV_FS_RES_OK;
+
+	if(fseek(f->fp, pos, SEEK_SET) != 0) return LV_FS_RES_UNKNOWN;
+	f->fp_pos = pos;
+	return LV_FS_RES_OK;
+}
+
+#if LV_FS_PC_FILE_CACHE_SIZE
+/**
+ * Get a read-only file from the file cache or open and add it to the cache.
+ * A cached file is reopened if it was replaced or modified since it was opened.
+ * The least recently used, not referenced file is closed if the cache is full.
+ * @param path the real path of the file
+ * @param f pointer to store the cached file. NULL if all entries are in use.
+ * @return LV_FS_RES_OK or any error from lv_fs_res_t enum
+ */
+static lv_fs_res_t fd_cache_get(const char * path, pc_fd_t ** f)
+{
+	fd_cache_tick++;
+	*f = NULL;
+
+	pc_fd_t * slot = NULL;
+	uint32_t i;
+	for(i = 0; i < LV_FS_PC_FILE_CACHE_SIZE; i++) {
+		pc_fd_t * e = &fd_cache[i];
+		if(e->path && !e->stale && strcmp(e->path, path) == 0) {
+			struct stat st;
+			if(stat(path, &st) == 0 && st.st_ino == e->ino && st.st_size == e->fsize && st.st_mtime == e->mtime) {
+				e->ref_cnt++;
+				e->last_use = fd_cache_tick;
+				*f = e;
+				return LV_FS_RES_OK;
+			}
+
+			/*Changed: the open handles keep reading the old stream*/
+			if(e->ref_cnt) e->stale = 1;
+			else fd_cache_evict(e);
+		}
+
+		/*Prefer a free entry, else the least recently used unreferenced one*/
+		if(e->path == NULL) {
+			if(slot == NULL || slot->path) slot = e;
+		}
+		else if(e->ref_cnt == 0 && (slot == NULL || (slot->path && e->last_use < slot->last_use))) {
+			slot = e;
+		}
+	}
+
+	if(slot == NULL) return LV_FS_RES_OK;
+
+	char * path_copy = lv_mem_alloc(strlen(path) + 1);
+	if(path_copy == NULL) return LV_FS_RES_OK;
+	strcpy(path_copy, path);
+
+	if(slot->path) fd_cache_evict(slot);
+
+	slot->fp = fopen(path, "rb");
+	if(slot->fp == NULL) {
+		lv_mem_free(path_copy);
+		return LV_FS_RES_NOT_EX;
+	}
+
+	struct stat st;
+	if(fstat(fileno(slot->fp), &st) == 0) {
+		slot->ino = st.st_ino;
+		slot->fsize = st.st_size;
+		slot->mtime = st.st_mtime;
+	}
+
+	slot->fp_pos = 0;
+	slot->writing = 0;
+	slot->used = 0;
+	slot->vbuf = NULL;
+	slot->path = path_copy;
+	slot->ref_cnt = 1;
+	slot->last_use = fd_cache_tick;
+	*f = slot;
+	return LV_FS_RES_OK;
+}
+
+/**
+ * Release a file got from `fd_cache_get`. It's kept open until evicted.
+ * @param f pointer to a cached file
+ */
+static void fd_cache_release(pc_fd_t * f)
+{
+	f->ref_cnt--;
+	if(f->ref_cnt == 0 && f->stale) fd_cache_evict(f);
+}
+
+/**
+ * Remove a file from the file cache because it's opened for writing.
+ * If it's in use it's closed when the last handle releases it.
+ * @param path the real path of the file
+ */
+static void fd_cache_drop(const char * path)
+{
+	uint32_t i;
+	for(i = 0; i < LV_FS_PC_FILE_CACHE_SIZE; i++) {
+		pc_fd_t * e = &fd_cache[i];
+		if(e->path == NULL || e->stale || strcmp(e->path, path) != 0) continue;
+
+		if(e->ref_cnt) e->stale = 1;
+		else fd_cache_evict(e);
+	}
+}
+
+/**
+ * Close a cached file and free its entry
+ * @param e pointer to an entry of the file cache
+ */
+static void fd_cache_evict(pc_fd_t * e)
+{
+	fclose(e->fp);
+	if(e->vbuf) lv_mem_free(e->vbuf);
+	lv_mem_free(e->path);
+	e->path = NULL;
+	e->stale = 0;
+}
+#endif
+
 
 #ifdef WIN32
 static char next_fn[256];
@@ -16,8 +16,21 @@
 #include <dirent.h>
 #include <unistd.h>
 #include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#if LV_FS_POSIX_HANDLE_MAX && (LV_FS_IF_ASYNC || LV_FS_IF_PREFETCH)
+#include <pthread.h>
+#endif
 #ifdef WIN32
 #include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/uio.h>
+#endif
+
+#if defined(__linux__) && LV_FS_POSIX_IO_URING
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
 #endif
 
 /*********************
@@ -31,9 +44,129 @@
 # endif
 #endif /*LV_FS_PATH*/
 
+/*Map read-only files into the memory with mmap() so reads, seeks and tells need no system calls*/
+#ifndef LV_FS_POSIX_MMAP
+# define LV_FS_POSIX_MMAP   0
+#endif
+
+#ifdef WIN32
+# undef LV_FS_POSIX_MMAP
+# define LV_FS_POSIX_MMAP   0   /*mmap() is not available on Windows*/
+#endif
+
+/*Max. size of the per file read-ahead buffer in bytes. 0: disable read-ahead*/
+#ifndef LV_FS_POSIX_READ_AHEAD
+# define LV_FS_POSIX_READ_AHEAD     0
+#endif
+
+/*Initial read-ahead window. It's doubled on sequential reads up to LV_FS_POSIX_READ_AHEAD
+ *and reset on random access*/
+#ifndef LV_FS_POSIX_READ_AHEAD_MIN
+# define LV_FS_POSIX_READ_AHEAD_MIN 512
+#endif
+
+/*Size of the per file write-back buffer in bytes. Consecutive small writes are collected and
+ *written with one system call. 0: disable*/
+#ifndef LV_FS_POSIX_WRITE_BUF
+# define LV_FS_POSIX_WRITE_BUF      0
+#endif
+
+/*Number of read-only files kept open (and mapped) after closing them to make reopening cheap. 0: disable*/
+#ifndef LV_FS_POSIX_FD_CACHE_SIZE
+# define LV_FS_POSIX_FD_CACHE_SIZE  0
+#endif
+
+/*Max. number of file descriptors open at once for the files not served from the fd cache.
+ *Any number of files can be opened: the idle ones are closed (LRU) and reopened transparently
+ *on the next access. 0: disable*/
+#ifndef LV_FS_POSIX_HANDLE_MAX
+# define LV_FS_POSIX_HANDLE_MAX     0
+#endif
+
+/*Submit the segments of `lv_fs_if_readv()` through io_uring with one system call (Linux only).
+ *If io_uring is not available at runtime preadv() is used.*/
+#ifndef LV_FS_POSIX_IO_URING
+# define LV_FS_POSIX_IO_URING       0
+#endif
+
+#ifndef __linux__
+# undef LV_FS_POSIX_IO_URING
+# define LV_FS_POSIX_IO_URING       0
+#endif
+
+/*Number of entries in the submission queue of io_uring*/
+#ifndef LV_FS_POSIX_IO_URING_ENTRIES
+# define LV_FS_POSIX_IO_URING_ENTRIES   32
+#endif
+
+/*Max. number of segments merged into one preadv() call*/
+#ifndef LV_FS_POSIX_READV_IOV_MAX
+# define LV_FS_POSIX_READV_IOV_MAX  16
+#endif
+
 /**********************
  *      TYPEDEFS
  **********************/
+/*A file opened in the OS. Shared by all handles of the same file if it's in the fd cache*/
+typedef struct {
+    int fd;
+#ifdef WIN32
+    uint32_t fd_pos;    /*Position of the file offset in the OS. Not used with pread()/pwrite()*/
+#endif
+#if LV_FS_POSIX_MMAP
+    uint8_t * map;      /*Content of the file if it's mapped, else NULL*/
+    uint32_t size;      /*Size of the mapped file*/
+#endif
+#if LV_FS_POSIX_FD_CACHE_SIZE
+    char * path;        /*Path of a cached file or NULL if the entry is free*/
+    uint32_t ref_cnt;   /*Number of handles using the file*/
+    uint32_t last_use;  /*For LRU eviction*/
+    ino_t ino;          /*Inode, size and modification time when opened to notice if the file changed*/
+    off_t fsize;
+    time_t mtime;
+    uint8_t stale;      /*1: the file changed since, close it when released and don't give it out again*/
+#endif
+} posix_fd_t;
+
+typedef struct {
+    posix_fd_t * f;     /*Either `own` or an entry of the fd cache*/
+    posix_fd_t own;
+    uint32_t pos;       /*Logical read/write position*/
+#if LV_FS_POSIX_HANDLE_MAX
+    char * path;        /*Path to reopen `own` after it was closed to free its slot*/
+    int flags;          /*Flags to reopen `own`*/
+    uint32_t last_use;  /*For LRU eviction of `own`*/
+    uint32_t busy;      /*Number of calls in progress. `own` isn't closed for an other file while it's not 0.*/
+#endif
+#if LV_FS_POSIX_READ_AHEAD
+    uint32_t ra_start;  /*File position of the first byte in `ra_buf`*/
+    uint32_t ra_len;    /*Number of valid bytes in `ra_buf`*/
+    uint32_t ra_win;    /*Current read-ahead window*/
+    uint8_t ra_advice;  /*The last NORMAL, SEQUENTIAL or RANDOM advice*/
+    uint8_t ra_buf[LV_FS_POSIX_READ_AHEAD];     /*Read-ahead buffer*/
+#endif
+#if LV_FS_POSIX_WRITE_BUF
+    uint32_t wb_start;  /*File position of the first byte in `wb_buf`*/
+    uint32_t wb_len;    /*Number of bytes waiting in `wb_buf`*/
+    uint8_t wb_buf[LV_FS_POSIX_WRITE_BUF];      /*Write-back buffer*/
+#endif
+} posix_file_t;
+
+#if LV_FS_POSIX_IO_URING
+/*The rings shared with the kernel*/
+typedef struct {
+    int fd;                     /*-1: io_uring is not available*/
+    unsigned * sq_tail;
+    unsigned * sq_mask;
+    unsigned * sq_array;
+    struct io_uring_sqe * sqes;
+    unsigned * cq_head;
+    unsigned * cq_tail;
+    unsigned * cq_mask;
+    struct io_uring_cqe * cqes;
+    unsigned entries;
+} posix_uring_t;
+#endif
 
 /**********************
  *  STATIC PROTOTYPES
@@ -44,17 +177,100 @@ static lv_fs_res_t fs_read (lv_fs_drv_t * drv, void * file_p, void * buf, uint32
 static lv_fs_res_t fs_write(lv_fs_drv_t * drv, void * file_p, const void * buf, uint32_t btw, uint32_t * bw);
 static lv_fs_res_t fs_seek (lv_fs_drv_t * drv, void * file_p, uint32_t pos, lv_fs_whence_t whence);
 static lv_fs_res_t fs_tell (lv_fs_drv_t * drv, void * file_p, uint32_t * pos_p);
+static lv_fs_res_t fs_flush(lv_fs_drv_t * drv, void * file_p);
+static lv_fs_res_t fs_advise(lv_fs_drv_t * drv, void * file_p, uint32_t ofs, uint32_t len, lv_fs_if_advice_t advice);
+static lv_fs_res_t fs_readv(lv_fs_drv_t * drv, void * file_p, lv_fs_if_seg_t * segs, uint32_t cnt);
+#if LV_FS_POSIX_IO_URING
+static void uring_init(void);
+static lv_fs_res_t uring_readv(int fd, lv_fs_if_seg_t * segs, uint32_t cnt);
+#endif
 static void * fs_dir_open (lv_fs_drv_t * drv, const char *path);
 static lv_fs_res_t fs_dir_read (lv_fs_drv_t * drv, void * dir_p, char *fn);
+#ifndef WIN32
+static lv_fs_res_t fs_dir_read_batch(lv_fs_drv_t * drv, void * dir_p, lv_fs_if_dir_batch_t * batch);
+#endif
 static lv_fs_res_t fs_dir_close (lv_fs_drv_t * drv, void * dir_p);
+static lv_fs_res_t fd_open(posix_fd_t * f, const char * path, int flags);
+static void fd_close(posix_fd_t * f);
+static ssize_t fd_read_at(posix_fd_t * f, void * buf, uint32_t btr, uint32_t pos);
+static ssize_t fd_write_at(posix_fd_t * f, const void * buf, uint32_t btw, uint32_t pos);
+#if LV_FS_POSIX_FD_CACHE_SIZE
+static lv_fs_res_t fd_cache_get(const char * path, posix_fd_t ** f);
+static void fd_cache_release(posix_fd_t * f);
+static void fd_cache_drop(const char * path);
+static void fd_cache_evict(posix_fd_t * e);
+#endif
+#if LV_FS_POSIX_HANDLE_MAX
+static lv_fs_res_t fd_get(posix_file_t * fp);
+static void fd_pin(posix_file_t * fp);
+static void fd_put(posix_file_t * fp);
+static int32_t fd_find_slot(void);
+static void fd_release(posix_file_t * fp);
+#endif
+static lv_fs_res_t file_read(lv_fs_drv_t * drv, posix_file_t * fp, void * buf, uint32_t btr, uint32_t * br);
+static lv_fs_res_t file_write(posix_file_t * fp, const void * buf, uint32_t btw, uint32_t * bw);
+static lv_fs_res_t file_size(lv_fs_drv_t * drv, posix_file_t * fp, uint32_t * size);
+static lv_fs_res_t file_advise(posix_file_t * fp, uint32_t ofs, uint32_t len, lv_fs_if_advice_t advice);
+static lv_fs_res_t file_readv(lv_fs_drv_t * drv, posix_file_t * fp, lv_fs_if_seg_t * segs, uint32_t cnt);
+#if LV_FS_POSIX_READ_AHEAD
+static lv_fs_res_t read_ahead(posix_file_t * fp, uint8_t * buf, uint32_t btr, uint32_t * br);
+#endif
+#if LV_FS_POSIX_WRITE_BUF
+static lv_fs_res_t write_back(posix_file_t * fp, const uint8_t * buf, uint32_t btw, uint32_t * bw);
+static lv_fs_res_t write_back_flush(posix_file_t * fp);
+static lv_fs_res_t write_back_drain(posix_file_t * fp);
+#endif
+#ifndef WIN32
+static lv_fs_res_t fs_map(lv_fs_drv_t * drv, const char * path, const void ** ptr, uint32_t * size, void ** map_d);
+static void fs_unmap(lv_fs_drv_t * drv, const void * ptr, uint32_t size, void * map_d);
+static lv_fs_res_t fs_prefetch(lv_fs_drv_t * drv, const char * path, uint32_t ofs, uint32_t len);
+#endif
 
 /**********************
  *  STATIC VARIABLES
  **********************/
+LV_FS_IF_POOL_DEF(file_pool, posix_file_t, LV_FS_IF_FILE_POOL_SIZE);
+#if LV_FS_POSIX_FD_CACHE_SIZE
+static posix_fd_t fd_cache[LV_FS_POSIX_FD_CACHE_SIZE];
+static uint32_t fd_cache_tick;
+#endif
+#if LV_FS_POSIX_HANDLE_MAX
+static posix_file_t * fd_owners[LV_FS_POSIX_HANDLE_MAX];   /*The files whose `own` is open*/
+static uint32_t fd_tick;
+#if LV_FS_IF_ASYNC || LV_FS_IF_PREFETCH
+/*The worker and prefetch threads reopen files too*/
+static pthread_mutex_t slot_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t slot_cond = PTHREAD_COND_INITIALIZER;     /*Signaled when a file gets idle*/
+#endif
+#endif
+#if LV_FS_POSIX_IO_URING
+static posix_uring_t uring = {.fd = -1};
+#endif
 
 /**********************
  *      MACROS
  **********************/
+/*Reopen the file descriptor of a file if it was closed to free its slot and keep it open until `FD_PUT`.
+ *`FD_PIN` only keeps it as it is (open or closed).*/
+#if LV_FS_POSIX_HANDLE_MAX
+# define FD_GET(fp)     fd_get(fp)
+# define FD_PIN(fp)     fd_pin(fp)
+# define FD_PUT(fp)     fd_put(fp)
+#else
+# define FD_GET(fp)     LV_FS_RES_OK
+# define FD_PIN(fp)
+# define FD_PUT(fp)
+#endif
+
+#if LV_FS_POSIX_HANDLE_MAX && (LV_FS_IF_ASYNC || LV_FS_IF_PREFETCH)
+# define SLOT_LOCK()        pthread_mutex_lock(&slot_lock)
+# define SLOT_UNLOCK()      pthread_mutex_unlock(&slot_lock)
+# define SLOT_SIGNAL()      pthread_cond_broadcast(&slot_cond)
+#else
+# define SLOT_LOCK()
+# define SLOT_UNLOCK()
+# define SLOT_SIGNAL()
+#endif
 
 /**********************
  *   GLOBAL FUNCTIONS
@@ -87,8 +303,66 @@ void lv_fs_if_posix_init(void)
     fs_drv.dir_read_cb = fs_dir_read;
 
     lv_fs_drv_register(&fs_drv);
+
+    LV_FS_IF_POOL_INIT(file_pool, LV_FS_IF_FILE_POOL_SIZE);
+
+    static lv_fs_if_ext_t fs_ext;
+#ifndef WIN32
+    fs_ext.map_cb = fs_map;
+    fs_ext.unmap_cb = fs_unmap;
+    fs_ext.dir_read_batch_cb = fs_dir_read_batch;
+    fs_ext.prefetch_cb = fs_prefetch;
+#endif
+    fs_ext.flush_cb = fs_flush;
+    fs_ext.advise_cb = fs_advise;
+    fs_ext.readv_cb = fs_readv;
+    fs_ext.file_pool = &file_pool;
+    fs_ext.thread_safe = true;
+    lv_fs_if_set_ext(&fs_drv, &fs_ext);
+
+#if LV_FS_POSIX_IO_URING
+    uring_init();
+#endif
+}
+
+#if LV_FS_IF_DIRECT
+/**
+ * Read from a file without `lv_fs_read()`. Used by `lv_fs_if_direct_read()`.
+ * @param file_p the `file_d` of a file opened on this driver
+ * @param buf pointer to a memory block where to store the read data
+ * @param btr number of Bytes To Read
+ * @param br the real number of read bytes (Byte Read)
+ * @return LV_FS_RES_OK or any error from lv_fs_res_t enum
+ */
+lv_fs_res_t lv_fs_if_posix_read(void * file_p, void * buf, uint32_t btr, uint32_t * br)
+{
+    return fs_read(NULL, file_p, buf, btr, br);
+}
+
+/**
+ * Set the read write pointer without `lv_fs_seek()`. Used by `lv_fs_if_direct_seek()`.
+ * @param file_p the `file_d` of a file opened on this driver
+ * @param pos the new position of read write pointer
+ * @param whence LV_FS_SEEK_SET, LV_FS_SEEK_CUR or LV_FS_SEEK_END
+ * @return LV_FS_RES_OK or any error from lv_fs_res_t enum
+ */
+lv_fs_res_t lv_fs_if_posix_seek(void * file_p, uint32_t pos, lv_fs_whence_t whence)
+{
+    return fs_seek(NULL, file_p, pos, whence);
 }
 
+/**
+ * Give the position of the read write pointer without `lv_fs_tell()`. Used by `lv_fs_if_direct_tell()`.
+ * @param file_p the `file_d` of a file opened on this driver
+ * @param pos_p pointer to to store the result
+ * @return LV_FS_RES_OK or any error from lv_fs_res_t enum
+ */
+lv_fs_res_t lv_fs_if_posix_tell(void * file_p, uint32_t * pos_p)
+{
+    return fs_tell(NULL, file_p, pos_p);
+}
+#endif
+
 /**********************
  *   STATIC FUNCTIONS
  **********************/
@@ -106,25 +380,72 @@ static void * fs_open (lv_fs_drv_t * drv, const char * path, lv_fs_mode_t mode)
     (void) drv;     /*Unused*/
     errno = 0;
 
+    /*Writing creates a missing file like FA_OPEN_ALWAYS of the FATFS driver and "wb" of the PC driver.
+     *Existing files are not truncated, as with FATFS.*/
     uint32_t flags = 0;
-    if(mode == LV_FS_MODE_WR) flags = O_WRONLY;
+    if(mode == LV_FS_MODE_WR) flags = O_WRONLY | O_CREAT;
     else if(mode == LV_FS_MODE_RD) flags = O_RDONLY;
-    else if(mode == (LV_FS_MODE_WR | LV_FS_MODE_RD)) flags = O_RDWR;
+    else if(mode == (LV_FS_MODE_WR | LV_FS_MODE_RD)) flags = O_RDWR | O_CREAT;
 
     /*Make the path relative to the current directory (the projects root folder)*/
     char buf[256];
     sprintf(buf, LV_FS_POSIX_PATH "%s", path);
 
 
-    int f = open(buf, flags);
-    if(f < 0) return NULL;
+    posix_file_t * fp = lv_fs_if_pool_alloc(&file_pool);
+    if(fp == NULL) return NULL;
 
-    /*Be sure we are the beginning of the file*/
-    lseek(f, 0, SEEK_SET);
+    lv_fs_res_t res = LV_FS_RES_OK;
+    fp->f = NULL;
+#if LV_FS_POSIX_FD_CACHE_SIZE
+    if(mode == LV_FS_MODE_RD) res = fd_cache_get(buf, &fp->f);
+    else fd_cache_drop(buf);
+#endif
 
-    int * fp = lv_mem_alloc(sizeof(int));
-    if(fp == NULL) return NULL;
-    *fp = f;
+    /*Open the file only for this handle if it's not cached*/
+    if(res == LV_FS_RES_OK && fp->f == NULL) {
+#if LV_FS_POSIX_HANDLE_MAX
+        fp->f = &fp->own;
+        fp->own.fd = -1;
+        fp->flags = flags;
+        fp->busy = 0;
+        fp->path = lv_mem_alloc(strlen(buf) + 1);
+        if(fp->path) {
+            strcpy(fp->path, buf);
+            res = fd_get(fp);
+            if(res == LV_FS_RES_OK) fd_put(fp);
+            else lv_mem_free(fp->path);
+        }
+        else {
+            res = LV_FS_RES_OUT_OF_MEM;
+        }
+        /*Only the first open may create the file: if it's deleted while open, reopening it to
+         *get a free slot back fails instead of silently creating an empty file*/
+        fp->flags &= ~O_CREAT;
+#else
+        res = fd_open(&fp->own, buf, flags);
+        fp->f = &fp->own;
+#endif
+    }
+
+    if(res != LV_FS_RES_OK) {
+        lv_fs_if_pool_free(&file_pool, fp);
+        return NULL;
+    }
+
+    fp->pos = 0;
+
+#if LV_FS_POSIX_READ_AHEAD
+    fp->ra_start = 0;
+    fp->ra_len = 0;
+    fp->ra_win = LV_FS_POSIX_READ_AHEAD_MIN;
+    fp->ra_advice = LV_FS_IF_ADVICE_NORMAL;
+#endif
+
+#if LV_FS_POSIX_WRITE_BUF
+    fp->wb_start = 0;
+    fp->wb_len = 0;
+#endif
 
     return fp;
 }
@@ -140,10 +461,24 @@ static void * fs_open (lv_fs_drv_t * drv, const char * path, lv_fs_mode_t mode)
 static lv_fs_res_t fs_close (lv_fs_drv_t * drv, void * file_p)
 {
     (void) drv;     /*Unused*/
-    int * fp = file_p;
-    close(*fp);
-    lv_mem_free(file_p);
-    return LV_FS_RES_OK;
+    posix_file_t * fp = file_p;
+    lv_fs_res_t res = fs_flush(drv, fp);
+#if LV_FS_POSIX_HANDLE_MAX
+    if(fp->f == &fp->own) {
+        SLOT_LOCK();
+        fd_release(fp);
+        SLOT_SIGNAL();
+        SLOT_UNLOCK();
+        lv_mem_free(fp->path);
+    }
+#else
+    if(fp->f == &fp->own) fd_close(fp->f);
+#endif
+#if LV_FS_POSIX_FD_CACHE_SIZE
+    else fd_cache_release(fp->f);
+#endif
+    lv_fs_if_pool_free(&file_pool, fp);
+    return res;
 }
 
 /**
@@ -159,9 +494,12 @@ static lv_fs_res_t fs_close (lv_fs_drv_t * drv, void * file_p)
 static lv_fs_res_t fs_read (lv_fs_drv_t * drv, void * file_p, void * buf, uint32_t btr, uint32_t * br)
 {
     (void) drv;     /*Unused*/
-    int * fp = file_p;
-    *br = read(*fp, buf,  btr);
-    return LV_FS_RES_OK;
+    posix_file_t * fp = file_p;
+    *br = 0;
+    if(FD_GET(fp) != LV_FS_RES_OK) return LV_FS_RES_UNKNOWN;
+    lv_fs_res_t res = file_read(drv, fp, buf, btr, br);
+    FD_PUT(fp);
+    return res;
 }
 
 /**
@@ -176,9 +514,12 @@ static lv_fs_res_t fs_read (lv_fs_drv_t * drv, void * file_p, void * buf, uint32
 static lv_fs_res_t fs_write(lv_fs_drv_t * drv, void * file_p, const void * buf, uint32_t btw, uint32_t * bw)
 {
     (void) drv;     /*Unused*/
-    int * fp = file_p;
-    *bw = write(*fp, buf, btw);
-    return LV_FS_RES_OK;
+    posix_file_t * fp = file_p;
+    *bw = 0;
+    if(FD_GET(fp) != LV_FS_RES_OK) return LV_FS_RES_UNKNOWN;
+    lv_fs_res_t res = file_write(fp, buf, btw, bw);
+    FD_PUT(fp);
+    return res;
 }
 
 /**
@@ -192,8 +533,28 @@ static lv_fs_res_t fs_write(lv_fs_drv_t * drv, void * file_p, const void * buf,
 static lv_fs_res_t fs_seek (lv_fs_drv_t * drv, void * file_p, uint32_t pos, lv_fs_whence_t whence)
 {
     (void) drv;     /*Unused*/
-    int * fp = file_p;
-    lseek(*fp, pos, whence);
+    posix_file_t * fp = file_p;
+
+    /*Only the logical position is updated here. The OS file offset follows on the next read or write*/
+    switch(whence) {
+    case LV_FS_SEEK_SET:
+        fp->pos = pos;
+        break;
+    case LV_FS_SEEK_CUR:
+        fp->pos += pos;
+        break;
+    case LV_FS_SEEK_END: {
+        if(FD_GET(fp) != LV_FS_RES_OK) return LV_FS_RES_UNKNOWN;
+        uint32_t size;
+        lv_fs_res_t res = file_size(drv, fp, &size);
+        FD_PUT(fp);
+        if(res != LV_FS_RES_OK) return res;
+        fp->pos = size + pos;
+        break;
+    }
+    default:
+        return LV_FS_RES_INV_PARAM;
+    }
     return LV_FS_RES_OK;
 }
 
@@ -208,11 +569,851 @@ static lv_fs_res_t fs_seek (lv_fs_drv_t * drv, void * file_p, uint32_t pos, lv_f
 static lv_fs_res_t fs_tell (lv_fs_drv_t * drv, void * file_p, uint32_t * pos_p)
 {
     (void) drv;     /*Unused*/
-    int * fp = file_p;
-    *pos_p = lseek(*fp, 0, SEEK_CUR);
+    posix_file_t * fp = file_p;
+    *pos_p = fp->pos;
+    return LV_FS_RES_OK;
+}
+
+/**
+ * Write the buffered data of a file to the OS
+ * @param drv pointer to a driver where this function belongs
+ * @param file_p pointer to a file_t variable
+ * @return LV_FS_RES_OK or any error from lv_fs_res_t enum
+ */
+static lv_fs_res_t fs_flush(lv_fs_drv_t * drv, void * file_p)
+{
+    (void) drv;     /*Unused*/
+#if LV_FS_POSIX_WRITE_BUF
+    /*Keep the buffer from being flushed by an other thread closing the descriptor*/
+    posix_file_t * fp = file_p;
+    FD_PIN(fp);
+    lv_fs_res_t res = write_back_flush(fp);
+    FD_PUT(fp);
+    return res;
+#else
+    (void) file_p;  /*Unused*/
+    return LV_FS_RES_OK;
+#endif
+}
+
+/**
+ * Pass an advice to the OS with `madvise()` for mapped files, else with `posix_fadvise()`,
+ * and adapt the read-ahead buffer of the handle
+ * @param drv pointer to a driver where this function belongs
+ * @param file_p pointer to a posix_file_t
+ * @param ofs start of the part
+ * @param len length of the part. 0: until the end of the file
+ * @param advice how the part will be read
+ * @return LV_FS_RES_OK or any error from lv_fs_res_t enum
+ */
+static lv_fs_res_t fs_advise(lv_fs_drv_t * drv, void * file_p, uint32_t ofs, uint32_t len, lv_fs_if_advice_t advice)
+{
+    (void) drv;     /*Unused*/
+    posix_file_t * fp = file_p;
+    if(advice > LV_FS_IF_ADVICE_DONTNEED) return LV_FS_RES_INV_PARAM;
+    if(FD_GET(fp) != LV_FS_RES_OK) return LV_FS_RES_UNKNOWN;
+    lv_fs_res_t res = file_advise(fp, ofs, len, advice);
+    FD_PUT(fp);
+    return res;
+}
+
+/**
+ * Read several parts of a file without changing its position.
+ * Segments continuing each other are read with one preadv() call.
+ * @param drv pointer to a driver where this function belongs
+ * @param file_p pointer to a posix_file_t
+ * @param segs the segments sorted by offset
+ * @param cnt number of segments
+ * @return LV_FS_RES_OK or any error from lv_fs_res_t enum
+ */
+static lv_fs_res_t fs_readv(lv_fs_drv_t * drv, void * file_p, lv_fs_if_seg_t * segs, uint32_t cnt)
+{
+    posix_file_t * fp = file_p;
+    if(FD_GET(fp) != LV_FS_RES_OK) return LV_FS_RES_UNKNOWN;
+    lv_fs_res_t res = file_readv(drv, fp, segs, cnt);
+    FD_PUT(fp);
+    return res;
+}
+
+/**
+ * Read from a file whose descriptor is kept open with `FD_GET`
+ * @param drv pointer to a driver where this function belongs
+ * @param fp pointer to a posix_file_t
+ * @param buf pointer to a memory block where to store the read data
+ * @param btr number of Bytes To Read
+ * @param br the real number of read bytes (Byte Read)
+ * @return LV_FS_RES_OK or any error from lv_fs_res_t enum
+ */
+static lv_fs_res_t file_read(lv_fs_drv_t * drv, posix_file_t * fp, void * buf, uint32_t btr, uint32_t * br)
+{
+#if LV_FS_POSIX_MMAP
+    if(fp->f->map) {
+        uint32_t rest = fp->pos < fp->f->size ? fp->f->size - fp->pos : 0;
+        if(btr > rest) btr = rest;
+        memcpy(buf, fp->f->map + fp->pos, btr);
+        fp->pos += btr;
+        *br = btr;
+        return LV_FS_RES_OK;
+    }
+#endif
+
+    /*Let the read see the data written by this handle*/
+    lv_fs_res_t res = fs_flush(drv, fp);
+    if(res != LV_FS_RES_OK) return res;
+
+#if LV_FS_POSIX_READ_AHEAD
+    return read_ahead(fp, buf, btr, br);
+#else
+    ssize_t n = fd_read_at(fp->f, buf, btr, fp->pos);
+    if(n < 0) return LV_FS_RES_UNKNOWN;
+    fp->pos += n;
+    *br = n;
+    return LV_FS_RES_OK;
+#endif
+}
+
+/**
+ * Write into a file whose descriptor is kept open with `FD_GET`
+ * @param fp pointer to a posix_file_t
+ * @param buf pointer to a buffer with the bytes to write
+ * @param btw Bytes To Write
+ * @param bw the number of real written bytes (Bytes Written)
+ * @return LV_FS_RES_OK or any error from lv_fs_res_t enum
+ */
+static lv_fs_res_t file_write(posix_file_t * fp, const void * buf, uint32_t btw, uint32_t * bw)
+{
+#if LV_FS_POSIX_READ_AHEAD
+    fp->ra_len = 0;     /*The buffered data might be overwritten*/
+#endif
+#if LV_FS_POSIX_WRITE_BUF
+    return write_back(fp, buf, btw, bw);
+#else
+    ssize_t res = fd_write_at(fp->f, buf, btw, fp->pos);
+    if(res < 0) return LV_FS_RES_UNKNOWN;
+    fp->pos += res;
+    *bw = res;
+    return LV_FS_RES_OK;
+#endif
+}
+
+/**
+ * Get the size of a file whose descriptor is kept open with `FD_GET`
+ * @param drv pointer to a driver where this function belongs
+ * @param fp pointer to a posix_file_t
+ * @param size pointer to store the size including the buffered writes
+ * @return LV_FS_RES_OK or any error from lv_fs_res_t enum
+ */
+static lv_fs_res_t file_size(lv_fs_drv_t * drv, posix_file_t * fp, uint32_t * size)
+{
+#if LV_FS_POSIX_MMAP
+    if(fp->f->map) {
+        *size = fp->f->size;
+        return LV_FS_RES_OK;
+    }
+#endif
+    /*The size of the file has to include the buffered writes*/
+    lv_fs_res_t res = fs_flush(drv, fp);
+    if(res != LV_FS_RES_OK) return res;
+
+    struct stat st;
+    if(fstat(fp->f->fd, &st) != 0) return LV_FS_RES_UNKNOWN;
+    *size = st.st_size;
+    return LV_FS_RES_OK;
+}
+
+/**
+ * Pass an advice for a file whose descriptor is kept open with `FD_GET`. See `fs_advise()`.
+ * @param fp pointer to a posix_file_t
+ * @param ofs start of the part
+ * @param len length of the part. 0: until the end of the file
+ * @param advice how the part will be read
+ * @return LV_FS_RES_OK or any error from lv_fs_res_t enum
+ */
+static lv_fs_res_t file_advise(posix_file_t * fp, uint32_t ofs, uint32_t len, lv_fs_if_advice_t advice)
+{
+#if LV_FS_POSIX_READ_AHEAD
+    if(advice == LV_FS_IF_ADVICE_DONTNEED) fp->ra_len = 0;
+    else if(advice != LV_FS_IF_ADVICE_WILLNEED) fp->ra_advice = advice;
+#endif
+
+#if LV_FS_POSIX_MMAP
+    if(fp->f->map) {
+        static const int madv[] = {MADV_NORMAL, MADV_SEQUENTIAL, MADV_RANDOM, MADV_WILLNEED, MADV_DONTNEED};
+        if(ofs >= fp->f->size) return LV_FS_RES_OK;
+        if(len == 0 || len > fp->f->size - ofs) len = fp->f->size - ofs;
+
+        /*The mapping starts on a page boundary so the offset can be aligned within it*/
+        uint32_t page = sysconf(_SC_PAGESIZE);
+        uint32_t start = ofs - ofs % page;
+        if(madvise(fp->f->map + start, ofs + len - start, madv[advice]) != 0) return LV_FS_RES_UNKNOWN;
+        return LV_FS_RES_OK;
+    }
+#endif
+
+#ifdef POSIX_FADV_NORMAL
+    static const int fadv[] = {POSIX_FADV_NORMAL, POSIX_FADV_SEQUENTIAL, POSIX_FADV_RANDOM,
+                               POSIX_FADV_WILLNEED, POSIX_FADV_DONTNEED};
+    if(posix_fadvise(fp->f->fd, ofs, len, fadv[advice]) != 0) return LV_FS_RES_UNKNOWN;
+#else
+    (void) fp;      /*Unused*/
+    (void) ofs;     /*Unused*/
+    (void) len;     /*Unused*/
+#endif
+    return LV_FS_RES_OK;
+}
+
+/**
+ * Read several parts of a file whose descriptor is kept open with `FD_GET`. See `fs_readv()`.
+ * @param drv pointer to a driver where this function belongs
+ * @param fp pointer to a posix_file_t
+ * @param segs the segments sorted by offset
+ * @param cnt number of segments
+ * @return LV_FS_RES_OK or any error from lv_fs_res_t enum
+ */
+static lv_fs_res_t file_readv(lv_fs_drv_t * drv, posix_file_t * fp, lv_fs_if_seg_t * segs, uint32_t cnt)
+{
+    uint32_t i;
+#if LV_FS_POSIX_MMAP
+    if(fp->f->map) {
+        for(i = 0; i < cnt; i++) {
+            uint32_t rest = segs[i].ofs < fp->f->size ? fp->f->size - segs[i].ofs : 0;
+            segs[i].br = LV_MIN(segs[i].len, rest);
+            memcpy(segs[i].buf, fp->f->map + segs[i].ofs, segs[i].br);
+        }
+        return LV_FS_RES_OK;
+    }
+#endif
+
+    /*Let the read see the data written by this handle*/
+    lv_fs_res_t res = fs_flush(drv, fp);
+    if(res != LV_FS_RES_OK) return res;
+
+#if LV_FS_POSIX_IO_URING
+    if(uring.fd >= 0) {
+        res = uring_readv(fp->f->fd, segs, cnt);
+        if(res != LV_FS_RES_NOT_IMP) return res;
+    }
+#endif
+
+#ifdef WIN32
+    for(i = 0; i < cnt; i++) {
+        ssize_t n = fd_read_at(fp->f, segs[i].buf, segs[i].len, segs[i].ofs);
+        if(n < 0) return LV_FS_RES_UNKNOWN;
+        segs[i].br = n;
+    }
+#else
+    i = 0;
+    while(i < cnt) {
+        struct iovec iov[LV_FS_POSIX_READV_IOV_MAX];
+        uint32_t end = segs[i].ofs;
+        uint32_t j = i;
+        while(j < cnt && j - i < LV_FS_POSIX_READV_IOV_MAX && segs[j].ofs == end) {
+            iov[j - i].iov_base = segs[j].buf;
+            iov[j - i].iov_len = segs[j].len;
+            end += segs[j].len;
+            j++;
+        }
+
+        ssize_t n = preadv(fp->f->fd, iov, j - i, segs[i].ofs);
+        if(n < 0) return LV_FS_RES_UNKNOWN;
+
+        /*A short read means the end of the file*/
+        for(; i < j; i++) {
+            segs[i].br = LV_MIN(segs[i].len, (size_t)n);
+            n -= segs[i].br;
+        }
+    }
+#endif
+
+    return LV_FS_RES_OK;
+}
+
+#if LV_FS_POSIX_IO_URING
+/**
+ * Set up an io_uring instance. If it fails (old kernel, disabled by seccomp or sysctl)
+ * the readv path keeps using preadv().
+ */
+static void uring_init(void)
+{
+    struct io_uring_params p;
+    memset(&p, 0, sizeof(p));
+    int fd = syscall(__NR_io_uring_setup, LV_FS_POSIX_IO_URING_ENTRIES, &p);
+    if(fd < 0) {
+        LV_LOG_INFO("io_uring is not available (%s), using preadv()", strerror(errno));
+        return;
+    }
+
+    size_t sq_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    size_t cq_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    bool single_mmap = p.features & IORING_FEAT_SINGLE_MMAP;
+    if(single_mmap) sq_size = cq_size = LV_MAX(sq_size, cq_size);
+
+    uint8_t * sq = mmap(NULL, sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    uint8_t * cq = sq;
+    if(sq != MAP_FAILED && !single_mmap) {
+        cq = mmap(NULL, cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+    }
+    void * sqes = MAP_FAILED;
+    if(sq != MAP_FAILED && cq != MAP_FAILED) {
+        sqes = mmap(NULL, p.sq_entries * sizeof(struct io_uring_sqe), PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    }
+
+    if(sqes == MAP_FAILED) {
+        /*The process exits with the mappings, no need to unmap the ones which succeeded*/
+        LV_LOG_WARN("couldn't map the rings of io_uring, using preadv()");
+        close(fd);
+        return;
+    }
+
+    uring.sq_tail = (unsigned *)(sq + p.sq_off.tail);
+    uring.sq_mask = (unsigned *)(sq + p.sq_off.ring_mask);
+    uring.sq_array = (unsigned *)(sq + p.sq_off.array);
+    uring.sqes = sqes;
+    uring.cq_head = (unsigned *)(cq + p.cq_off.head);
+    uring.cq_tail = (unsigned *)(cq + p.cq_off.tail);
+    uring.cq_mask = (unsigned *)(cq + p.cq_off.ring_mask);
+    uring.cqes = (struct io_uring_cqe *)(cq + p.cq_off.cqes);
+    uring.entries = p.sq_entries;
+    uring.fd = fd;
+}
+
+/**
+ * Read segments through io_uring. Up to `LV_FS_POSIX_IO_URING_ENTRIES` segments are submitted
+ * and waited for with one system call, and reads served from the page cache complete inline.
+ * Not thread safe, the ring is shared by all files.
+ * @param fd file descriptor
+ * @param segs the segments sorted by offset
+ * @param cnt number of segments
+ * @return LV_FS_RES_OK, LV_FS_RES_NOT_IMP if the ring can't be used (the read operation is not supported
+ *         or submitting failed) so the segments are to be read otherwise, or any error from lv_fs_res_t enum
+ */
+static lv_fs_res_t uring_readv(int fd, lv_fs_if_seg_t * segs, uint32_t cnt)
+{
+    uint32_t done = 0;
+    while(done < cnt) {
+        uint32_t n = LV_MIN(cnt - done, uring.entries);
+        unsigned tail = *uring.sq_tail;
+        unsigned mask = *uring.sq_mask;
+        uint32_t i;
+        for(i = 0; i < n; i++) {
+            lv_fs_if_seg_t * seg = &segs[done + i];
+            unsigned idx = (tail + i) & mask;
+            struct io_uring_sqe * sqe = &uring.sqes[idx];
+            memset(sqe, 0, sizeof(*sqe));
+            sqe->opcode = IORING_OP_READ;
+            sqe->fd = fd;
+            sqe->addr = (uintptr_t)seg->buf;
+            sqe->len = seg->len;
+            sqe->off = seg->ofs;
+            sqe->user_data = done + i;
+            uring.sq_array[idx] = idx;
+        }
+        __atomic_store_n(uring.sq_tail, tail + n, __ATOMIC_RELEASE);
+
+        /*Submit and wait in one call. Submit the rest again if a signal interrupted it.*/
+        lv_fs_res_t res = LV_FS_RES_OK;
+        uint32_t unsubmitted = n;
+        uint32_t reaped = 0;
+        while(reaped < n) {
+            unsigned head = *uring.cq_head;
+            if(unsubmitted > 0 || head == __atomic_load_n(uring.cq_tail, __ATOMIC_ACQUIRE)) {
+                int ret = syscall(__NR_io_uring_enter, uring.fd, unsubmitted, n - reaped, IORING_ENTER_GETEVENTS, NULL, 0);
+                if(ret < 0 && errno == EINTR) continue;
+                if(ret < 0) {
+                    /*The state of the queued requests is unknown, don't use the ring anymore*/
+                    LV_LOG_WARN("io_uring_enter failed (%s), using preadv()", strerror(errno));
+                    close(uring.fd);
+                    uring.fd = -1;
+                    return LV_FS_RES_NOT_IMP;
+                }
+                unsubmitted -= ret;
+                continue;
+            }
+
+            struct io_uring_cqe * cqe = &uring.cqes[head & *uring.cq_mask];
+            if(cqe->res == -EINVAL) res = LV_FS_RES_NOT_IMP;    /*IORING_OP_READ needs Linux 5.6*/
+            else if(cqe->res < 0) res = LV_FS_RES_UNKNOWN;
+            else segs[cqe->user_data].br = cqe->res;   /*A short read means the end of the file*/
+
+            __atomic_store_n(uring.cq_head, head + 1, __ATOMIC_RELEASE);
+            reaped++;
+        }
+
+        if(res == LV_FS_RES_NOT_IMP) {
+            LV_LOG_WARN("io_uring can't read, using preadv()");
+            close(uring.fd);
+            uring.fd = -1;
+        }
+        if(res != LV_FS_RES_OK) return res;
+
+        done += n;
+    }
+
+    return LV_FS_RES_OK;
+}
+#endif
+
+/**
+ * Open a file in the OS
+ * @param f pointer to a posix_fd_t to initialize
+ * @param path the real path of the file
+ * @param flags flags for open()
+ * @return LV_FS_RES_OK or any error from lv_fs_res_t enum
+ */
+static lv_fs_res_t fd_open(posix_fd_t * f, const char * path, int flags)
+{
+    f->fd = open(path, flags, 0666);
+    if(f->fd < 0) return LV_FS_RES_NOT_EX;
+#ifdef WIN32
+    f->fd_pos = 0;
+#endif
+
+#if LV_FS_POSIX_MMAP
+    f->map = NULL;
+    f->size = 0;
+
+    /*Read-only files are mapped once and served from the memory.
+     *If the mapping is not possible (e.g. empty file) fall back to read()*/
+    if(flags == O_RDONLY) {
+        struct stat st;
+        if(fstat(f->fd, &st) == 0 && st.st_size > 0 && (uint64_t)st.st_size <= UINT32_MAX) {
+            void * m = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, f->fd, 0);
+            if(m != MAP_FAILED) {
+                f->map = m;
+                f->size = st.st_size;
+            }
+        }
+    }
+#endif
+
     return LV_FS_RES_OK;
 }
 
+/**
+ * Close a file opened with `fd_open`
+ * @param f pointer to a posix_fd_t
+ */
+static void fd_close(posix_fd_t * f)
+{
+#if LV_FS_POSIX_MMAP
+    if(f->map) munmap(f->map, f->size);
+#endif
+    close(f->fd);
+}
+
+/**
+ * Read from a given position of a file.
+ * It uses pread() so it doesn't depend on and doesn't change the file offset of the OS
+ * and the handles sharing a descriptor can read in parallel.
+ * @param f pointer to a posix_fd_t
+ * @param buf buffer to read into
+ * @param btr number of bytes to read
+ * @param pos file position to read from
+ * @return number of read bytes or -1 on error
+ */
+static ssize_t fd_read_at(posix_fd_t * f, void * buf, uint32_t btr, uint32_t pos)
+{
+#ifndef WIN32
+    return pread(f->fd, buf, btr, pos);
+#else
+    if(f->fd_pos != pos) {
+        if(lseek(f->fd, pos, SEEK_SET) < 0) return -1;
+        f->fd_pos = pos;
+    }
+
+    ssize_t res = read(f->fd, buf, btr);
+    if(res > 0) f->fd_pos += res;
+    return res;
+#endif
+}
+
+/**
+ * Write to a given position of a file with pwrite()
+ * @param f pointer to a posix_fd_t
+ * @param buf buffer to write
+ * @param btw number of bytes to write
+ * @param pos file position to write to
+ * @return number of written bytes or -1 on error
+ */
+static ssize_t fd_write_at(posix_fd_t * f, const void * buf, uint32_t btw, uint32_t pos)
+{
+#ifndef WIN32
+    return pwrite(f->fd, buf, btw, pos);
+#else
+    if(f->fd_pos != pos) {
+        if(lseek(f->fd, pos, SEEK_SET) < 0) return -1;
+        f->fd_pos = pos;
+    }
+
+    ssize_t res = write(f->fd, buf, btw);
+    if(res > 0) f->fd_pos += res;
+    return res;
+#endif
+}
+
+#if LV_FS_POSIX_FD_CACHE_SIZE
+/**
+ * Get a read-only file from the fd cache or open and add it to the cache.
+ * A cached file is reopened (and remapped) if it was replaced or modified since it was opened.
+ * The least recently used, not referenced file is closed if the cache is full.
+ * @param path the real path of the file
+ * @param f pointer to store the cached file. NULL if all entries are in use.
+ * @return LV_FS_RES_OK or any error from lv_fs_res_t enum
+ */
+static lv_fs_res_t fd_cache_get(const char * path, posix_fd_t ** f)
+{
+    fd_cache_tick++;
+    *f = NULL;
+
+    posix_fd_t * slot = NULL;
+    uint32_t i;
+    for(i = 0; i < LV_FS_POSIX_FD_CACHE_SIZE; i++) {
+        posix_fd_t * e = &fd_cache[i];
+        if(e->path && !e->stale && strcmp(e->path, path) == 0) {
+            struct stat st;
+            if(stat(path, &st) == 0 && st.st_ino == e->ino && st.st_size == e->fsize && st.st_mtime == e->mtime) {
+                e->ref_cnt++;
+                e->last_use = fd_cache_tick;
+                *f = e;
+                return LV_FS_RES_OK;
+            }
+
+            /*Changed: the open handles keep reading the old content*/
+            if(e->ref_cnt) e->stale = 1;
+            else fd_cache_evict(e);
+        }
+
+        /*Prefer a free entry, else the least recently used unreferenced one*/
+        if(e->path == NULL) {
+            if(slot == NULL || slot->path) slot = e;
+        }
+        else if(e->ref_cnt == 0 && (slot == NULL || (slot->path && e->last_use < slot->last_use))) {
+            slot = e;
+        }
+    }
+
+    if(slot == NULL) return LV_FS_RES_OK;
+
+    char * path_copy = lv_mem_alloc(strlen(path) + 1);
+    if(path_copy == NULL) return LV_FS_RES_OK;
+    strcpy(path_copy, path);
+
+    if(slot->path) fd_cache_evict(slot);
+
+    lv_fs_res_t res = fd_open(slot, path, O_RDONLY);
+    if(res != LV_FS_RES_OK) {
+        lv_mem_free(path_copy);
+        return res;
+    }
+
+    struct stat st;
+    if(fstat(slot->fd, &st) == 0) {
+        slot->ino = st.st_ino;
+        slot->fsize = st.st_size;
+        slot->mtime = st.st_mtime;
+    }
+
+    slot->path = path_copy;
+    slot->ref_cnt = 1;
+    slot->last_use = fd_cache_tick;
+    *f = slot;
+    return LV_FS_RES_OK;
+}
+
+/**
+ * Release a file got from `fd_cache_get`. It's kept open until evicted.
+ * @param f pointer to a cached file
+ */
+static void fd_cache_release(posix_fd_t * f)
+{
+    f->ref_cnt--;
+    if(f->ref_cnt == 0 && f->stale) fd_cache_evict(f);
+}
+
+/**
+ * Remove a file from the fd cache because it's opened for writing.
+ * If it's in use it's closed when the last handle releases it.
+ * @param path the real path of the file
+ */
+static void fd_cache_drop(const char * path)
+{
+    uint32_t i;
+    for(i = 0; i < LV_FS_POSIX_FD_CACHE_SIZE; i++) {
+        posix_fd_t * e = &fd_cache[i];
+        if(e->path == NULL || e->stale || strcmp(e->path, path) != 0) continue;
+
+        if(e->ref_cnt) e->stale = 1;
+        else fd_cache_evict(e);
+    }
+}
+
+/**
+ * Close a cached file and free its entry
+ * @param e pointer to an entry of the fd cache
+ */
+static void fd_cache_evict(posix_fd_t * e)
+{
+    fd_close(e);
+    lv_mem_free(e->path);
+    e->path = NULL;
+    e->stale = 0;
+}
+#endif
+
+#if LV_FS_POSIX_HANDLE_MAX
+/**
+ * Make sure the file descriptor of a file is open and keep it open until `fd_put()`.
+ * If it was closed it's reopened, closing the least recently used idle file
+ * if `LV_FS_POSIX_HANDLE_MAX` files are open.
+ * @param fp pointer to a posix_file_t
+ * @return LV_FS_RES_OK or any error from lv_fs_res_t enum
+ */
+static lv_fs_res_t fd_get(posix_file_t * fp)
+{
+    if(fp->f != &fp->own) return LV_FS_RES_OK;     /*The files of the fd cache have no slot*/
+
+    SLOT_LOCK();
+    fp->last_use = ++fd_tick;
+    fp->busy++;
+
+    lv_fs_res_t res = LV_FS_RES_OK;
+    if(fp->own.fd < 0) {
+        int32_t slot = fd_find_slot();
+#if LV_FS_IF_ASYNC || LV_FS_IF_PREFETCH
+        /*All the open files are used by other threads, wait until one is done*/
+        while(slot < 0) {
+            pthread_cond_wait(&slot_cond, &slot_lock);
+            slot = fd_find_slot();
+        }
+#endif
+        if(slot < 0) {
+            res = LV_FS_RES_BUSY;
+        }
+        else {
+            if(fd_owners[slot]) fd_release(fd_owners[slot]);
+            res = fd_open(&fp->own, fp->path, fp->flags);
+            if(res == LV_FS_RES_OK) fd_owners[slot] = fp;
+        }
+    }
+
+    if(res != LV_FS_RES_OK) fp->busy--;
+    SLOT_UNLOCK();
+    return res;
+}
+
+/**
+ * Keep the file descriptor of a file open or closed as it is until `fd_put()`
+ * @param fp pointer to a posix_file_t
+ */
+static void fd_pin(posix_file_t * fp)
+{
+    if(fp->f != &fp->own) return;
+
+    SLOT_LOCK();
+    fp->last_use = ++fd_tick;
+    fp->busy++;
+    SLOT_UNLOCK();
+}
+
+/**
+ * Release a file kept by `fd_get()` or `fd_pin()`. Its descriptor can be closed for other files again.
+ * @param fp pointer to a posix_file_t
+ */
+static void fd_put(posix_file_t * fp)
+{
+    if(fp->f != &fp->own) return;
+
+    SLOT_LOCK();
+    fp->busy--;
+    if(fp->busy == 0) {
+        SLOT_SIGNAL();      /*Its slot can be taken by a waiting thread now*/
+    }
+    SLOT_UNLOCK();
+}
+
+/**
+ * Find a slot for a file to open. Called with the slots locked.
+ * @return index of a free slot or the slot of the least recently used idle file, -1 if all files are busy
+ */
+static int32_t fd_find_slot(void)
+{
+    int32_t slot = -1;
+    uint32_t i;
+    for(i = 0; i < LV_FS_POSIX_HANDLE_MAX; i++) {
+        if(fd_owners[i] == NULL) return i;
+        if(fd_owners[i]->busy) continue;
+        if(slot < 0 || fd_owners[i]->last_use < fd_owners[slot]->last_use) slot = i;
+    }
+    return slot;
+}
+
+/**
+ * Close the file descriptor of a file to free its slot. The buffered writes are flushed first.
+ * Called with the slots locked.
+ * @param fp pointer to a posix_file_t
+ */
+static void fd_release(posix_file_t * fp)
+{
+    if(fp->own.fd < 0) return;
+
+#if LV_FS_POSIX_WRITE_BUF
+    write_back_drain(fp);       /*On error the data stays buffered and is written after reopening*/
+#endif
+    fd_close(&fp->own);
+    fp->own.fd = -1;
+#if LV_FS_POSIX_MMAP
+    fp->own.map = NULL;
+#endif
+
+    uint32_t i;
+    for(i = 0; i < LV_FS_POSIX_HANDLE_MAX; i++) {
+        if(fd_owners[i] == fp) fd_owners[i] = NULL;
+    }
+}
+#endif
+
+#if LV_FS_POSIX_READ_AHEAD
+/**
+ * Read through the read-ahead buffer of a file.
+ * The window grows while the reads are sequential and shrinks on random access.
+ * A SEQUENTIAL or RANDOM advice fixes it to the largest or smallest size.
+ * @param fp pointer to a posix_file_t
+ * @param buf buffer to read into
+ * @param btr number of bytes to read
+ * @param br pointer to store the number of read bytes
+ * @return LV_FS_RES_OK or any error from lv_fs_res_t enum
+ */
+static lv_fs_res_t read_ahead(posix_file_t * fp, uint8_t * buf, uint32_t btr, uint32_t * br)
+{
+    /*Serve what is already buffered*/
+    if(fp->pos >= fp->ra_start && fp->pos < fp->ra_start + fp->ra_len) {
+        uint32_t n = LV_MIN(btr, fp->ra_start + fp->ra_len - fp->pos);
+        memcpy(buf, fp->ra_buf + (fp->pos - fp->ra_start), n);
+        fp->pos += n;
+        buf += n;
+        btr -= n;
+        *br += n;
+    }
+
+    if(btr == 0) return LV_FS_RES_OK;
+
+    /*Continuing right after the buffer means sequential access, unless advised otherwise*/
+    if(fp->ra_advice == LV_FS_IF_ADVICE_SEQUENTIAL) {
+        fp->ra_win = LV_FS_POSIX_READ_AHEAD;
+    }
+    else if(fp->ra_advice == LV_FS_IF_ADVICE_RANDOM) {
+        fp->ra_win = LV_FS_POSIX_READ_AHEAD_MIN;
+    }
+    else if(fp->ra_len > 0 && fp->pos == fp->ra_start + fp->ra_len) {
+        fp->ra_win = LV_MIN(fp->ra_win * 2, LV_FS_POSIX_READ_AHEAD);
+    }
+    else {
+        fp->ra_win = LV_FS_POSIX_READ_AHEAD_MIN;
+    }
+
+    /*Large reads go directly to the caller's buffer*/
+    if(btr >= fp->ra_win) {
+        ssize_t res = fd_read_at(fp->f, buf, btr, fp->pos);
+        if(res < 0) return LV_FS_RES_UNKNOWN;
+        fp->pos += res;
+        *br += res;
+        return LV_FS_RES_OK;
+    }
+
+    ssize_t res = fd_read_at(fp->f, fp->ra_buf, fp->ra_win, fp->pos);
+    if(res < 0) {
+        fp->ra_len = 0;
+        return LV_FS_RES_UNKNOWN;
+    }
+    fp->ra_start = fp->pos;
+    fp->ra_len = res;
+
+    uint32_t n = LV_MIN(btr, fp->ra_len);
+    memcpy(buf, fp->ra_buf, n);
+    fp->pos += n;
+    *br += n;
+    return LV_FS_RES_OK;
+}
+#endif
+
+#if LV_FS_POSIX_WRITE_BUF
+/**
+ * Write through the write-back buffer of a file.
+ * The buffer is flushed if the write doesn't continue the buffered data or it gets full.
+ * @param fp pointer to a posix_file_t
+ * @param buf buffer to write
+ * @param btw number of bytes to write
+ * @param bw pointer to store the number of written bytes
+ * @return LV_FS_RES_OK or any error from lv_fs_res_t enum
+ */
+static lv_fs_res_t write_back(posix_file_t * fp, const uint8_t * buf, uint32_t btw, uint32_t * bw)
+{
+    if(fp->wb_len > 0 && (fp->pos != fp->wb_start + fp->wb_len || fp->wb_len + btw > LV_FS_POSIX_WRITE_BUF)) {
+        lv_fs_res_t res = write_back_flush(fp);
+        if(res != LV_FS_RES_OK) return res;
+    }
+
+    /*Large writes go directly to the file*/
+    if(btw >= LV_FS_POSIX_WRITE_BUF) {
+        ssize_t res = fd_write_at(fp->f, buf, btw, fp->pos);
+        if(res < 0) return LV_FS_RES_UNKNOWN;
+        fp->pos += res;
+        *bw = res;
+        return LV_FS_RES_OK;
+    }
+
+    if(fp->wb_len == 0) fp->wb_start = fp->pos;
+    memcpy(fp->wb_buf + fp->wb_len, buf, btw);
+    fp->wb_len += btw;
+    fp->pos += btw;
+    *bw = btw;
+
+    if(fp->wb_len == LV_FS_POSIX_WRITE_BUF) return write_back_flush(fp);
+    return LV_FS_RES_OK;
+}
+
+/**
+ * Write the content of the write-back buffer to the file.
+ * On error the data is kept so a later flush can retry.
+ * @param fp pointer to a posix_file_t kept by `FD_GET` or `FD_PIN`
+ * @return LV_FS_RES_OK or any error from lv_fs_res_t enum
+ */
+static lv_fs_res_t write_back_flush(posix_file_t * fp)
+{
+    if(fp->wb_len == 0) return LV_FS_RES_OK;
+
+    /*Data left in the buffer by a failed flush might need the file to be reopened*/
+    if(FD_GET(fp) != LV_FS_RES_OK) return LV_FS_RES_UNKNOWN;
+    lv_fs_res_t res = write_back_drain(fp);
+    FD_PUT(fp);
+    return res;
+}
+
+/**
+ * Write the content of the write-back buffer to the open file descriptor of a file.
+ * On error the data is kept so a later flush can retry.
+ * @param fp pointer to a posix_file_t
+ * @return LV_FS_RES_OK or any error from lv_fs_res_t enum
+ */
+static lv_fs_res_t write_back_drain(posix_file_t * fp)
+{
+    uint32_t done = 0;
+    while(done < fp->wb_len) {
+        ssize_t res = fd_write_at(fp->f, fp->wb_buf + done, fp->wb_len - done, fp->wb_start + done);
+        if(res <= 0) {
+            memmove(fp->wb_buf, fp->wb_buf + done, fp->wb_len - done);
+            fp->wb_start += done;
+            fp->wb_len -= done;
+            return LV_FS_RES_UNKNOWN;
+        }
+        done += res;
+    }
+
+    fp->wb_len = 0;
+    return LV_FS_RES_OK;
+}
+#endif
 
 #ifdef WIN32
 static char next_fn[256];
@@ -272,46 +1473,88 @@ static void * fs_dir_open (lv_fs_drv_t * drv, const char *path)
  */
 static lv_fs_res_t fs_dir_read (lv_fs_drv_t * drv, void * dir_p, char *fn)
 {
-//     (void) drv;     /*Unused*/
-
-// #ifndef WIN32
-//     struct dirent *entry;
-//     do {
-//         entry = readdir(dir_p);
-
-//         if(entry) {
-//             if(entry->d_type == DT_DIR) sprintf(fn, "/%s", entry->d_name);
-//             else strcpy(fn, entry->d_name);
-//         } else {
-//             strcpy(fn, "");
-//         }
-//     } while(strcmp(fn, "/.") == 0 || strcmp(fn, "/..") == 0);
-// #else
-//     strcpy(fn, next_fn);
-
-//     strcpy(next_fn, "");
-//     WIN32_FIND_DATA fdata;
-
-//     if(FindNextFile(dir_p, &fdata) == false) return LV_FS_RES_OK;
-//     do {
-//         if (strcmp(fdata.cFileName, ".") == 0 || strcmp(fdata.cFileName, "..") == 0) {
-//             continue;
-//         } else {
-
-//             if (fdata.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
-//             {
-//                 sprintf(next_fn, "/%s", fdata.cFileName);
-//             } else {
-//                 sprintf(next_fn, "%s", fdata.cFileName);
-//             }
-//             break;
-//         }
-//     } while(FindNextFile(dir_p, &fdata));
-
-// #endif
+    (void) drv;     /*Unused*/
+
+#ifndef WIN32
+    struct dirent *entry;
+    do {
+        errno = 0;
+        entry = readdir(dir_p);
+
+        if(entry) {
+            if(entry->d_type == DT_DIR) sprintf(fn, "/%s", entry->d_name);
+            else strcpy(fn, entry->d_name);
+        } else {
+            strcpy(fn, "");
+            if(errno) return LV_FS_RES_UNKNOWN;
+        }
+    } while(strcmp(fn, "/.") == 0 || strcmp(fn, "/..") == 0);
+#else
+    strcpy(fn, next_fn);
+
+    strcpy(next_fn, "");
+    WIN32_FIND_DATA fdata;
+
+    if(FindNextFile(dir_p, &fdata) == false) return LV_FS_RES_OK;
+    do {
+        if (strcmp(fdata.cFileName, ".") == 0 || strcmp(fdata.cFileName, "..") == 0) {
+            continue;
+        } else {
+
+            if (fdata.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+            {
+                sprintf(next_fn, "/%s", fdata.cFileName);
+            } else {
+                sprintf(next_fn, "%s", fdata.cFileName);
+            }
+            break;
+        }
+    } while(FindNextFile(dir_p, &fdata));
+
+#endif
     return LV_FS_RES_OK;
 }
 
+#ifndef WIN32
+/**
+ * Read the next entries of a directory with their type, size and modification time.
+ * `readdir()` gets many entries from the kernel at once (`getdents64()` with a large buffer on Linux),
+ * the metadata comes from `fstatat()` relative to the directory without opening the files.
+ * @param drv pointer to a driver where this function belongs
+ * @param dir_p pointer to a DIR
+ * @param batch pointer to an empty batch to fill
+ * @return LV_FS_RES_OK or any error from lv_fs_res_t enum
+ */
+static lv_fs_res_t fs_dir_read_batch(lv_fs_drv_t * drv, void * dir_p, lv_fs_if_dir_batch_t * batch)
+{
+    (void) drv;     /*Unused*/
+    int dfd = dirfd(dir_p);
+
+    while(lv_fs_if_dir_batch_has_room(batch)) {
+        errno = 0;
+        struct dirent * entry = readdir(dir_p);
+        if(entry == NULL) return errno ? LV_FS_RES_UNKNOWN : LV_FS_RES_OK;
+        if(strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) continue;
+
+        lv_fs_if_dirent_t * e = lv_fs_if_dir_batch_add(batch, entry->d_name, strlen(entry->d_name));
+        if(e == NULL) return LV_FS_RES_UNKNOWN;    /*Longer than LV_FS_IF_DIRENT_NAME_MAX*/
+
+        struct stat st;
+        if(fstatat(dfd, entry->d_name, &st, 0) == 0) {
+            e->type = S_ISDIR(st.st_mode) ? LV_FS_IF_DIRENT_DIR : LV_FS_IF_DIRENT_FILE;
+            if(S_ISREG(st.st_mode)) e->size = st.st_size;
+            e->mtime = st.st_mtime;
+        }
+        else {
+            /*E.g. a broken symlink. Still list it with the type known from the directory.*/
+            e->type = entry->d_type == DT_DIR ? LV_FS_IF_DIRENT_DIR : LV_FS_IF_DIRENT_FILE;
+        }
+    }
+
+    return LV_FS_RES_OK;
+}
+#endif
+
 /**
  * Close the directory reading
  * @param drv pointer to a driver where this function belongs
@@ -329,5 +1572,94 @@ static lv_fs_res_t fs_dir_close (lv_fs_drv_t * drv, void * dir_p)
     return LV_FS_RES_OK;
 }
 
+#ifndef WIN32
+/**
+ * Map the whole content of a file into the memory
+ * @param drv pointer to a driver where this function belongs
+ * @param path path to the file
+ * @param ptr pointer to store the address of the content
+ * @param size pointer to store the size of the content
+ * @param map_d unused
+ * @return LV_FS_RES_OK, LV_FS_RES_NOT_IMP if the file can't be mapped
+ *         or any error from lv_fs_res_t enum
+ */
+static lv_fs_res_t fs_map(lv_fs_drv_t * drv, const char * path, const void ** ptr, uint32_t * size, void ** map_d)
+{
+    (void) drv;     /*Unused*/
+    (void) map_d;   /*Unused*/
+
+    char buf[256];
+    sprintf(buf, LV_FS_POSIX_PATH "%s", path);
+
+    int f = open(buf, O_RDONLY);
+    if(f < 0) return LV_FS_RES_NOT_EX;
+
+    struct stat st;
+    if(fstat(f, &st) != 0 || st.st_size == 0 || (uint64_t)st.st_size > UINT32_MAX) {
+        close(f);
+        return LV_FS_RES_NOT_IMP;
+    }
+
+    /*The mapping remains valid after closing the file*/
+    void * m = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, f, 0);
+    close(f);
+    if(m == MAP_FAILED) return LV_FS_RES_NOT_IMP;
+
+    *ptr = m;
+    *size = st.st_size;
+    return LV_FS_RES_OK;
+}
+
+/**
+ * Release a mapping created by `fs_map`
+ * @param drv pointer to a driver where this function belongs
+ * @param ptr address of the mapping
+ * @param size size of the mapping
+ * @param map_d unused
+ */
+static void fs_unmap(lv_fs_drv_t * drv, const void * ptr, uint32_t size, void * map_d)
+{
+    (void) drv;     /*Unused*/
+    (void) map_d;   /*Unused*/
+    munmap((void *)ptr, size);
+}
+
+/**
+ * Load a part of a file into the page cache of the OS. Uses no state of the driver so it's thread safe.
+ * @param drv pointer to a driver where this function belongs
+ * @param path path to the file
+ * @param ofs position of the part
+ * @param len length of the part
+ * @return LV_FS_RES_OK or any error from lv_fs_res_t enum
+ */
+static lv_fs_res_t fs_prefetch(lv_fs_drv_t * drv, const char * path, uint32_t ofs, uint32_t len)
+{
+    (void) drv;     /*Unused*/
+
+    char buf[256];
+    sprintf(buf, LV_FS_POSIX_PATH "%s", path);
+
+    int f = open(buf, O_RDONLY);
+    if(f < 0) return LV_FS_RES_NOT_EX;
+
+    lv_fs_res_t res = LV_FS_RES_OK;
+#ifdef POSIX_FADV_WILLNEED
+    if(posix_fadvise(f, ofs, len, POSIX_FADV_WILLNEED) != 0) res = LV_FS_RES_FS_ERR;
+#else
+    /*Without a hint just read the part*/
+    uint8_t tmp[512];
+    while(len > 0) {
+        ssize_t r = pread(f, tmp, LV_MIN(len, sizeof(tmp)), ofs);
+        if(r <= 0) break;
+        ofs += r;
+        len -= r;
+    }
+#endif
+
+    close(f);
+    return res;
+}
+#endif
+
 #endif  /*LV_USE_FS_IF*/
 #endif  /*LV_FS_IF_FATFS*/
@@ -0,0 +1,513 @@
+/**
+ * @file lv_fs_ram.c
+ *
+ */
+
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "lv_fs_if.h"
+#if LV_USE_FS_IF
+#if LV_FS_IF_RAM != '\0'
+
+#include <string.h>
+
+/*********************
+ *      DEFINES
+ *********************/
+/*Size of the arena holding the content and the name of the files in bytes*/
+#ifndef LV_FS_RAM_SIZE
+# define LV_FS_RAM_SIZE         (32 * 1024U)
+#endif
+
+/*Max. number of files on the RAM disk*/
+#ifndef LV_FS_RAM_FILE_MAX
+# define LV_FS_RAM_FILE_MAX     32
+#endif
+
+/*If defined (e.g. "S:/boot") the directory is copied to the RAM disk by `lv_fs_if_init()`
+ *with the same path (R:/boot)*/
+/*#define LV_FS_RAM_PRELOAD    "S:/boot"*/
+
+/*Alignment of the file contents in the arena*/
+#define RAM_ALIGN               8
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+typedef struct {
+    const char * path;  /*Path without the leading '/'*/
+    const uint8_t * data;
+    uint32_t size;
+    uint32_t hash;      /*Hash of `path` to make the lookup fast*/
+} ram_entry_t;
+
+typedef struct {
+    const ram_entry_t * e;
+    uint32_t pos;
+} ram_file_t;
+
+typedef struct {
+    const char * base;  /*The path of the directory is the first `base_len` characters of `base`*/
+    uint32_t base_len;
+    uint32_t idx;       /*Next entry to check*/
+} ram_dir_t;
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+static void * fs_open (lv_fs_drv_t * drv, const char * path, lv_fs_mode_t mode);
+static lv_fs_res_t fs_close (lv_fs_drv_t * drv, void * file_p);
+static lv_fs_res_t fs_read (lv_fs_drv_t * drv, void * file_p, void * buf, uint32_t btr, uint32_t * br);
+static lv_fs_res_t fs_seek (lv_fs_drv_t * drv, void * file_p, uint32_t pos, lv_fs_whence_t whence);
+static lv_fs_res_t fs_tell (lv_fs_drv_t * drv, void * file_p, uint32_t * pos_p);
+static void * fs_dir_open (lv_fs_drv_t * drv, const char *path);
+static lv_fs_res_t fs_dir_read (lv_fs_drv_t * drv, void * dir_p, char *fn);
+static lv_fs_res_t fs_dir_close (lv_fs_drv_t * drv, void * dir_p);
+static lv_fs_res_t fs_map(lv_fs_drv_t * drv, const char * path, const void ** ptr, uint32_t * size, void ** map_d);
+static const ram_entry_t * entry_find(const char * path);
+static bool entry_in_dir(const ram_entry_t * e, const char * dir, uint32_t dir_len);
+static const char * skip_root(const char * path);
+static uint32_t path_hash(const char * path);
+static void * arena_alloc(uint32_t size, uint32_t align);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+LV_FS_IF_POOL_DEF(file_pool, ram_file_t, LV_FS_IF_FILE_POOL_SIZE);
+LV_FS_IF_POOL_DEF(dir_pool, ram_dir_t, LV_FS_IF_DIR_POOL_SIZE);
+LV_ATTRIBUTE_LARGE_RAM_ARRAY static uint64_t arena[(LV_FS_RAM_SIZE + 7) / 8];   /*uint64_t for alignment*/
+static uint32_t arena_used;
+static ram_entry_t entries[LV_FS_RAM_FILE_MAX];
+static uint32_t entry_cnt;
+
+/**********************
+ *      MACROS
+ **********************/
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+/**
+ * Register a driver for the File system interface
+ */
+void lv_fs_if_ram_init(void)
+{
+    /*---------------------------------------------------
+     * Register the file system interface  in LittlevGL
+     *--------------------------------------------------*/
+
+    static lv_fs_drv_t fs_drv;                         /*A driver descriptor*/
+    lv_fs_drv_init(&fs_drv);
+
+    /*Set up fields...*/
+    fs_drv.letter = LV_FS_IF_RAM;
+    fs_drv.open_cb = fs_open;
+    fs_drv.close_cb = fs_close;
+    fs_drv.read_cb = fs_read;
+    fs_drv.seek_cb = fs_seek;
+    fs_drv.tell_cb = fs_tell;
+
+    fs_drv.dir_close_cb = fs_dir_close;
+    fs_drv.dir_open_cb = fs_dir_open;
+    fs_drv.dir_read_cb = fs_dir_read;
+
+    lv_fs_drv_register(&fs_drv);
+
+    LV_FS_IF_POOL_INIT(file_pool, LV_FS_IF_FILE_POOL_SIZE);
+    LV_FS_IF_POOL_INIT(dir_pool, LV_FS_IF_DIR_POOL_SIZE);
+
+    /*The content is always in the memory so mapping is free*/
+    static lv_fs_if_ext_t fs_ext;
+    fs_ext.map_cb = fs_map;
+    fs_ext.file_pool = &file_pool;
+    fs_ext.dir_pool = &dir_pool;
+    fs_ext.thread_safe = true;      /*The files are only read and have their own position*/
+    lv_fs_if_set_ext(&fs_drv, &fs_ext);
+
+#ifdef LV_FS_RAM_PRELOAD
+    lv_fs_if_ram_load_dir(LV_FS_RAM_PRELOAD, LV_FS_RAM_PRELOAD + 2);
+#endif
+}
+
+/**
+ * Copy a file from any registered driver to the RAM disk
+ * @param src path of the file to copy with driver letter (e.g. "S:/boot/logo.bin")
+ * @param dst path on the RAM disk without driver letter (e.g. "/logo.bin")
+ * @return LV_FS_RES_OK, LV_FS_RES_FULL if there is no space for the file,
+ *         LV_FS_RES_DENIED if `dst` already exists or any error from lv_fs_res_t enum
+ */
+lv_fs_res_t lv_fs_if_ram_load(const char * src, const char * dst)
+{
+    dst = skip_root(dst);
+    if(entry_find(dst)) return LV_FS_RES_DENIED;
+    if(entry_cnt >= LV_FS_RAM_FILE_MAX) {
+        LV_LOG_WARN("lv_fs_if_ram_load: too many files, increase LV_FS_RAM_FILE_MAX");
+        return LV_FS_RES_FULL;
+    }
+
+    lv_fs_file_t f;
+    lv_fs_res_t res = lv_fs_open(&f, src, LV_FS_MODE_RD);
+    if(res != LV_FS_RES_OK) return res;
+
+    uint32_t size = 0;
+    res = lv_fs_seek(&f, 0, LV_FS_SEEK_END);
+    if(res == LV_FS_RES_OK) res = lv_fs_tell(&f, &size);
+    if(res == LV_FS_RES_OK) res = lv_fs_seek(&f, 0, LV_FS_SEEK_SET);
+    if(res != LV_FS_RES_OK) {
+        lv_fs_close(&f);
+        return res;
+    }
+
+    /*Files can't be removed so the arena is only rolled back if this file fails*/
+    uint32_t arena_used_ori = arena_used;
+    uint8_t * data = arena_alloc(size, RAM_ALIGN);
+    char * path = arena_alloc(strlen(dst) + 1, 1);
+    if(data == NULL || path == NULL) {
+        LV_LOG_WARN("lv_fs_if_ram_load: no space for %s, increase LV_FS_RAM_SIZE", src);
+        lv_fs_close(&f);
+        arena_used = arena_used_ori;
+        return LV_FS_RES_FULL;
+    }
+
+    uint32_t br = 0;
+    res = lv_fs_read(&f, data, size, &br);
+    lv_fs_close(&f);
+    if(res == LV_FS_RES_OK && br != size) res = LV_FS_RES_UNKNOWN;
+    if(res != LV_FS_RES_OK) {
+        arena_used = arena_used_ori;
+        return res;
+    }
+
+    strcpy(path, dst);
+    ram_entry_t * e = &entries[entry_cnt];
+    e->path = path;
+    e->data = data;
+    e->size = size;
+    e->hash = path_hash(path);
+    entry_cnt++;
+
+    return LV_FS_RES_OK;
+}
+
+/**
+ * Copy a directory with all its files and sub directories to the RAM disk
+ * @param src path of the directory with driver letter (e.g. "S:/boot")
+ * @param dst path of the directory on the RAM disk without driver letter (e.g. "/boot")
+ * @return LV_FS_RES_OK or the first error of `lv_fs_if_ram_load()`
+ */
+lv_fs_res_t lv_fs_if_ram_load_dir(const char * src, const char * dst)
+{
+    lv_fs_dir_t d;
+    lv_fs_res_t res = lv_fs_dir_open(&d, src);
+    if(res != LV_FS_RES_OK) return res;
+
+    char fn[LV_FS_MAX_PATH_LENGTH];
+    char src_path[LV_FS_MAX_PATH_LENGTH];
+    char dst_path[LV_FS_MAX_PATH_LENGTH];
+    while(1) {
+        res = lv_fs_dir_read(&d, fn);
+        if(res != LV_FS_RES_OK || fn[0] == '\0') break;
+
+        /*Directories begin with '/'*/
+        const char * name = fn[0] == '/' ? fn + 1 : fn;
+        lv_snprintf(src_path, sizeof(src_path), "%s/%s", src, name);
+        lv_snprintf(dst_path, sizeof(dst_path), "%s/%s", dst, name);
+
+        if(fn[0] == '/') res = lv_fs_if_ram_load_dir(src_path, dst_path);
+        else res = lv_fs_if_ram_load(src_path, dst_path);
+        if(res != LV_FS_RES_OK) break;
+    }
+
+    lv_fs_dir_close(&d);
+    return res;
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+/**
+ * Open a file
+ * @param drv pointer to a driver where this function belongs
+ * @param path path to the file
+ * @param mode only LV_FS_MODE_RD is supported
+ * @return pointer to a ram_file_t or NULL on error
+ */
+static void * fs_open (lv_fs_drv_t * drv, const char * path, lv_fs_mode_t mode)
+{
+    (void) drv;     /*Unused*/
+    if(mode != LV_FS_MODE_RD) return NULL;
+
+    const ram_entry_t * e = entry_find(skip_root(path));
+    if(e == NULL) return NULL;
+
+    ram_file_t * fp = lv_fs_if_pool_alloc(&file_pool);
+    if(fp == NULL) return NULL;
+
+    fp->e = e;
+    fp->pos = 0;
+    return fp;
+}
+
+/**
+ * Close an opened file
+ * @param drv pointer to a driver where this function belongs
+ * @param file_p pointer to a ram_file_t
+ * @return LV_FS_RES_OK
+ */
+static lv_fs_res_t fs_close (lv_fs_drv_t * drv, void * file_p)
+{
+    (void) drv;     /*Unused*/
+    lv_fs_if_pool_free(&file_pool, file_p);
+    return LV_FS_RES_OK;
+}
+
+/**
+ * Read data from an opened file
+ * @param drv pointer to a driver where this function belongs
+ * @param file_p pointer to a ram_file_t
+ * @param buf pointer to a memory block where to store the read data
+ * @param btr number of Bytes To Read
+ * @param br the real number of read bytes (Byte Read)
+ * @return LV_FS_RES_OK
+ */
+static lv_fs_res_t fs_read (lv_fs_drv_t * drv, void * file_p, void * buf, uint32_t btr, uint32_t * br)
+{
+    (void) drv;     /*Unused*/
+    ram_file_t * fp = file_p;
+    uint32_t rest = fp->pos < fp->e->size ? fp->e->size - fp->pos : 0;
+    if(btr > rest) btr = rest;
+    memcpy(buf, fp->e->data + fp->pos, btr);
+    fp->pos += btr;
+    *br = btr;
+    return LV_FS_RES_OK;
+}
+
+/**
+ * Set the read pointer
+ * @param drv pointer to a driver where this function belongs
+ * @param file_p pointer to a ram_file_t
+ * @param pos the new position of read pointer
+ * @param whence tells from where to interpret the `pos`. See @lv_fs_whence_t
+ * @return LV_FS_RES_OK or LV_FS_RES_INV_PARAM
+ */
+static lv_fs_res_t fs_seek (lv_fs_drv_t * drv, void * file_p, uint32_t pos, lv_fs_whence_t whence)
+{
+    (void) drv;     /*Unused*/
+    ram_file_t * fp = file_p;
+    switch(whence) {
+    case LV_FS_SEEK_SET:
+        fp->pos = pos;
+        break;
+    case LV_FS_SEEK_CUR:
+        fp->pos += pos;
+        break;
+    case LV_FS_SEEK_END:
+        fp->pos = fp->e->size + pos;
+        break;
+    default:
+        return LV_FS_RES_INV_PARAM;
+    }
+    return LV_FS_RES_OK;
+}
+
+/**
+ * Give the position of the read pointer
+ * @param drv pointer to a driver where this function belongs
+ * @param file_p pointer to a ram_file_t
+ * @param pos_p pointer to to store the result
+ * @return LV_FS_RES_OK
+ */
+static lv_fs_res_t fs_tell (lv_fs_drv_t * drv, void * file_p, uint32_t * pos_p)
+{
+    (void) drv;     /*Unused*/
+    ram_file_t * fp = file_p;
+    *pos_p = fp->pos;
+    return LV_FS_RES_OK;
+}
+
+/**
+ * Open a directory. It exists if it contains at least one file.
+ * @param drv pointer to a driver where this function belongs
+ * @param path path to a directory
+ * @return pointer to a ram_dir_t or NULL on error
+ */
+static void * fs_dir_open (lv_fs_drv_t * drv, const char *path)
+{
+    (void) drv;     /*Unused*/
+    path = skip_root(path);
+    uint32_t len = strlen(path);
+    if(len > 0 && path[len - 1] == '/') len--;
+
+    /*The path of a file in the directory is used to store the path of the directory*/
+    uint32_t i;
+    for(i = 0; i < entry_cnt; i++) {
+        if(entry_in_dir(&entries[i], path, len)) break;
+    }
+    if(i == entry_cnt) return NULL;
+
+    ram_dir_t * d = lv_fs_if_pool_alloc(&dir_pool);
+    if(d == NULL) return NULL;
+
+    d->base = entries[i].path;
+    d->base_len = len;
+    d->idx = i;
+    return d;
+}
+
+/**
+ * Read the next filename from a directory.
+ * The name of the directories will begin with '/'
+ * @param drv pointer to a driver where this function belongs
+ * @param dir_p pointer to a ram_dir_t
+ * @param fn pointer to a buffer to store the filename
+ * @return LV_FS_RES_OK
+ */
+static lv_fs_res_t fs_dir_read (lv_fs_drv_t * drv, void * dir_p, char *fn)
+{
+    (void) drv;     /*Unused*/
+    ram_dir_t * d = dir_p;
+    uint32_t name_ofs = d->base_len ? d->base_len + 1 : 0;
+
+    for(; d->idx < entry_cnt; d->idx++) {
+        const ram_entry_t * e = &entries[d->idx];
+        if(!entry_in_dir(e, d->base, d->base_len)) continue;
+
+        const char * name = e->path + name_ofs;
+        const char * slash = strchr(name, '/');
+        if(slash == NULL) {
+            strcpy(fn, name);
+            d->idx++;
+            return LV_FS_RES_OK;
+        }
+
+        /*A file in a sub directory. Report the directory only with its first file*/
+        uint32_t sub_len = slash - e->path;
+        uint32_t j;
+        for(j = 0; j < d->idx; j++) {
+            if(strncmp(entries[j].path, e->path, sub_len + 1) == 0) break;
+        }
+        if(j < d->idx) continue;
+
+        fn[0] = '/';
+        memcpy(fn + 1, name, slash - name);
+        fn[1 + (slash - name)] = '\0';
+        d->idx++;
+        return LV_FS_RES_OK;
+    }
+
+    fn[0] = '\0';
+    return LV_FS_RES_OK;
+}
+
+/**
+ * Close the directory reading
+ * @param drv pointer to a driver where this function belongs
+ * @param dir_p pointer to a ram_dir_t
+ * @return LV_FS_RES_OK
+ */
+static lv_fs_res_t fs_dir_close (lv_fs_drv_t * drv, void * dir_p)
+{
+    (void) drv;     /*Unused*/
+    lv_fs_if_pool_free(&dir_pool, dir_p);
+    return LV_FS_RES_OK;
+}
+
+/**
+ * Give the content of a file in place
+ * @param drv pointer to a driver where this function belongs
+ * @param path path to the file
+ * @param ptr pointer to store the address of the content
+ * @param size pointer to store the size of the content
+ * @param map_d unused
+ * @return LV_FS_RES_OK or LV_FS_RES_NOT_EX
+ */
+static lv_fs_res_t fs_map(lv_fs_drv_t * drv, const char * path, const void ** ptr, uint32_t * size, void ** map_d)
+{
+    (void) drv;     /*Unused*/
+    (void) map_d;   /*Unused*/
+
+    const ram_entry_t * e = entry_find(skip_root(path));
+    if(e == NULL) return LV_FS_RES_NOT_EX;
+
+    *ptr = e->data;
+    *size = e->size;
+    return LV_FS_RES_OK;
+}
+
+/**
+ * Find a file by its path
+ * @param path path without the leading '/'
+ * @return pointer to the entry or NULL if not found
+ */
+static const ram_entry_t * entry_find(const char * path)
+{
+    uint32_t hash = path_hash(path);
+    uint32_t i;
+    for(i = 0; i < entry_cnt; i++) {
+        if(entries[i].hash == hash && strcmp(entries[i].path, path) == 0) return &entries[i];
+    }
+
+    return NULL;
+}
+
+/**
+ * Tell whether a file is in a directory or in any of its sub directories
+ * @param e pointer to an entry
+ * @param dir path of the directory without the leading '/'. The root is "".
+ * @param dir_len length of `dir` without trailing '/'
+ * @return true: the file is in the directory
+ */
+static bool entry_in_dir(const ram_entry_t * e, const char * dir, uint32_t dir_len)
+{
+    if(dir_len == 0) return true;
+    return strncmp(e->path, dir, dir_len) == 0 && e->path[dir_len] == '/';
+}
+
+/**
+ * Skip the leading '/' of a path. The files are stored relative to the root.
+ * @param path a path
+ * @return pointer into `path` after the leading '/'s
+ */
+static const char * skip_root(const char * path)
+{
+    while(*path == '/') path++;
+    return path;
+}
+
+/**
+ * Calculate the FNV-1a hash of a path
+ * @param path a path
+ * @return the hash
+ */
+static uint32_t path_hash(const char * path)
+{
+    uint32_t h = 2166136261U;
+    while(*path) {
+        h ^= (uint8_t)*path;
+        h *= 16777619U;
+        path++;
+    }
+    return h;
+}
+
+/**
+ * Allocate memory from the end of the arena
+ * @param size number of bytes
+ * @param align required alignment (power of 2)
+ * @return pointer to the memory or NULL if the arena is full
+ */
+static void * arena_alloc(uint32_t size, uint32_t align)
+{
+    uint32_t start = (arena_used + align - 1) & ~(align - 1);
+    if(start > LV_FS_RAM_SIZE || size > LV_FS_RAM_SIZE - start) return NULL;
+
+    arena_used = start + size;
+    return (uint8_t *)arena + start;
+}
+
+#endif  /*LV_FS_IF_RAM*/
+#endif  /*LV_USE_FS_IF*/
@@ -0,0 +1,213 @@
+#!/usr/bin/env python3
+"""
+Pack a directory into an archive for the archive driver (lv_fs_archive.c)
+
+Usage:
+    lv_fs_archive.py [--align N] [--lz4] [--block-size N] -o assets.bin <dir>
+
+The files are stored with their path relative to <dir>, e.g. <dir>/icons/ok.bin
+can be opened as "A:/icons/ok.bin".
+
+Layout (all numbers are 32 bit little endian unless noted):
+    header      magic "LVFA", version (u16), reserved (u16), entry_cnt,
+                bucket_cnt, bucket_ofs, entry_ofs
+    buckets     bucket_cnt entry indices (0xFFFFFFFF: empty), open addressing
+                with linear probing on FNV-1a hash & (bucket_cnt - 1)
+    entries     entry_cnt * (hash, name_ofs, data_ofs, size, flags)
+    names       '\\0' terminated paths without the leading '/'
+    payloads    the content of the files, each aligned to --align bytes
+
+With --lz4 the files which get smaller are split into --block-size blocks and
+compressed independently (flags = 1). Their payload is the block size,
+block_cnt + 1 block offsets in the archive and the LZ4 blocks. A block which
+doesn't get smaller is stored as it is.
+"""
+
+import argparse
+import os
+import struct
+import sys
+
+MAGIC = b"LVFA"
+VERSION = 1
+HEADER_FMT = "<4sHHIIII"
+ENTRY_FMT = "<IIIII"
+EMPTY = 0xFFFFFFFF
+FLAG_LZ4 = 0x1
+
+
+def fnv1a(s):
+    h = 2166136261
+    for b in s:
+        h ^= b
+        h = (h * 16777619) & 0xFFFFFFFF
+    return h
+
+
+def lz4_write_len(out, v):
+    while v >= 255:
+        out.append(255)
+        v -= 255
+    out.append(v)
+
+
+def lz4_compress(src):
+    """Compress to an LZ4 block (without frame) with a simple greedy matcher"""
+    n = len(src)
+    out = bytearray()
+    table = {}
+    anchor = 0
+    i = 0
+
+    # The last match has to start at least 12 bytes and end at least 5 bytes before the end
+    while i < n - 12:
+        key = src[i:i + 4]
+        cand = table.get(key)
+        table[key] = i
+        if cand is None or i - cand > 0xFFFF:
+            i += 1
+            continue
+
+        mlen = 4
+        while i + mlen < n - 5 and src[cand + mlen] == src[i + mlen]:
+            mlen += 1
+
+        lit = i - anchor
+        out.append((min(lit, 15) << 4) | min(mlen - 4, 15))
+        if lit >= 15:
+            lz4_write_len(out, lit - 15)
+        out += src[anchor:i]
+        out += struct.pack("<H", i - cand)
+        if mlen - 4 >= 15:
+            lz4_write_len(out, mlen - 4 - 15)
+
+        i += mlen
+        anchor = i
+
+    lit = n - anchor
+    out.append(min(lit, 15) << 4)
+    if lit >= 15:
+        lz4_write_len(out, lit - 15)
+    out += src[anchor:]
+    return bytes(out)
+
+
+def lz4_blocks(data, block_size, data_ofs):
+    """Create the payload of a compressed file starting at `data_ofs` in the archive"""
+    blocks = []
+    for i in range(0, len(data), block_size):
+        raw = data[i:i + block_size]
+        comp = lz4_compress(raw)
+        blocks.append(comp if len(comp) < len(raw) else raw)
+
+    ofs = data_ofs + 4 + (len(blocks) + 1) * 4
+    table = []
+    for b in blocks:
+        table.append(ofs)
+        ofs += len(b)
+    table.append(ofs)
+
+    return struct.pack("<I%dI" % len(table), block_size, *table) + b"".join(blocks)
+
+
+def align_up(v, a):
+    return (v + a - 1) // a * a
+
+
+def collect(root):
+    files = []
+    for dirpath, dirnames, filenames in os.walk(root):
+        dirnames.sort()
+        for fn in sorted(filenames):
+            full = os.path.join(dirpath, fn)
+            rel = os.path.relpath(full, root).replace(os.sep, "/")
+            files.append((rel.encode("utf-8"), full))
+    return files
+
+
+def pack(files, align, block_size):
+    entry_cnt = len(files)
+
+    # Keep the load factor <= 0.5 so probing stays short and always finds an empty bucket
+    bucket_cnt = 1
+    while bucket_cnt < entry_cnt * 2:
+        bucket_cnt *= 2
+
+    header_size = struct.calcsize(HEADER_FMT)
+    entry_size = struct.calcsize(ENTRY_FMT)
+    bucket_ofs = header_size
+    entry_ofs = bucket_ofs + bucket_cnt * 4
+    names_ofs = entry_ofs + entry_cnt * entry_size
+
+    name_pos = []
+    pos = names_ofs
+    for name, _ in files:
+        name_pos.append(pos)
+        pos += len(name) + 1
+
+    entries = []
+    payload = bytearray()
+    data_start = align_up(pos, align)
+    for (name, full), name_ofs in zip(files, name_pos):
+        with open(full, "rb") as f:
+            data = f.read()
+        payload += bytes(align_up(len(payload), align) - len(payload))
+        data_ofs = data_start + len(payload)
+        flags = 0
+        stored = data
+        if block_size:
+            comp = lz4_blocks(data, block_size, data_ofs)
+            if len(comp) < len(data):
+                flags = FLAG_LZ4
+                stored = comp
+        entries.append((fnv1a(name), name_ofs, data_ofs, len(data), flags))
+        payload += stored
+
+    if data_start + len(payload) > 0xFFFFFFFF:
+        sys.exit("The archive is larger than 4 GB")
+
+    buckets = [EMPTY] * bucket_cnt
+    for i, e in enumerate(entries):
+        b = e[0] & (bucket_cnt - 1)
+        while buckets[b] != EMPTY:
+            b = (b + 1) & (bucket_cnt - 1)
+        buckets[b] = i
+
+    out = bytearray()
+    out += struct.pack(HEADER_FMT, MAGIC, VERSION, 0, entry_cnt, bucket_cnt, bucket_ofs, entry_ofs)
+    out += struct.pack("<%dI" % bucket_cnt, *buckets)
+    for e in entries:
+        out += struct.pack(ENTRY_FMT, *e)
+    for name, _ in files:
+        out += name + b"\0"
+    out += bytes(data_start - len(out))
+    out += payload
+    return out
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Pack a directory for the LVGL archive driver")
+    parser.add_argument("dir", help="directory to pack")
+    parser.add_argument("-o", "--output", required=True, help="archive to create")
+    parser.add_argument("--align", type=int, default=8, help="alignment of the file contents (default: 8)")
+    parser.add_argument("--lz4", action="store_true", help="compress the files with LZ4 if they get smaller")
+    parser.add_argument("--block-size", type=int, default=4096,
+                        help="size of the independently compressed blocks (default: 4096). "
+                             "Must not be larger than LV_FS_ARCHIVE_LZ4_BLOCK_SIZE")
+    args = parser.parse_args()
+
+    if args.align < 1 or args.align & (args.align - 1):
+        sys.exit("--align must be a power of 2")
+    if args.block_size < 1:
+        sys.exit("--block-size must be positive")
+
+    files = collect(args.dir)
+    data = pack(files, args.align, args.block_size if args.lz4 else 0)
+    with open(args.output, "wb") as f:
+        f.write(data)
+
+    print("%s: %d files, %d bytes" % (args.output, len(files), len(data)))
+
+
+if __name__ == "__main__":
+    main()
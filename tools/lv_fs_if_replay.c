@@ -0,0 +1,561 @@
+/**
+ * @file lv_fs_if_replay.c
+ * Replay a trace recorded with `LV_FS_IF_TRACE` on the drivers registered by `lv_fs_if_init()`
+ * and print the latency distribution of each operation.
+ *
+ * Usage: lv_fs_if_replay [--json] [--realtime] [--create] <trace> <drive:dir> [<drive:dir> ...]
+ * E.g.   lv_fs_if_replay --create io.trace X:/tmp/replay P:/tmp/replay S:
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "../bench/lv_fs_if_bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/*********************
+ *      DEFINES
+ *********************/
+/*Must match lv_fs_if_trace.c*/
+#define TRACE_MAGIC         "LVIT"
+#define TRACE_VERSION       1
+#define TRACE_HEADER_SIZE   16
+#define TRACE_REC_SIZE      24
+#define TRACE_OP_LOST       0xFF
+#define TRACE_FLAG_NESTED   0x0001
+#define ID_NONE             0xFFFF
+#define ID_CNT              0x10000
+
+#define OP_CNT              _LV_FS_IF_OP_LAST
+#define CREATE_CHUNK        4096
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+typedef struct {
+    uint8_t op;
+    uint8_t res;
+    char letter;
+    uint16_t id;
+    uint32_t delta_us;      /*Time since the start of the previous event*/
+    uint32_t time_us;       /*Duration on the device*/
+    uint32_t arg;
+    uint32_t ret;
+    char * path;            /*For open and dir_open, else NULL*/
+} event_t;
+
+typedef struct {
+    uint32_t cnt;
+    uint32_t err_cnt;       /*Not LV_FS_RES_OK*/
+    uint32_t diverged;      /*Other result or number of bytes than on the device*/
+    uint64_t sum_us;
+    uint32_t * lat;
+    uint32_t lat_size;
+} op_result_t;
+
+typedef struct {
+    uint8_t kind;           /*0: not open, 1: file, 2: directory*/
+    lv_fs_file_t file;
+    lv_fs_dir_t dir;
+} replay_handle_t;
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+static bool trace_load(const char * path);
+static void create_files(const char * dir);
+static void replay(const char * dir, bool realtime, op_result_t * res);
+static void replay_event(const char * dir, const event_t * e, op_result_t * res);
+static void make_path(char * buf, uint32_t size, const char * dir, const char * path);
+static void lat_add(op_result_t * r, uint32_t lat);
+static void print(const char * drive, op_result_t * res, bool json);
+static uint32_t percentile(op_result_t * r, uint32_t percent);
+static uint16_t get_u16(const uint8_t * p);
+static uint32_t get_u32(const uint8_t * p);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+static event_t * events;
+static uint32_t event_cnt;
+static uint32_t lost_cnt;
+static uint32_t nested_cnt;             /*Calls made by other calls, e.g. the block cache to its backend*/
+static uint32_t skip_cnt;               /*Calls of handles not opened in the replay*/
+static replay_handle_t * handles;       /*Indexed by the ID of the trace*/
+static uint8_t * buf;
+static uint32_t buf_size;
+
+static const char * const op_names[OP_CNT] = {
+    "open", "close", "read", "write", "seek", "tell", "dir_open", "dir_read", "dir_close"
+};
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+int main(int argc, char ** argv)
+{
+    bool json = false;
+    bool realtime = false;
+    bool create = false;
+    int first = 1;
+    while(first < argc && strncmp(argv[first], "--", 2) == 0) {
+        if(strcmp(argv[first], "--json") == 0) json = true;
+        else if(strcmp(argv[first], "--realtime") == 0) realtime = true;
+        else if(strcmp(argv[first], "--create") == 0) create = true;
+        else break;
+        first++;
+    }
+
+    if(first + 2 > argc) {
+        fprintf(stderr, "Usage: %s [--json] [--realtime] [--create] <trace> <drive:dir> [<drive:dir> ...]\n", argv[0]);
+        return 1;
+    }
+
+    if(!trace_load(argv[first])) return 1;
+
+    lv_init();
+
+#if LV_FS_IF_FATFS != '\0'
+    if(lv_fs_if_bench_ramdisk_mount(LV_FS_IF_BENCH_RAMDISK_SIZE) != 0) {
+        fprintf(stderr, "Couldn't create the FatFS RAM disk\n");
+        return 1;
+    }
+#endif
+
+    lv_fs_if_init();
+
+    handles = calloc(ID_CNT, sizeof(replay_handle_t));
+    buf = malloc(buf_size);
+    if(handles == NULL || buf == NULL) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    if(!json) {
+        printf("%u events", (unsigned)event_cnt);
+        if(nested_cnt) printf(" (and %u calls made by other drivers, not replayed)", (unsigned)nested_cnt);
+        if(lost_cnt) printf(", %u events were lost while recording, the replay is not exact", (unsigned)lost_cnt);
+        printf("\n%-6s %-10s %8s %6s %8s %8s %8s %8s %8s %9s\n",
+               "drive", "op", "calls", "errors", "diverged", "mean us", "p50 us", "p90 us", "p99 us", "max us");
+    }
+
+    /*The latencies of the device as a reference*/
+    op_result_t res[OP_CNT];
+    memset(res, 0, sizeof(res));
+    uint32_t i;
+    for(i = 0; i < event_cnt; i++) {
+        const event_t * e = &events[i];
+        if(e->op >= OP_CNT) continue;
+        res[e->op].cnt++;
+        if(e->res != LV_FS_RES_OK) res[e->op].err_cnt++;
+        res[e->op].sum_us += e->time_us;
+        lat_add(&res[e->op], e->time_us);
+    }
+    print("trace", res, json);
+
+    int a;
+    for(a = first + 1; a < argc; a++) {
+        const char * dir = argv[a];
+        if(create) create_files(dir);
+
+        memset(res, 0, sizeof(res));
+        skip_cnt = 0;
+        replay(dir, realtime, res);
+        char drive[2] = {dir[0], '\0'};
+        print(drive, res, json);
+        if(skip_cnt && !json) printf("%-6c %u calls skipped as their file couldn't be opened\n", dir[0], (unsigned)skip_cnt);
+    }
+
+    return 0;
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+/**
+ * Load the events of a trace file
+ * @param path path of the trace on the host
+ * @return true on success
+ */
+static bool trace_load(const char * path)
+{
+    FILE * f = fopen(path, "rb");
+    if(f == NULL) {
+        fprintf(stderr, "Couldn't open %s\n", path);
+        return false;
+    }
+
+    uint8_t hdr[TRACE_HEADER_SIZE];
+    if(fread(hdr, 1, TRACE_HEADER_SIZE, f) != TRACE_HEADER_SIZE || memcmp(hdr, TRACE_MAGIC, 4) != 0 ||
+       get_u16(hdr + 4) != TRACE_VERSION || get_u16(hdr + 6) != TRACE_REC_SIZE) {
+        fprintf(stderr, "%s is not a trace of LV_FS_IF_TRACE\n", path);
+        fclose(f);
+        return false;
+    }
+
+    /*Anything after `data_len` was written after the last flush or is left from an older trace*/
+    uint32_t data_len = get_u32(hdr + 8);
+    uint32_t cap = 0;
+    uint32_t ofs = 0;
+    uint32_t nested_us = 0;     /*Time from the start of the skipped events to the next one*/
+    buf_size = CREATE_CHUNK;
+    while(ofs + TRACE_REC_SIZE <= data_len) {
+        uint8_t rec[TRACE_REC_SIZE];
+        if(fread(rec, 1, TRACE_REC_SIZE, f) != TRACE_REC_SIZE) break;
+
+        if(event_cnt == cap) {
+            cap = cap ? cap * 2 : 1024;
+            events = realloc(events, cap * sizeof(event_t));
+            if(events == NULL) {
+                fprintf(stderr, "Out of memory\n");
+                fclose(f);
+                return false;
+            }
+        }
+
+        event_t * e = &events[event_cnt];
+        e->op = rec[0];
+        e->res = rec[1];
+        e->letter = rec[2];
+        e->id = get_u16(rec + 4);
+        e->delta_us = get_u32(rec + 8);
+        e->time_us = get_u32(rec + 12);
+        e->arg = get_u32(rec + 16);
+        e->ret = get_u32(rec + 20);
+        e->path = NULL;
+        ofs += TRACE_REC_SIZE;
+
+        uint32_t path_len = rec[3];
+        if(path_len) {
+            e->path = malloc(path_len + 1);
+            if(e->path == NULL || ofs + path_len > data_len || fread(e->path, 1, path_len, f) != path_len) break;
+            e->path[path_len] = '\0';
+            ofs += path_len;
+        }
+
+        if(e->op == TRACE_OP_LOST) {
+            lost_cnt += e->arg;
+            continue;
+        }
+
+        /*Replaying the outer call makes these calls again*/
+        if(get_u16(rec + 6) & TRACE_FLAG_NESTED) {
+            free(e->path);
+            nested_us += e->delta_us;
+            nested_cnt++;
+            continue;
+        }
+        e->delta_us += nested_us;
+        nested_us = 0;
+
+        if((e->op == LV_FS_IF_OP_READ || e->op == LV_FS_IF_OP_WRITE) && e->arg > buf_size) buf_size = e->arg;
+        event_cnt++;
+    }
+
+    lost_cnt = LV_MAX(lost_cnt, get_u32(hdr + 12));
+    fclose(f);
+    return true;
+}
+
+/**
+ * Create the files read in the trace, at least as large as the part read from them.
+ * The existing files are not changed. The directories must exist.
+ * @param dir the drive and directory of the replay
+ */
+static void create_files(const char * dir)
+{
+    uint32_t * pos = calloc(ID_CNT, sizeof(uint32_t));
+    const char ** id_path = calloc(ID_CNT, sizeof(char *));
+    uint32_t * need = calloc(event_cnt, sizeof(uint32_t));    /*Size needed by the file of an open event*/
+    uint32_t * id_open = calloc(ID_CNT, sizeof(uint32_t));    /*The open event of an ID*/
+    if(pos == NULL || id_path == NULL || need == NULL || id_open == NULL) goto out;
+
+    /*Follow the position of each file to find the largest offset read*/
+    uint32_t i;
+    for(i = 0; i < event_cnt; i++) {
+        const event_t * e = &events[i];
+        if(e->id == ID_NONE) continue;
+
+        uint32_t o = id_open[e->id];
+        switch(e->op) {
+        case LV_FS_IF_OP_OPEN:
+            id_path[e->id] = e->path;
+            id_open[e->id] = i;
+            pos[e->id] = 0;
+            break;
+        case LV_FS_IF_OP_READ:
+            pos[e->id] += e->ret;
+            break;
+        case LV_FS_IF_OP_SEEK:
+            if(e->ret == LV_FS_SEEK_SET) pos[e->id] = e->arg;
+            else if(e->ret == LV_FS_SEEK_CUR) pos[e->id] += e->arg;
+            else pos[e->id] = need[o] + e->arg;     /*The size is not known, approximate with the largest read*/
+            break;
+        case LV_FS_IF_OP_TELL:
+            pos[e->id] = e->ret;
+            break;
+        default:
+            continue;
+        }
+        if(id_path[e->id] && e->op != LV_FS_IF_OP_SEEK) need[id_open[e->id]] = LV_MAX(need[id_open[e->id]], pos[e->id]);
+    }
+
+    memset(buf, 0xA5, LV_MIN(buf_size, CREATE_CHUNK));
+    for(i = 0; i < event_cnt; i++) {
+        const event_t * e = &events[i];
+        if(e->op != LV_FS_IF_OP_OPEN || e->path == NULL || e->arg != LV_FS_MODE_RD || e->res != LV_FS_RES_OK) continue;
+
+        char path[512];
+        make_path(path, sizeof(path), dir, e->path);
+
+        lv_fs_file_t f;
+        if(lv_fs_open(&f, path, LV_FS_MODE_RD) == LV_FS_RES_OK) {
+            lv_fs_close(&f);
+            continue;
+        }
+
+        /*The largest part read by any open of the file*/
+        uint32_t size = 0;
+        uint32_t j;
+        for(j = i; j < event_cnt; j++) {
+            if(events[j].op == LV_FS_IF_OP_OPEN && events[j].path && strcmp(events[j].path, e->path) == 0) {
+                size = LV_MAX(size, need[j]);
+            }
+        }
+
+        if(lv_fs_open(&f, path, LV_FS_MODE_WR) != LV_FS_RES_OK) {
+            fprintf(stderr, "Couldn't create %s\n", path);
+            continue;
+        }
+
+        while(size) {
+            uint32_t bw = 0;
+            lv_fs_write(&f, buf, LV_MIN(size, CREATE_CHUNK), &bw);
+            if(bw == 0) break;
+            size -= bw;
+        }
+        lv_fs_close(&f);
+    }
+
+out:
+    free(pos);
+    free(id_path);
+    free(need);
+    free(id_open);
+}
+
+/**
+ * Execute the events of the trace on a drive
+ * @param dir the drive and directory the paths of the trace are mapped to
+ * @param realtime true: keep the gaps between the events of the trace
+ * @param res store the results here
+ */
+static void replay(const char * dir, bool realtime, op_result_t * res)
+{
+    uint64_t due_us = 0;
+    uint32_t last_us = lv_fs_if_time_us();
+
+    uint32_t i;
+    for(i = 0; i < event_cnt; i++) {
+        const event_t * e = &events[i];
+
+        /*The time stamps are 32 bit, so count the elapsed time in deltas*/
+        if(realtime) {
+            due_us += e->delta_us;
+            uint64_t now_us = 0;
+            while(1) {
+                uint32_t t = lv_fs_if_time_us();
+                now_us += t - last_us;
+                last_us = t;
+                if(now_us >= due_us) break;
+                usleep(LV_MIN(due_us - now_us, 100000));
+            }
+            due_us = now_us;
+        }
+
+        replay_event(dir, e, res);
+    }
+
+    /*Close what the trace left open*/
+    for(i = 0; i < ID_CNT; i++) {
+        if(handles[i].kind == 1) lv_fs_close(&handles[i].file);
+        else if(handles[i].kind == 2) lv_fs_dir_close(&handles[i].dir);
+        handles[i].kind = 0;
+    }
+}
+
+/**
+ * Execute one event and measure it
+ * @param dir the drive and directory the paths of the trace are mapped to
+ * @param e pointer to the event
+ * @param res store the result here
+ */
+static void replay_event(const char * dir, const event_t * e, op_result_t * res)
+{
+    if(e->op >= OP_CNT) return;
+
+    replay_handle_t * h = e->id != ID_NONE ? &handles[e->id] : NULL;
+    bool opening = e->op == LV_FS_IF_OP_OPEN || e->op == LV_FS_IF_OP_DIR_OPEN;
+    if(!opening && (h == NULL || h->kind == 0)) {
+        skip_cnt++;
+        return;
+    }
+
+    char path[512];
+    if(opening) make_path(path, sizeof(path), dir, e->path ? e->path : "");
+
+    /*The close was lost while recording*/
+    if(opening && h && h->kind == 1) lv_fs_close(&h->file);
+    else if(opening && h && h->kind == 2) lv_fs_dir_close(&h->dir);
+    if(h && opening) h->kind = 0;
+
+    lv_fs_res_t r = LV_FS_RES_OK;
+    uint32_t n = 0;
+    char fn[LV_FS_IF_DIRENT_NAME_MAX + 1];     /*Directories get a '/' prefix*/
+    lv_fs_file_t tmp_file;
+    lv_fs_dir_t tmp_dir;
+
+    uint32_t t = lv_fs_if_time_us();
+    switch(e->op) {
+    case LV_FS_IF_OP_OPEN:
+        r = lv_fs_open(h ? &h->file : &tmp_file, path, e->arg);
+        break;
+    case LV_FS_IF_OP_CLOSE:
+        r = lv_fs_close(&h->file);
+        break;
+    case LV_FS_IF_OP_READ:
+        r = lv_fs_read(&h->file, buf, e->arg, &n);
+        break;
+    case LV_FS_IF_OP_WRITE:
+        r = lv_fs_write(&h->file, buf, e->arg, &n);
+        break;
+    case LV_FS_IF_OP_SEEK:
+        r = lv_fs_seek(&h->file, e->arg, e->ret);
+        break;
+    case LV_FS_IF_OP_TELL:
+        r = lv_fs_tell(&h->file, &n);
+        break;
+    case LV_FS_IF_OP_DIR_OPEN:
+        r = lv_fs_dir_open(h ? &h->dir : &tmp_dir, path);
+        break;
+    case LV_FS_IF_OP_DIR_READ:
+        r = lv_fs_dir_read(&h->dir, fn);
+        break;
+    case LV_FS_IF_OP_DIR_CLOSE:
+        r = lv_fs_dir_close(&h->dir);
+        break;
+    }
+    t = lv_fs_if_time_us() - t;
+
+    op_result_t * o = &res[e->op];
+    o->cnt++;
+    o->sum_us += t;
+    lat_add(o, t);
+    if(r != LV_FS_RES_OK) o->err_cnt++;
+
+    bool diverged = (r == LV_FS_RES_OK) != (e->res == LV_FS_RES_OK);
+    if(e->op == LV_FS_IF_OP_READ || e->op == LV_FS_IF_OP_WRITE || e->op == LV_FS_IF_OP_TELL) {
+        if(n != e->ret) diverged = true;
+    }
+    if(diverged) o->diverged++;
+
+    switch(e->op) {
+    case LV_FS_IF_OP_OPEN:
+    case LV_FS_IF_OP_DIR_OPEN:
+        if(r != LV_FS_RES_OK) break;
+        if(h == NULL) {
+            /*Failed on the device or had no ID: nothing refers to it*/
+            if(e->op == LV_FS_IF_OP_OPEN) lv_fs_close(&tmp_file);
+            else lv_fs_dir_close(&tmp_dir);
+        }
+        else {
+            h->kind = e->op == LV_FS_IF_OP_OPEN ? 1 : 2;
+        }
+        break;
+    case LV_FS_IF_OP_CLOSE:
+    case LV_FS_IF_OP_DIR_CLOSE:
+        h->kind = 0;
+        break;
+    }
+}
+
+/**
+ * Map a path of the trace to the drive and directory of the replay
+ */
+static void make_path(char * buf, uint32_t size, const char * dir, const char * path)
+{
+    lv_snprintf(buf, size, "%s%s%s", dir, path[0] == '/' ? "" : "/", path);
+}
+
+static void lat_add(op_result_t * r, uint32_t lat)
+{
+    if(r->cnt > r->lat_size) {
+        r->lat_size = r->lat_size ? r->lat_size * 2 : 256;
+        r->lat = realloc(r->lat, r->lat_size * sizeof(uint32_t));
+    }
+    if(r->lat) r->lat[r->cnt - 1] = lat;
+}
+
+/**
+ * Print the results of the operations and free their samples
+ */
+static void print(const char * drive, op_result_t * res, bool json)
+{
+    uint32_t op;
+    for(op = 0; op < OP_CNT; op++) {
+        op_result_t * r = &res[op];
+        if(r->cnt == 0) continue;
+
+        double mean = (double)r->sum_us / r->cnt;
+        uint32_t p50 = percentile(r, 50);
+        uint32_t p90 = percentile(r, 90);
+        uint32_t p99 = percentile(r, 99);
+        uint32_t max = percentile(r, 100);
+
+        if(json) {
+            printf("{\"drive\":\"%s\",\"op\":\"%s\",\"calls\":%u,\"errors\":%u,\"diverged\":%u,\"mean_us\":%.1f,"
+                   "\"p50_us\":%u,\"p90_us\":%u,\"p99_us\":%u,\"max_us\":%u}\n",
+                   drive, op_names[op], (unsigned)r->cnt, (unsigned)r->err_cnt, (unsigned)r->diverged, mean,
+                   (unsigned)p50, (unsigned)p90, (unsigned)p99, (unsigned)max);
+        }
+        else {
+            printf("%-6s %-10s %8u %6u %8u %8.1f %8u %8u %8u %9u\n",
+                   drive, op_names[op], (unsigned)r->cnt, (unsigned)r->err_cnt, (unsigned)r->diverged, mean,
+                   (unsigned)p50, (unsigned)p90, (unsigned)p99, (unsigned)max);
+        }
+
+        free(r->lat);
+        r->lat = NULL;
+    }
+}
+
+static int cmp_u32(const void * a, const void * b)
+{
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static uint32_t percentile(op_result_t * r, uint32_t percent)
+{
+    if(r->cnt == 0 || r->lat == NULL) return 0;
+
+    qsort(r->lat, r->cnt, sizeof(uint32_t), cmp_u32);
+    uint32_t idx = (r->cnt * percent + 99) / 100;
+    return r->lat[idx ? idx - 1 : 0];
+}
+
+static uint16_t get_u16(const uint8_t * p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+static uint32_t get_u32(const uint8_t * p)
+{
+    return get_u16(p) | ((uint32_t)get_u16(p + 2) << 16);
+}